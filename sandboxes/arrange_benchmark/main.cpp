@@ -0,0 +1,96 @@
+// Measures arrangement of copies of the printer parts of the libnest2d tests by the NFP placer,
+// with the four rotations evaluated serially or in parallel, then by arrangement::arrange()
+// with the NFP and the raster engines.
+// Usage: arrange_benchmark [number of copies of each part]
+
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+
+#include <libnest2d/libnest2d.hpp>
+
+#include "libslic3r/Arrange.hpp"
+
+#include "printer_parts.hpp"
+#include "libnest2d/tools/benchmark.h"
+
+using namespace libnest2d;
+
+static std::vector<Item> printer_parts(size_t copies)
+{
+    std::vector<Item> items;
+    items.reserve(PRINTER_PART_POLYGONS.size() * copies);
+    for (size_t i = 0; i < copies; ++ i)
+        for (const PathImpl &part : PRINTER_PART_POLYGONS) {
+            PathImpl path = part;
+            if (ClosureTypeV<PathImpl> == Closure::OPEN)
+                path.points.pop_back();
+            if constexpr (! is_clockwise<PathImpl>())
+                std::reverse(path.begin(), path.end());
+            items.emplace_back(path);
+        }
+    return items;
+}
+
+static Slic3r::arrangement::ArrangePolygons printer_part_arrange_polygons(size_t copies)
+{
+    Slic3r::arrangement::ArrangePolygons items;
+    items.reserve(PRINTER_PART_POLYGONS.size() * copies);
+    for (size_t i = 0; i < copies; ++ i)
+        for (const PathImpl &part : PRINTER_PART_POLYGONS) {
+            Slic3r::arrangement::ArrangePolygon ap;
+            ap.poly.contour = part;
+            ap.poly.contour.make_counter_clockwise();
+            items.emplace_back(std::move(ap));
+        }
+    return items;
+}
+
+int main(int argc, char **argv)
+{
+    const size_t copies = argc > 1 ? size_t(std::atoll(argv[1])) : 3;
+    const Box    bin(250000000, 210000000);
+
+    for (bool parallel : { false, true }) {
+        std::vector<Item> items = printer_parts(copies);
+
+        NfpPlacer::Config pcfg;
+        pcfg.rotations = { 0., Pi / 2., Pi, 3. * Pi / 2. };
+        pcfg.parallel  = parallel;
+
+        Benchmark bench;
+        bench.start();
+        size_t bins = nest(items, bin, 1000000, NestConfig<NfpPlacer, FirstFitSelection>(pcfg));
+        bench.stop();
+
+        // Sum of the positions, for comparing the arrangements.
+        double checksum = 0.;
+        for (const Item &item : items)
+            checksum += double(getX(item.translation())) + double(getY(item.translation())) + item.rotation();
+
+        std::cout << items.size() << " items " << (parallel ? "in parallel" : "serially") << ": "
+                  << bench.getElapsedSec() << " s, " << bins << " bins, checksum " << checksum << std::endl;
+    }
+
+    for (Slic3r::arrangement::ArrangeEngine engine : { Slic3r::arrangement::ArrangeEngine::NFP, Slic3r::arrangement::ArrangeEngine::Raster }) {
+        Slic3r::arrangement::ArrangePolygons items = printer_part_arrange_polygons(copies);
+
+        Slic3r::arrangement::ArrangeParams params(1000000);
+        params.allow_rotations = true;
+        params.engine          = engine;
+
+        Benchmark bench;
+        bench.start();
+        Slic3r::arrangement::arrange(items, Slic3r::BoundingBox({ 0, 0 }, { 250000000, 210000000 }), params);
+        bench.stop();
+
+        int beds = 0;
+        for (const Slic3r::arrangement::ArrangePolygon &item : items)
+            beds = std::max(beds, item.bed_idx + 1);
+
+        std::cout << items.size() << " items by the " << (engine == Slic3r::arrangement::ArrangeEngine::NFP ? "NFP" : "raster")
+                  << " engine: " << bench.getElapsedSec() << " s, " << beds << " beds" << std::endl;
+    }
+
+    return 0;
+}
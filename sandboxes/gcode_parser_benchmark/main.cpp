@@ -0,0 +1,120 @@
+// Measures throughput of parsing G-code files by GCodeReader and GCodeProcessor
+// and of preparing the toolpaths of the parsed G-code for the preview.
+// Usage: gcode_parser_benchmark [file.gcode ...]
+// Without arguments, a synthetic G-code of about 200MB is generated into a temporary file.
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+#include "libslic3r/GCodeReader.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+#include "libslic3r/GCode/ToolpathLayers.hpp"
+#include "libslic3r/LocalesUtils.hpp"
+
+#include "libnest2d/tools/benchmark.h"
+
+using namespace Slic3r;
+
+static std::string generate_gcode(size_t size)
+{
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.gcode");
+    FILE *f = boost::nowide::fopen(path.string().c_str(), "wb");
+    std::string line;
+    size_t      written = 0;
+    for (size_t i = 0; written < size; ++ i) {
+        if (i % 5000 == 0)
+            line = ";LAYER_CHANGE\n;Z:" + std::to_string(0.2 * double(i / 5000 + 1)) + "\nG1 Z" + std::to_string(0.2 * double(i / 5000 + 1)) + " F720\n;TYPE:Perimeter\n;WIDTH:0.45\n";
+        else
+            line.clear();
+        line += "G1 X" + std::to_string(100. + double(i % 1000) * 0.013) + " Y" + std::to_string(100. + double(i % 777) * 0.017) + " E0.0" + std::to_string(1000 + i % 8000) + "\n";
+        ::fwrite(line.data(), 1, line.size(), f);
+        written += line.size();
+    }
+    ::fclose(f);
+    return path.string();
+}
+
+int main(int argc, char **argv)
+{
+    CNumericLocalesSetter locales_setter;
+
+    std::vector<std::string> files;
+    bool                     remove_files = argc < 2;
+    for (int i = 1; i < argc; ++ i)
+        files.emplace_back(argv[i]);
+    if (files.empty())
+        files.emplace_back(generate_gcode(200 * 1024 * 1024));
+
+    Benchmark bench;
+    for (const std::string &file : files) {
+        const double size_mb = double(boost::filesystem::file_size(file)) / (1024. * 1024.);
+        std::cout << file << " (" << size_mb << " MB)" << std::endl;
+
+        auto report = [&bench, size_mb](const char *name, size_t num_lines) {
+            std::cout << "  " << name << ": " << bench.getElapsedSec() << " s, " << size_mb / bench.getElapsedSec() << " MB/s, " << num_lines << " lines" << std::endl;
+        };
+
+        // Single threaded tokenization of lines as read by GCodeReader::parse_file_raw().
+        {
+            size_t num_lines = 0;
+            GCodeReader reader;
+            GCodeReader::GCodeLine gline;
+            auto callback = [&num_lines](GCodeReader&, const GCodeReader::GCodeLine&) { ++ num_lines; };
+            bench.start();
+            reader.parse_file_raw(file, [&gline, &callback](GCodeReader &reader, const char *begin, const char *end) {
+                gline.reset();
+                reader.parse_line(begin, end, gline, callback);
+            });
+            bench.stop();
+            report("GCodeReader sequential", num_lines);
+        }
+
+        // Tokenization in parallel, callbacks sequential.
+        {
+            size_t num_lines = 0;
+            std::vector<size_t> lines_ends;
+            GCodeReader reader;
+            bench.start();
+            reader.parse_file(file, [&num_lines](GCodeReader&, const GCodeReader::GCodeLine&) { ++ num_lines; }, lines_ends);
+            bench.stop();
+            report("GCodeReader::parse_file", num_lines);
+        }
+
+        // Full processing as done by the G-code viewer.
+        {
+            GCodeProcessor processor;
+            bench.start();
+            processor.process_file(file);
+            bench.stop();
+            report("GCodeProcessor::process_file", processor.get_result().lines_ends.size());
+
+            // Preparation of the toolpaths for the preview, without OpenGL.
+            const GCodeProcessorResult &result = processor.get_result();
+            bench.start();
+            ToolpathLayers layers = toolpath_layers(result);
+            bench.stop();
+            std::cout << "  toolpath_layers: " << bench.getElapsedSec() << " s, " << layers.size() << " layers, " << result.moves.size() << " moves" << std::endl;
+
+            // Vertex data of ranges of 10 layers, as built on demand while browsing the preview, at each level of detail.
+            for (unsigned int lod = 0; lod <= TOOLPATH_LOD_MAX; ++ lod) {
+                size_t num_segments = 0;
+                bench.start();
+                for (size_t first_layer = 0; first_layer < layers.size(); first_layer += 10)
+                    num_segments += build_toolpath_range(result.moves, layers, first_layer, std::min(first_layer + 9, layers.size() - 1), lod).num_segments();
+                bench.stop();
+                std::cout << "  build_toolpath_range, level of detail " << lod << ": " << bench.getElapsedSec() << " s, " << num_segments << " segments" << std::endl;
+            }
+        }
+    }
+
+    if (remove_files)
+        for (const std::string &file : files)
+            boost::nowide::remove(file.c_str());
+
+    return 0;
+}
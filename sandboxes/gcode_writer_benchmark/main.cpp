@@ -0,0 +1,87 @@
+// Measures throughput of emitting G-code by GCodeWriter: the methods returning a string per G-code line
+// versus the methods appending into a buffer provided by the caller.
+// Usage: gcode_writer_benchmark [number of lines]
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+
+#include "libslic3r/GCodeWriter.hpp"
+#include "libslic3r/LocalesUtils.hpp"
+
+#include "libnest2d/tools/benchmark.h"
+
+using namespace Slic3r;
+
+static void setup_writer(GCodeWriter &writer)
+{
+    writer.set_extruders({ 0 });
+    writer.set_extruder(0);
+}
+
+static Vec2d point(size_t i)
+{
+    return { 100. + 50. * std::cos(0.001 * double(i)), 100. + 50. * std::sin(0.001 * double(i)) };
+}
+
+int main(int argc, char **argv)
+{
+    CNumericLocalesSetter locales_setter;
+
+    const size_t num_lines = argc > 1 ? size_t(std::atoll(argv[1])) : 10000000;
+    const std::string comment;
+    const std::string cooling_marker = ";_EXTRUDE_SET_SPEED";
+
+    Benchmark bench;
+    auto report = [&bench](const char *name, size_t num_bytes) {
+        std::cout << name << ": " << bench.getElapsedSec() << " s, " << double(num_bytes) / (1024. * 1024. * bench.getElapsedSec()) << " MB/s" << std::endl;
+    };
+
+    // A string allocated per G-code line, then concatenated, as done by GCode::_extrude() before.
+    size_t size_returning = 0;
+    {
+        GCodeWriter writer;
+        setup_writer(writer);
+        std::string gcode;
+        bench.start();
+        for (size_t i = 0; i < num_lines; ++ i) {
+            if (i % 100 == 0) {
+                size_returning += gcode.size();
+                gcode.clear();
+                gcode += writer.set_speed(2400., comment, cooling_marker);
+            }
+            gcode += writer.extrude_to_xy(point(i), 0.01, comment);
+        }
+        size_returning += gcode.size();
+        bench.stop();
+        report("GCodeWriter returning strings", size_returning);
+    }
+
+    // Appended into the output buffer.
+    size_t size_appending = 0;
+    {
+        GCodeWriter writer;
+        setup_writer(writer);
+        std::string gcode;
+        bench.start();
+        for (size_t i = 0; i < num_lines; ++ i) {
+            if (i % 100 == 0) {
+                size_appending += gcode.size();
+                gcode.clear();
+                writer.set_speed(gcode, 2400., comment, cooling_marker);
+            }
+            writer.extrude_to_xy(gcode, point(i), 0.01, comment);
+        }
+        size_appending += gcode.size();
+        bench.stop();
+        report("GCodeWriter appending", size_appending);
+    }
+
+    if (size_returning != size_appending) {
+        std::cerr << "Output size mismatch" << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Measures rasterization of the SLA layers without anti-aliasing on 8K and 12K displays:
+// RasterGrayscaleAA with a thresholding gamma versus RasterGrayscaleBinary,
+// then the encoding time and size of the rasterized layer per encoder.
+// Usage: sla_raster_benchmark [number of layers]
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include "libslic3r/SLA/AGGRaster.hpp"
+#include "libslic3r/Format/AnycubicSLA.hpp"
+
+#include "libnest2d/tools/benchmark.h"
+
+using namespace Slic3r;
+
+// A grid of circular pillars around a large square with a hole.
+static ExPolygons layer_polygons(double disp_w, double disp_h)
+{
+    ExPolygons out;
+    for (int i = 0; i < 40; ++ i)
+        for (int j = 0; j < 20; ++ j) {
+            Polygon circle;
+            for (double a = 0.; a < 2. * PI; a += 2. * PI / 64.)
+                circle.points.emplace_back(scaled(disp_w * (0.05 + 0.0225 * i) + 2. * std::cos(a)),
+                                           scaled(disp_h * (0.05 + 0.045 * j) + 2. * std::sin(a)));
+            out.emplace_back(circle);
+        }
+    const coord_t cx = scaled(disp_w / 2.), cy = scaled(disp_h / 2.), r = scaled(disp_h / 4.);
+    ExPolygon square;
+    square.contour.points = { { cx - r, cy - r }, { cx + r, cy - r }, { cx + r, cy + r }, { cx - r, cy + r } };
+    square.holes.emplace_back();
+    square.holes.front().points = { { cx - r / 2, cy + r / 2 }, { cx + r / 2, cy + r / 2 }, { cx + r / 2, cy - r / 2 }, { cx - r / 2, cy - r / 2 } };
+    out.emplace_back(std::move(square));
+    return out;
+}
+
+// Exposes the run-length encoder of the Anycubic formats.
+class AnycubicEncoder : public AnycubicSLAArchive {
+public:
+    AnycubicEncoder() : AnycubicSLAArchive(SLAPrinterConfig{}) {}
+    using AnycubicSLAArchive::get_encoder;
+};
+
+template<class Raster> static double rasterize(Raster &raster, const ExPolygons &polygons, size_t num_layers)
+{
+    Benchmark bench;
+    bench.start();
+    for (size_t i = 0; i < num_layers; ++ i) {
+        raster.clear();
+        for (const ExPolygon &poly : polygons)
+            raster.draw(poly);
+    }
+    bench.stop();
+    return bench.getElapsedSec();
+}
+
+int main(int argc, char **argv)
+{
+    const size_t num_layers = argc > 1 ? size_t(std::atoll(argv[1])) : 20;
+    const double disp_w = 218., disp_h = 123.;
+
+    for (const sla::Resolution &res : { sla::Resolution{ 7680, 4320 }, sla::Resolution{ 11520, 5120 } }) {
+        const sla::PixelDim pxdim{ disp_w / res.width_px, disp_h / res.height_px };
+        const ExPolygons    polygons = layer_polygons(disp_w, disp_h);
+
+        sla::RasterGrayscaleAA     raster_aa(res, pxdim, {}, agg::gamma_threshold(.5));
+        sla::RasterGrayscaleBinary raster_binary(res, pxdim, {});
+        const double time_aa     = rasterize(raster_aa, polygons, num_layers);
+        const double time_binary = rasterize(raster_binary, polygons, num_layers);
+
+        size_t differ = 0;
+        for (size_t row = 0; row < res.height_px; ++ row)
+            for (size_t col = 0; col < res.width_px; ++ col)
+                differ += raster_aa.read_pixel(col, row) != raster_binary.read_pixel(col, row);
+
+        std::cout << res.width_px << "x" << res.height_px << ": RasterGrayscaleAA " << 1000. * time_aa / num_layers
+                  << " ms/layer, RasterGrayscaleBinary " << 1000. * time_binary / num_layers << " ms/layer" << std::endl;
+        if (differ != 0) {
+            std::cerr << differ << " pixels differ" << std::endl;
+            return -1;
+        }
+
+        const std::pair<const char*, sla::RasterEncoder> encoders[] = {
+            { "PNG", sla::PNGRasterEncoder{} },
+            { "PNG fastest deflate", sla::PNGRasterEncoder{ 1 } },
+            { "Anycubic RLE", AnycubicEncoder().get_encoder() },
+        };
+        for (const auto &[name, encoder] : encoders) {
+            Benchmark bench;
+            size_t    size = 0;
+            bench.start();
+            for (size_t i = 0; i < num_layers; ++ i)
+                size = raster_binary.encode(encoder).size();
+            bench.stop();
+            std::cout << "    " << name << ": " << 1000. * bench.getElapsedSec() / num_layers << " ms/layer, " << size << " bytes" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,393 @@
+// Slicing benchmark suite.
+//
+// Runs a fixed corpus of models from tests/data, their scaled up and tiled variants and tall variants with organic supports
+// through all the steps of Print / PrintObject and SLAPrint / SLAPrintObject. Reports wall time, CPU time, allocation count
+// and peak resident memory per step as JSON and optionally compares the wall times against a stored baseline.
+//
+// Usage: slicer_benchmarks [--output results.json] [--baseline baseline.json] [--threshold 10] [--filter name] [--repeat N]
+//
+// The steps of multiple PrintObjects run in parallel, therefore CPU time and allocations measured between start and end
+// of a step include the work of the steps running concurrently. Only allocations through the C++ operator new
+// are counted, allocations by tbb::scalable_allocator (Points) are not. The perimeters and fills are placed into
+// an ExtrusionEntityArena per layer, they are counted once per arena block.
+// Returns 1 if a regression against the baseline was detected, 2 on error.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/ModelArrange.hpp"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/SLAPrint.hpp"
+
+static std::atomic<size_t> g_num_allocations { 0 };
+
+void* operator new(size_t size)
+{
+    ++ g_num_allocations;
+    if (void *ptr = std::malloc(size == 0 ? 1 : size); ptr != nullptr)
+        return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return ::operator new(size); }
+void  operator delete(void *ptr) noexcept { std::free(ptr); }
+void  operator delete[](void *ptr) noexcept { std::free(ptr); }
+void  operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void  operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+
+using namespace Slic3r;
+
+namespace {
+
+double cpu_time_s()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (! GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.;
+    auto to_s = [](const FILETIME &t) { return double((uint64_t(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7; };
+    return to_s(kernel) + to_s(user);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+double peak_rss_mb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (! GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0.;
+    return double(pmc.PeakWorkingSetSize) / (1024. * 1024.);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+    // bytes on macOS
+    return double(usage.ru_maxrss) / (1024. * 1024.);
+    #else
+    // kilobytes on Linux
+    return double(usage.ru_maxrss) / 1024.;
+    #endif
+#endif
+}
+
+struct Snapshot
+{
+    std::chrono::steady_clock::time_point wall;
+    double                                cpu;
+    size_t                                allocations;
+
+    static Snapshot now() { return { std::chrono::steady_clock::now(), cpu_time_s(), g_num_allocations.load(std::memory_order_relaxed) }; }
+};
+
+struct StepStats
+{
+    size_t count       { 0 };
+    double wall_s      { 0. };
+    double cpu_s       { 0. };
+    size_t allocations { 0 };
+    double peak_rss_mb { 0. };
+};
+
+struct BenchmarkResult
+{
+    std::string                      name;
+    double                           wall_s { 0. };
+    // Ordered by the name of the step.
+    std::map<std::string, StepStats> steps;
+};
+
+// Collects the step timings reported by PrintBase::set_step_callback(), which is called from multiple threads.
+class StepRecorder
+{
+public:
+    StepRecorder(const std::vector<const char*> &print_step_names, const std::vector<const char*> &object_step_names) :
+        m_print_step_names(print_step_names), m_object_step_names(object_step_names) {}
+
+    void operator()(const PrintObjectBase *print_object, int step, bool done) {
+        Snapshot now = Snapshot::now();
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        auto key = std::make_pair(print_object, step);
+        if (! done) {
+            m_started[key] = now;
+            return;
+        }
+        auto it = m_started.find(key);
+        if (it == m_started.end())
+            return;
+        StepStats &stats = m_steps[print_object ? m_object_step_names[step] : m_print_step_names[step]];
+        ++ stats.count;
+        stats.wall_s      += std::chrono::duration<double>(now.wall - it->second.wall).count();
+        stats.cpu_s       += now.cpu - it->second.cpu;
+        stats.allocations += now.allocations - it->second.allocations;
+        stats.peak_rss_mb  = std::max(stats.peak_rss_mb, peak_rss_mb());
+        m_started.erase(it);
+    }
+
+    std::map<std::string, StepStats> steps() const { return m_steps; }
+
+private:
+    std::vector<const char*>                                     m_print_step_names;
+    std::vector<const char*>                                     m_object_step_names;
+    std::mutex                                                   m_mutex;
+    std::map<std::pair<const PrintObjectBase*, int>, Snapshot>   m_started;
+    std::map<std::string, StepStats>                             m_steps;
+};
+
+const std::vector<const char*> fff_print_steps  { "psWipeTower", "psAlertWhenSupportsNeeded", "psSkirtBrim", "psGCodeExport" };
+const std::vector<const char*> fff_object_steps { "posSlice", "posPerimeters", "posPrepareInfill", "posInfill", "posIroning", 
+                                                  "posSupportSpotsSearch", "posSupportMaterial", "posEstimateCurledExtrusions" };
+const std::vector<const char*> sla_print_steps  { "slapsMergeSlicesAndEval", "slapsRasterize" };
+const std::vector<const char*> sla_object_steps { "slaposAssembly", "slaposHollowing", "slaposDrillHoles", "slaposObjectSlice",
+                                                  "slaposSupportPoints", "slaposSupportTree", "slaposPad", "slaposSliceSupports" };
+
+struct CorpusEntry
+{
+    std::string model;
+    double      scale;
+    size_t      copies;
+    bool        sla;
+    // Scale in Z on top of scale, to produce tall objects.
+    double      stretch_z       { 1. };
+    // FFF only: Organic tree supports instead of the default snug supports.
+    bool        organic_support { false };
+
+    std::string name() const {
+        return std::string(sla ? "sla/" : "fff/") + model + (scale != 1. ? "/scaled_x" + std::to_string(int(scale)) : std::string()) + 
+            (stretch_z != 1. ? "/stretched_z" + std::to_string(int(stretch_z)) : std::string()) +
+            (copies > 1 ? "/tiled_" + std::to_string(copies) : std::string()) + (organic_support ? "/organic" : "");
+    }
+};
+
+std::vector<CorpusEntry> corpus()
+{
+    std::vector<CorpusEntry> out;
+    for (const char *model : { "20mm_cube", "overhang", "bridge", "extruder_idler", "ipadstand", "frog_legs", "sloping_hole", "cube_with_hole" })
+        out.push_back({ model, 1., 1, false });
+    for (const char *model : { "20mm_cube", "extruder_idler", "frog_legs" }) {
+        out.push_back({ model, 2., 1, false });
+        out.push_back({ model, 1., 4, false });
+    }
+    // Tall models with organic supports, stressing the concurrent caches of TreeModelVolumes.
+    for (const char *model : { "overhang", "frog_legs" })
+        out.push_back({ model, 1., 1, false, 5., true });
+    for (const char *model : { "20mm_cube", "extruder_idler", "pyramid" })
+        out.push_back({ model, 1., 1, true });
+    out.push_back({ "extruder_idler", 1., 4, true });
+    return out;
+}
+
+Model load_model(const CorpusEntry &entry, const Vec2d &bed_center, double min_obj_distance)
+{
+    Model model = Model::read_from_file(std::string(TEST_DATA_DIR) + "/" + entry.model + ".obj");
+    for (ModelObject *object : model.objects) {
+        if (entry.scale != 1.)
+            object->scale(entry.scale);
+        if (entry.stretch_z != 1.)
+            object->scale(Vec3d(1., 1., entry.stretch_z));
+        object->ensure_on_bed();
+    }
+    ArrangeParams params { scaled(min_obj_distance) };
+    if (entry.copies > 1)
+        duplicate_objects(model, entry.copies, InfiniteBed{ scaled(bed_center) }, params);
+    else
+        arrange_objects(model, InfiniteBed{ scaled(bed_center) }, params);
+    return model;
+}
+
+BenchmarkResult run_fff(const CorpusEntry &entry)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_key_value("support_material", new ConfigOptionBool(true));
+    config.set_key_value("perimeters", new ConfigOptionInt(3));
+    config.set_key_value("fill_density", new ConfigOptionPercent(20));
+    config.set_key_value("skirts", new ConfigOptionInt(1));
+    if (entry.organic_support)
+        config.set_key_value("support_material_style", new ConfigOptionEnum<SupportMaterialStyle>(smsOrganic));
+
+    Model model = load_model(entry, Vec2d(100., 100.), min_object_distance(config));
+    Print print;
+    for (ModelObject *object : model.objects)
+        print.auto_assign_extruders(object);
+    StepRecorder recorder(fff_print_steps, fff_object_steps);
+    print.set_status_silent();
+    print.set_step_callback([&recorder](const PrintObjectBase *print_object, int step, bool done) { recorder(print_object, step, done); });
+    print.apply(model, config);
+
+    boost::filesystem::path gcode_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.gcode");
+    auto start = std::chrono::steady_clock::now();
+    print.process();
+    print.export_gcode(gcode_path.string(), nullptr, nullptr);
+    BenchmarkResult result { entry.name(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), recorder.steps() };
+    boost::nowide::remove(gcode_path.string().c_str());
+    return result;
+}
+
+BenchmarkResult run_sla(const CorpusEntry &entry)
+{
+    SLAFullPrintConfig sla_config;
+    sla_config.printer_technology.value = ptSLA;
+    const double w = sla_config.display_width.getFloat();
+    const double h = sla_config.display_height.getFloat();
+    sla_config.bed_shape.values = { Vec2d(0, 0), Vec2d(w, 0), Vec2d(w, h), Vec2d(0, h) };
+    DynamicPrintConfig config;
+    config.apply(sla_config);
+
+    Model model = load_model(entry, Vec2d(w / 2., h / 2.), min_object_distance(config));
+    SLAPrint print;
+    StepRecorder recorder(sla_print_steps, sla_object_steps);
+    print.set_status_callback([](const PrintBase::SlicingStatus&) {});
+    print.set_step_callback([&recorder](const PrintObjectBase *print_object, int step, bool done) { recorder(print_object, step, done); });
+    print.apply(model, config);
+
+    auto start = std::chrono::steady_clock::now();
+    print.process();
+    return { entry.name(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), recorder.steps() };
+}
+
+void write_json(std::ostream &os, const std::vector<BenchmarkResult> &results)
+{
+    os << std::setprecision(6) << "{\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++ i) {
+        const BenchmarkResult &r = results[i];
+        os << (i == 0 ? "" : ",") << "\n    {\n      \"name\": \"" << r.name << "\",\n      \"wall_s\": " << r.wall_s << ",\n      \"steps\": {";
+        bool first = true;
+        for (const auto &[name, stats] : r.steps) {
+            os << (first ? "" : ",") << "\n        \"" << name << "\": { \"count\": " << stats.count << ", \"wall_s\": " << stats.wall_s << 
+                ", \"cpu_s\": " << stats.cpu_s << ", \"allocations\": " << stats.allocations << ", \"peak_rss_mb\": " << stats.peak_rss_mb << " }";
+            first = false;
+        }
+        os << "\n      }\n    }";
+    }
+    os << "\n  ]\n}\n";
+}
+
+// Compare wall times against a baseline. Differences below min_diff_s are considered noise.
+bool compare_with_baseline(const std::vector<BenchmarkResult> &results, const std::string &baseline_path, double threshold_percent)
+{
+    static constexpr const double min_diff_s = 0.02;
+    boost::property_tree::ptree baseline;
+    boost::property_tree::read_json(baseline_path, baseline);
+
+    std::map<std::string, const boost::property_tree::ptree*> baseline_benchmarks;
+    for (const auto &item : baseline.get_child("benchmarks"))
+        baseline_benchmarks[item.second.get<std::string>("name")] = &item.second;
+
+    bool regression = false;
+    auto check = [threshold_percent, &regression](const std::string &name, double base, double current) {
+        const double change = base > 0. ? 100. * (current - base) / base : 0.;
+        const bool   slower = change > threshold_percent && current - base > min_diff_s;
+        regression |= slower;
+        std::cout << std::left << std::setw(64) << name << std::right << std::fixed << std::setprecision(3) << std::setw(10) << base << std::setw(10) << current << 
+            std::setw(9) << std::setprecision(1) << change << "%" << (slower ? "  REGRESSION" : "") << std::endl;
+    };
+
+    std::cout << std::left << std::setw(64) << "benchmark / step" << std::right << std::setw(10) << "base [s]" << std::setw(10) << "now [s]" << std::setw(10) << "change" << std::endl;
+    for (const BenchmarkResult &r : results) {
+        auto it = baseline_benchmarks.find(r.name);
+        if (it == baseline_benchmarks.end()) {
+            std::cout << r.name << ": not in the baseline" << std::endl;
+            continue;
+        }
+        check(r.name, it->second->get<double>("wall_s"), r.wall_s);
+        for (const auto &[step_name, stats] : r.steps)
+            if (auto base_step = it->second->get_child_optional(boost::property_tree::ptree::path_type("steps/" + step_name, '/')); base_step)
+                check("    " + step_name, base_step->get<double>("wall_s"), stats.wall_s);
+    }
+    return regression;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string output_path;
+    std::string baseline_path;
+    std::string filter;
+    double      threshold_percent = 10.;
+    int         repeat            = 1;
+    for (int i = 1; i < argc; ++ i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--output")
+            output_path = argv[++ i];
+        else if (i + 1 < argc && arg == "--baseline")
+            baseline_path = argv[++ i];
+        else if (i + 1 < argc && arg == "--filter")
+            filter = argv[++ i];
+        else if (i + 1 < argc && arg == "--threshold")
+            threshold_percent = std::atof(argv[++ i]);
+        else if (i + 1 < argc && arg == "--repeat")
+            repeat = std::max(1, std::atoi(argv[++ i]));
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--output results.json] [--baseline baseline.json] [--threshold percent] [--filter name] [--repeat N]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<BenchmarkResult> results;
+    try {
+        for (const CorpusEntry &entry : corpus()) {
+            if (! filter.empty() && entry.name().find(filter) == std::string::npos)
+                continue;
+            // Keep the fastest run of the repeated ones.
+            BenchmarkResult best;
+            for (int i = 0; i < repeat; ++ i) {
+                BenchmarkResult result = entry.sla ? run_sla(entry) : run_fff(entry);
+                if (i == 0 || result.wall_s < best.wall_s)
+                    best = std::move(result);
+            }
+            std::cerr << best.name << ": " << best.wall_s << " s" << std::endl;
+            results.emplace_back(std::move(best));
+        }
+    } catch (const std::exception &ex) {
+        std::cerr << "Benchmark failed: " << ex.what() << std::endl;
+        return 2;
+    }
+
+    if (output_path.empty())
+        write_json(std::cout, results);
+    else {
+        std::ofstream os(output_path);
+        write_json(os, results);
+    }
+
+    if (! baseline_path.empty()) {
+        try {
+            if (compare_with_baseline(results, baseline_path, threshold_percent))
+                return 1;
+        } catch (const std::exception &ex) {
+            std::cerr << "Failed to read the baseline " << baseline_path << ": " << ex.what() << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -52,6 +52,7 @@
 #include "libslic3r/Format/SL1.hpp"
 #include "libslic3r/Utils.hpp"
 #include "libslic3r/Thread.hpp"
+#include "libslic3r/Trace.hpp"
 #include "libslic3r/BlacklistedLibraryCheck.hpp"
 
 #include "PrusaSlicer.hpp"
@@ -561,6 +562,8 @@ int CLI::run(int argc, char **argv)
                 std::string outfile = m_config.opt_string("output");
                 Print       fff_print;
                 SLAPrint    sla_print;
+                fff_print.set_low_memory_mode(m_config.opt_bool("low_memory"));
+                fff_print.set_slice_cache_dir(m_config.opt_string("slice_cache"));
                 sla_print.set_status_callback(
                             [](const PrintBase::SlicingStatus& s)
                 {
@@ -591,6 +594,13 @@ int CLI::run(int argc, char **argv)
                 else
                     try {
                         std::string outfile_final;
+                        const std::string &trace_file = m_config.opt_string("trace");
+                        if (! trace_file.empty()) {
+#ifndef SLIC3R_TRACE
+                            boost::nowide::cerr << "warning: PrusaSlicer was compiled without SLIC3R_TRACE, the trace file will be empty" << std::endl;
+#endif // SLIC3R_TRACE
+                            Trace::start();
+                        }
                         print->process();
                         if (printer_technology == ptFFF) {
                             // The outfile is processed by a PlaceholderParser.
@@ -602,6 +612,11 @@ int CLI::run(int argc, char **argv)
                             outfile_final = sla_print.print_statistics().finalize_output_path(outfile);
                             sla_print.export_print(outfile_final);
                         }
+                        if (! trace_file.empty()) {
+                            Trace::stop();
+                            if (! Trace::write_chrome_json(trace_file))
+                                boost::nowide::cerr << "Failed to write the trace file " << trace_file << std::endl;
+                        }
                         if (outfile != outfile_final) {
                             if (Slic3r::rename_file(outfile, outfile_final)) {
                                 boost::nowide::cerr << "Renaming file " << outfile << " to " << outfile_final << " failed" << std::endl;
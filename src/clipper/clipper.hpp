@@ -566,6 +566,8 @@ private:
   // y: index of the lowest point in the lowest contour
   IntPoint m_lowest;
   PolyNode m_polyNodes;
+  // Clipper cleaning up the offsetted contours, kept to reuse its buffers by consecutive calls to Execute().
+  Clipper m_clipper;
 
   void FixOrientations();
   void DoOffset(double delta);
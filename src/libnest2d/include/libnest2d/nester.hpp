@@ -60,9 +60,13 @@ class _Item {
     };
 
     mutable Convexity convexity_ = Convexity::UNCHECKED;
-    mutable VertexConstIterator rmt_;    // rightmost top vertex
-    mutable VertexConstIterator lmb_;    // leftmost bottom vertex
+    // Offsets of the vertices in the transformed shape, which stay valid in
+    // copies of the item, unlike iterators.
+    mutable std::ptrdiff_t rmt_ = 0;    // rightmost top vertex
+    mutable std::ptrdiff_t lmb_ = 0;    // leftmost bottom vertex
     mutable bool rmt_valid_ = false, lmb_valid_ = false;
+    mutable size_t shape_hash_ = 0;
+    mutable bool shape_hash_valid_ = false;
     mutable struct BBCache {
         Box bb; bool valid;
         BBCache(): valid(false) {}
@@ -403,19 +407,92 @@ public:
     inline Vertex rightmostTopVertex() const {
         if(!rmt_valid_ || !tr_cache_valid_) {  // find max x and max y vertex
             auto& tsh = transformedShape();
-            rmt_ = std::max_element(sl::cbegin(tsh), sl::cend(tsh), vsort);
+            rmt_ = std::max_element(sl::cbegin(tsh), sl::cend(tsh), vsort) - sl::cbegin(tsh);
             rmt_valid_ = true;
         }
-        return *rmt_;
+        return *(sl::cbegin(transformedShape()) + rmt_);
     }
 
     inline Vertex leftmostBottomVertex() const {
         if(!lmb_valid_ || !tr_cache_valid_) {  // find min x and min y vertex
             auto& tsh = transformedShape();
-            lmb_ = std::min_element(sl::cbegin(tsh), sl::cend(tsh), vsort);
+            lmb_ = std::min_element(sl::cbegin(tsh), sl::cend(tsh), vsort) - sl::cbegin(tsh);
             lmb_valid_ = true;
         }
-        return *lmb_;
+        return *(sl::cbegin(transformedShape()) + lmb_);
+    }
+
+    /**
+     * @brief Hash of the shape with its inflation and rotation, but without
+     * its translation.
+     *
+     * Items with equal hashes have their transformed shapes equal up to a
+     * translation, thus calculations may be shared by copies of an object.
+     */
+    inline size_t shapeHash() const
+    {
+        if(!shape_hash_valid_) {
+            size_t h = sl::contourVertexCount(sh_);
+            auto combine_path = [&h](const auto& path) {
+                for(auto it = sl::cbegin(path); it != sl::cend(path); ++it) {
+                    hashCombine(h, getX(*it));
+                    hashCombine(h, getY(*it));
+                }
+            };
+            combine_path(sh_);
+            for(auto& hole : sl::holes(sh_)) combine_path(hole);
+            shape_hash_ = h;
+            shape_hash_valid_ = true;
+        }
+
+        size_t h = shape_hash_;
+        hashCombine(h, has_rotation_ ? double(rotation_) : 0.);
+        hashCombine(h, has_inflation_ ? inflation_ : Coord(0));
+        return h;
+    }
+
+    /**
+     * @brief Whether the transformed shapes of the two items are equal up to
+     * a translation.
+     *
+     * Exact counterpart of shapeHash(): Items with different shapes may
+     * share a hash.
+     */
+    inline bool isShapeEqual(const _Item& other) const
+    {
+        if(has_rotation_ != other.has_rotation_ ||
+           (has_rotation_ && double(rotation_) != double(other.rotation_)) ||
+           has_inflation_ != other.has_inflation_ ||
+           (has_inflation_ && inflation_ != other.inflation_))
+            return false;
+
+        auto path_equal = [](const auto& p1, const auto& p2) {
+            return std::equal(sl::cbegin(p1), sl::cend(p1),
+                              sl::cbegin(p2), sl::cend(p2),
+                              [](const Vertex& v1, const Vertex& v2) {
+                return getX(v1) == getX(v2) && getY(v1) == getY(v2);
+            });
+        };
+        if(!path_equal(sh_, other.sh_)) return false;
+        const auto& holes = sl::holes(sh_);
+        const auto& other_holes = sl::holes(other.sh_);
+        return std::equal(holes.begin(), holes.end(),
+                          other_holes.begin(), other_holes.end(), path_equal);
+    }
+
+    /**
+     * @brief Copy of the raw shape, rotation and inflation of the item to be
+     * compared by isShapeEqual(), without the translation and the cached
+     * data.
+     */
+    inline _Item shapeKey() const
+    {
+        _Item key(sh_);
+        key.rotation_ = rotation_;
+        key.has_rotation_ = has_rotation_;
+        key.inflation_ = inflation_;
+        key.has_inflation_ = has_inflation_;
+        return key;
     }
 
     //Static methods:
@@ -453,9 +530,15 @@ private:
         area_cache_valid_ = false;
         inflate_cache_valid_ = false;
         bb_cache_.valid = false;
+        shape_hash_valid_ = false;
         convexity_ = Convexity::UNCHECKED;
     }
 
+    template<class T> static inline void hashCombine(size_t& h, const T& v)
+    {
+        h ^= std::hash<T>{}(v) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+
     static inline bool vsort(const Vertex& v1, const Vertex& v2)
     {
         TCompute<Vertex> x1 = getX(v1), x2 = getX(v2);
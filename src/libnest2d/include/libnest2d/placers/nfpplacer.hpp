@@ -8,6 +8,9 @@
 #include <iterator>
 #include <future>
 #include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 #ifndef NDEBUG
 #include <iostream>
@@ -335,6 +338,107 @@ public:
 
 };
 
+/**
+ * Cache of the no-fit polygons of pairs of items, looked up by the shape
+ * hashes of the stationary and of the orbiting item, which include their
+ * rotations. Plates often contain many copies of the same objects, for which
+ * the no-fit polygons differ just by the translation of the stationary item.
+ * The cached polygon is stored with the rightmost top vertex of the stationary
+ * item it was calculated for, which the no-fit polygon is positioned by.
+ *
+ * The hashes only select the candidates: Each entry keeps the shapes of both
+ * items (see _Item::shapeKey()), a candidate is used only if both shapes are
+ * equal to the shapes of the items looked up.
+ *
+ * Lookups and insertions are guarded by a mutex, so that the rotations may be
+ * evaluated in parallel. The cache is dropped once it holds too many vertices.
+ */
+template<class RawShape> class NfpCache {
+    using Vertex = TPoint<RawShape>;
+    using Item = _Item<RawShape>;
+
+    struct Key {
+        size_t stationary, orbiter;
+        bool operator==(const Key& other) const {
+            return stationary == other.stationary && orbiter == other.orbiter;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            return k.stationary ^ (k.orbiter + 0x9e3779b9 + (k.stationary << 6) + (k.stationary >> 2));
+        }
+    };
+
+    struct Entry {
+        Item stationary, orbiter;
+        RawShape nfp;
+        Vertex anchor;
+
+        bool matches(const Item& st, const Item& orb) const {
+            return stationary.isShapeEqual(st) && orbiter.isShapeEqual(orb);
+        }
+    };
+
+    static const constexpr size_t MaxVertices = 10000000;
+
+    std::unordered_multimap<Key, Entry, KeyHash> map_;
+    size_t vertices_ = 0;
+    mutable std::shared_mutex mutex_;
+
+public:
+    NfpCache() = default;
+
+    // The cached polygons are not shared by copies of the placer.
+    NfpCache(const NfpCache&) {}
+    NfpCache& operator=(const NfpCache&) { clear(); return *this; }
+
+    // Get the no-fit polygon of the orbiter around the stationary item,
+    // positioned for the anchor, which is the rightmost top vertex of the
+    // stationary item. Returns false if not cached.
+    bool get(const Item& stationary, const Item& orbiter, RawShape& nfp) const
+    {
+        std::shared_lock<std::shared_mutex> lk(mutex_);
+        auto range = map_.equal_range({stationary.shapeHash(), orbiter.shapeHash()});
+        for(auto it = range.first; it != range.second; ++it)
+            if(it->second.matches(stationary, orbiter)) {
+                nfp = it->second.nfp;
+                sl::translate(nfp, stationary.rightmostTopVertex() - it->second.anchor);
+                return true;
+            }
+        return false;
+    }
+
+    void insert(const Item& stationary, const Item& orbiter,
+                const RawShape& nfp)
+    {
+        std::unique_lock<std::shared_mutex> lk(mutex_);
+        Key key{stationary.shapeHash(), orbiter.shapeHash()};
+        auto range = map_.equal_range(key);
+        for(auto it = range.first; it != range.second; ++it)
+            if(it->second.matches(stationary, orbiter))
+                // Inserted by another rotation evaluated in parallel.
+                return;
+        size_t vertices = sl::contourVertexCount(nfp) +
+                          sl::contourVertexCount(stationary.rawShape()) +
+                          sl::contourVertexCount(orbiter.rawShape());
+        if(vertices_ + vertices > MaxVertices) {
+            map_.clear();
+            vertices_ = 0;
+        }
+        map_.emplace(key, Entry{stationary.shapeKey(), orbiter.shapeKey(),
+                                nfp, stationary.rightmostTopVertex()});
+        vertices_ += vertices;
+    }
+
+    void clear()
+    {
+        std::unique_lock<std::shared_mutex> lk(mutex_);
+        map_.clear();
+        vertices_ = 0;
+    }
+};
+
 template<nfp::NfpLevel lvl>
 struct Lvl { static const nfp::NfpLevel value = lvl; };
 
@@ -455,6 +559,7 @@ private:
     // Norming factor for the optimization function
     const double norm_;
     Pile merged_pile_;
+    NfpCache<RawShape> nfp_cache_;
 
 public:
 
@@ -558,29 +663,28 @@ private:
 
         // /////////////////////////////////////////////////////////////////////
         // TODO: this is a workaround and should be solved in Item with mutexes
-        // guarding the mutable members when writing them.
+        // guarding the mutable members when writing them. The packed items
+        // are prepared by trypack() before evaluating the rotations.
         // /////////////////////////////////////////////////////////////////////
         trsh.transformedShape();
         trsh.referenceVertex();
         trsh.rightmostTopVertex();
         trsh.leftmostBottomVertex();
-
-        for(Item& itm : items_) {
-            itm.transformedShape();
-            itm.referenceVertex();
-            itm.rightmostTopVertex();
-            itm.leftmostBottomVertex();
-        }
+        trsh.shapeHash();
         // /////////////////////////////////////////////////////////////////////
 
+        auto& cache = nfp_cache_;
         __parallel::enumerate(items_.begin(), items_.end(),
-                              [&nfps, &trsh](const Item& sh, size_t n)
+                              [&nfps, &trsh, &cache](const Item& sh, size_t n)
         {
+            if(cache.get(sh, trsh, nfps[n])) return;
+
             auto& fixedp = sh.transformedShape();
             auto& orbp = trsh.transformedShape();
             auto subnfp_r = noFitPolygon<NfpLevel::CONVEX_ONLY>(fixedp, orbp);
             correctNfpPosition(subnfp_r, sh, trsh);
-            nfps[n] = subnfp_r.first;
+            cache.insert(sh, trsh, subnfp_r.first);
+            nfps[n] = std::move(subnfp_r.first);
         });
 
         return nfp::merge(nfps);
@@ -639,7 +743,6 @@ public:
         auto initial_rot = item.rotation();
         Vertex final_tr = {0, 0};
         Radians final_rot = initial_rot;
-        Shapes nfps;
 
         auto& bin = bin_;
         double norm = norm_;
@@ -706,9 +809,35 @@ public:
             item.translation(best_tr);
         } else {
 
-            Pile merged_pile = merged_pile_;
+            // Fill the lazily computed caches of the packed items, as they
+            // are read concurrently by the rotations evaluated in parallel.
+            for(Item& itm : items_) {
+                itm.transformedShape();
+                itm.referenceVertex();
+                itm.rightmostTopVertex();
+                itm.leftmostBottomVertex();
+                itm.shapeHash();
+            }
 
-            for(auto rot : config_.rotations) {
+            std::launch policy = std::launch::deferred;
+            if(config_.parallel) policy |= std::launch::async;
+
+            if(config_.before_packing)
+                config_.before_packing(merged_pile_, items_, remlist);
+
+            // The best placement of the item for one of the rotations.
+            struct RotationResult {
+                double score = std::numeric_limits<double>::max();
+                double overfit = std::numeric_limits<double>::max();
+                Vertex translation = {0, 0};
+            };
+
+            // Evaluates a rotation with a copy of the item, which is moved
+            // around independently of the other rotations.
+            auto try_rotation = [&](Item& item, Radians rot) {
+                RotationResult result;
+                Pile merged_pile = merged_pile_;
+                Shapes nfps;
 
                 item.translation(initial_tr);
                 item.rotation(initial_rot + rot);
@@ -770,11 +899,6 @@ public:
 
                 Optimum optimum(0, 0);
                 double best_score = std::numeric_limits<double>::max();
-                std::launch policy = std::launch::deferred;
-                if(config_.parallel) policy |= std::launch::async;
-
-                if(config_.before_packing)
-                    config_.before_packing(merged_pile, items_, remlist);
 
                 using OptResult = opt::Result<double>;
                 using OptResults = std::vector<OptResult>;
@@ -831,7 +955,7 @@ public:
                             best_score = mr.score;
                             optimum = o;
                         } else {
-                            best_overfit = std::min(miss, best_overfit);
+                            result.overfit = std::min(miss, result.overfit);
                         }
                     }
 
@@ -880,18 +1004,39 @@ public:
                                 best_score = hmr.score;
                                 optimum = o;
                             } else {
-                                best_overfit = std::min(miss, best_overfit);
+                                result.overfit = std::min(miss, result.overfit);
                             }
                         }
                     }
                 }
 
-                if( best_score < global_score ) {
-                    auto d = (getNfpPoint(optimum) - iv) + startpos;
-                    final_tr = d;
-                    final_rot = initial_rot + rot;
+                if( best_score < result.score ) {
+                    result.translation = (getNfpPoint(optimum) - iv) + startpos;
+                    result.score = best_score;
+                }
+
+                return result;
+            };
+
+            std::vector<RotationResult> results(config_.rotations.size());
+            __parallel::enumerate(config_.rotations.begin(),
+                                  config_.rotations.end(),
+                                  [&results, &item, &try_rotation]
+                                  (Radians rot, size_t n)
+            {
+                Item itemcpy = item;
+                results[n] = try_rotation(itemcpy, rot);
+            }, policy);
+
+            // The first of the best scoring rotations wins, as if the
+            // rotations were evaluated one after another.
+            for(size_t n = 0; n < results.size(); ++n) {
+                best_overfit = std::min(results[n].overfit, best_overfit);
+                if( results[n].score < global_score ) {
+                    final_tr = results[n].translation;
+                    final_rot = initial_rot + config_.rotations[n];
                     can_pack = true;
-                    global_score = best_score;
+                    global_score = results[n].score;
                 }
             }
 
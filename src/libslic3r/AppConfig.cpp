@@ -69,6 +69,9 @@ void AppConfig::set_defaults()
         // Enable support issues alerts by default
         if (get("alert_when_supports_needed").empty())
             set("alert_when_supports_needed", "1");
+        // Keep the slicing result after the G-code export by default.
+        if (get("low_memory").empty())
+            set("low_memory", "0");
         // If set, the "Controller" tab for the control of the printer over serial line and the serial port settings are hidden.
         // By default, Prusa has the controller hidden.
         if (get("no_controller").empty())
@@ -1,4 +1,5 @@
 #include "Arrange.hpp"
+#include "ArrangeRaster.hpp"
 
 #include "BoundingBox.hpp"
 
@@ -536,6 +537,23 @@ inline Circle to_nestbin(const CircleBed &c) { return Circle({c.center()(0), c.c
 inline ExPolygon to_nestbin(const Polygon &p) { return ExPolygon{p}; }
 inline Box to_nestbin(const InfiniteBed &bed) { return Box::infinite({bed.center.x(), bed.center.y()}); }
 
+// The beds of the raster engine, which does not support an infinite bed.
+inline std::optional<ExPolygon> to_raster_bed(const BoundingBox &bb) { return ExPolygon(bb.polygon()); }
+inline std::optional<ExPolygon> to_raster_bed(const CircleBed &c)
+{
+    // Inscribed polygon, so that the items stay inside the circle.
+    static constexpr const size_t num_points = 128;
+    Polygon poly;
+    poly.points.reserve(num_points);
+    for (size_t i = 0; i < num_points; ++ i) {
+        double angle = 2. * PI * double(i) / double(num_points);
+        poly.points.emplace_back(c.center() + Point(coord_t(c.radius() * std::cos(angle)), coord_t(c.radius() * std::sin(angle))));
+    }
+    return ExPolygon(std::move(poly));
+}
+inline std::optional<ExPolygon> to_raster_bed(const Polygon &p) { return ExPolygon(p); }
+inline std::optional<ExPolygon> to_raster_bed(const InfiniteBed &) { return std::nullopt; }
+
 inline coord_t width(const BoundingBox& box) { return box.max.x() - box.min.x(); }
 inline coord_t height(const BoundingBox& box) { return box.max.y() - box.min.y(); }
 inline double area(const BoundingBox& box) { return double(width(box)) * height(box); }
@@ -632,6 +650,12 @@ void arrange(ArrangePolygons &      arrangables,
              const BedT &           bed,
              const ArrangeParams &  params)
 {
+    if (params.engine == ArrangeEngine::Raster)
+        if (std::optional<ExPolygon> raster_bed = to_raster_bed(bed); raster_bed) {
+            arrange_raster(arrangables, excludes, *raster_bed, params);
+            return;
+        }
+
     namespace clppr = Slic3r::ClipperLib;
     
     std::vector<Item> items, fixeditems;
@@ -127,6 +127,16 @@ enum class Pivots {
     Center, TopLeft, BottomLeft, BottomRight, TopRight
 };
 
+/// The algorithm placing the items.
+enum class ArrangeEngine {
+    /// Exact placement on the no-fit polygons of the items.
+    NFP,
+    /// Bottom left placement of the item footprints on an occupancy grid of
+    /// the bed, see ArrangeParams::raster_resolution. Much faster than NFP
+    /// for large numbers of small items. Falls back to NFP for an infinite bed.
+    Raster
+};
+
 struct ArrangeParams {
 
     /// The minimum distance which is allowed for any 
@@ -151,6 +161,12 @@ struct ArrangeParams {
     /// Starting position hint for the arrangement
     Pivots starting_point = Pivots::Center;
 
+    ArrangeEngine engine = ArrangeEngine::NFP;
+
+    /// The size of a cell of the occupancy grid of ArrangeEngine::Raster.
+    /// The footprints of the items are rounded up to whole cells.
+    coord_t raster_resolution = scaled(0.5);
+
     /// Progress indicator callback called when an object gets packed. 
     /// The unsigned argument is the number of items remaining to pack.
     std::function<void(unsigned)> progressind;
@@ -0,0 +1,365 @@
+#include "ArrangeRaster.hpp"
+
+#include "BoundingBox.hpp"
+#include "ClipperUtils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+
+namespace Slic3r { namespace arrangement {
+
+namespace {
+
+// Cells [col_begin, col_end) of a row of a grid.
+struct Span {
+    int row;
+    int col_begin;
+    int col_end;
+};
+
+// Cells of the grid with the cell (0, 0) starting at origin, which centers are inside the polygons.
+// The rows and columns may be negative.
+std::vector<Span> rasterize(const ExPolygons &expolygons, const Point &origin, coord_t resolution)
+{
+    std::vector<Span>   spans;
+    std::vector<double> xs;
+    const double        r = double(resolution);
+    for (const ExPolygon &expoly : expolygons) {
+        const BoundingBox bbox    = get_extents(expoly.contour);
+        const int         row_min = int(std::ceil(double(bbox.min.y() - origin.y()) / r - 0.5));
+        const int         row_max = int(std::floor(double(bbox.max.y() - origin.y()) / r - 0.5));
+        for (int row = row_min; row <= row_max; ++ row) {
+            const double y = double(origin.y()) + (double(row) + 0.5) * r;
+            xs.clear();
+            auto add_intersections = [&xs, y](const Polygon &poly) {
+                for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i ++) {
+                    const Point &a = poly[j];
+                    const Point &b = poly[i];
+                    if ((double(a.y()) <= y) != (double(b.y()) <= y))
+                        xs.emplace_back(double(a.x()) + (y - double(a.y())) * double(b.x() - a.x()) / double(b.y() - a.y()));
+                }
+            };
+            add_intersections(expoly.contour);
+            for (const Polygon &hole : expoly.holes)
+                add_intersections(hole);
+            std::sort(xs.begin(), xs.end());
+            for (size_t i = 0; i + 1 < xs.size(); i += 2) {
+                const int col_begin = int(std::ceil((xs[i] - double(origin.x())) / r - 0.5));
+                const int col_end   = int(std::floor((xs[i + 1] - double(origin.x())) / r - 0.5)) + 1;
+                if (col_begin < col_end)
+                    spans.push_back({ row, col_begin, col_end });
+            }
+        }
+    }
+    return spans;
+}
+
+// Occupancy of the cells of a bed. Each cell keeps the number of free cells in its row starting with the cell itself,
+// zero for an occupied cell, thus a span is tested by a single lookup.
+class OccupancyGrid {
+public:
+    // All cells except for the allowed ones are occupied.
+    OccupancyGrid(int cols, int rows, const std::vector<Span> &allowed) : m_cols(cols), m_rows(rows), m_free(size_t(cols) * size_t(rows), 0)
+    {
+        for (const Span &span : allowed)
+            if (span.row >= 0 && span.row < m_rows)
+                for (int col = std::max(span.col_begin, 0); col < std::min(span.col_end, m_cols); ++ col)
+                    m_free[index(span.row, col)] = 1;
+        for (int row = 0; row < m_rows; ++ row) {
+            int32_t *cells = &m_free[index(row, 0)];
+            for (int col = m_cols - 2; col >= 0; -- col)
+                if (cells[col] != 0)
+                    cells[col] = cells[col + 1] + 1;
+        }
+    }
+
+    int     cols() const { return m_cols; }
+    int     rows() const { return m_rows; }
+    int32_t free_run(int row, int col) const { return m_free[index(row, col)]; }
+
+    // Marks the cells of the spans shifted by (col_offset, row_offset) as occupied, the spans are clipped by the grid.
+    void occupy(const std::vector<Span> &spans, int col_offset, int row_offset)
+    {
+        for (const Span &span : spans) {
+            const int row = span.row + row_offset;
+            if (row < 0 || row >= m_rows)
+                continue;
+            const int col_begin = std::max(span.col_begin + col_offset, 0);
+            const int col_end   = std::min(span.col_end + col_offset, m_cols);
+            if (col_begin >= col_end)
+                continue;
+            int32_t *cells = &m_free[index(row, 0)];
+            std::fill(cells + col_begin, cells + col_end, 0);
+            // The free runs left of the span end at the span now.
+            for (int col = col_begin - 1; col >= 0 && cells[col] != 0; -- col)
+                cells[col] = cells[col + 1] + 1;
+        }
+    }
+
+private:
+    size_t index(int row, int col) const { return size_t(row) * size_t(m_cols) + size_t(col); }
+
+    int                  m_cols;
+    int                  m_rows;
+    std::vector<int32_t> m_free;
+};
+
+// Cells covered by an item in a given rotation, relative to the bottom left cell of their bounding box.
+struct Footprint {
+    // Key of the footprint cache.
+    Polygon             contour;
+    double              rotation;
+    coord_t             inflation;
+
+    std::vector<Span>   spans;
+    int                 cols { 0 };
+    int                 rows { 0 };
+    // Bottom left cell of the footprint on a grid with the cell (0, 0) starting at the origin of the rotated item.
+    Vec2i               offset { 0, 0 };
+    // Position of the last placement per logical bed. The occupancy of a bed only grows,
+    // thus the search for the next copy of the item starts there.
+    std::vector<Vec2i>  resume;
+};
+
+Footprint make_footprint(const Polygon &contour, double rotation, coord_t inflation, coord_t resolution, coord_t half_diagonal)
+{
+    Footprint footprint { contour, rotation, inflation };
+    Polygon   rotated = contour;
+    rotated.rotate(rotation);
+    // A cell overlapping the inflated item has its center closer than half of its diagonal.
+    footprint.spans = rasterize(offset_ex(ExPolygon(std::move(rotated)), float(inflation + half_diagonal)), Point(0, 0), resolution);
+    if (footprint.spans.empty())
+        return footprint;
+    Vec2i min(INT_MAX, INT_MAX);
+    Vec2i max(INT_MIN, INT_MIN);
+    for (const Span &span : footprint.spans) {
+        min = min.cwiseMin(Vec2i(span.col_begin, span.row));
+        max = max.cwiseMax(Vec2i(span.col_end, span.row + 1));
+    }
+    for (Span &span : footprint.spans) {
+        span.row       -= min.y();
+        span.col_begin -= min.x();
+        span.col_end   -= min.x();
+    }
+    footprint.cols   = max.x() - min.x();
+    footprint.rows   = max.y() - min.y();
+    footprint.offset = min;
+    return footprint;
+}
+
+// Footprints shared by the copies of an item, which are likely to be arranged together.
+class FootprintCache {
+public:
+    FootprintCache(coord_t resolution, coord_t half_diagonal) : m_resolution(resolution), m_half_diagonal(half_diagonal) {}
+
+    Footprint& get(const Polygon &contour, double rotation, coord_t inflation)
+    {
+        size_t seed = 0;
+        boost::hash_combine(seed, rotation);
+        boost::hash_combine(seed, inflation);
+        for (const Point &pt : contour.points) {
+            boost::hash_combine(seed, pt.x());
+            boost::hash_combine(seed, pt.y());
+        }
+        std::vector<size_t> &ids = m_map[seed];
+        for (size_t id : ids) {
+            Footprint &footprint = m_footprints[id];
+            if (footprint.rotation == rotation && footprint.inflation == inflation && footprint.contour.points == contour.points)
+                return footprint;
+        }
+        ids.emplace_back(m_footprints.size());
+        m_footprints.emplace_back(make_footprint(contour, rotation, inflation, m_resolution, m_half_diagonal));
+        return m_footprints.back();
+    }
+
+private:
+    coord_t                                          m_resolution;
+    coord_t                                          m_half_diagonal;
+    // Deque for the references to stay valid.
+    std::deque<Footprint>                            m_footprints;
+    std::unordered_map<size_t, std::vector<size_t>>  m_map;
+};
+
+// Finds the first free position of the footprint in the order of rows and columns, starting at pos.
+bool find_position(const OccupancyGrid &grid, const Footprint &footprint, Vec2i &pos)
+{
+    for (int row = pos.y(); row + footprint.rows <= grid.rows(); ++ row) {
+        int col = row == pos.y() ? pos.x() : 0;
+        while (col + footprint.cols <= grid.cols()) {
+            int skip = 0;
+            for (const Span &span : footprint.spans)
+                if (int free = grid.free_run(row + span.row, col + span.col_begin); free < span.col_end - span.col_begin) {
+                    // Any position overlapping the occupied cell ending the free run collides with this span.
+                    skip = free + 1;
+                    break;
+                }
+            if (skip == 0) {
+                pos = Vec2i(col, row);
+                return true;
+            }
+            col += skip;
+        }
+    }
+    return false;
+}
+
+struct RasterBed {
+    OccupancyGrid       grid;
+    bool                has_excludes { false };
+    // Items placed onto this bed.
+    std::vector<size_t> items;
+    // Cells covered by the footprints of the items.
+    BoundingBox         pile;
+};
+
+} // namespace
+
+void arrange_raster(ArrangePolygons &items, const ArrangePolygons &excludes, const ExPolygon &bed, const ArrangeParams &params)
+{
+    assert(params.raster_resolution > 0);
+    const coord_t resolution    = params.raster_resolution;
+    const coord_t half_diagonal = coord_t(std::ceil(0.5 * std::sqrt(2.) * double(resolution)));
+    // The items are inflated by a half of the minimum distance, thus the bed is inflated as well, see _arrange().
+    const coord_t infl          = coord_t(std::ceil(params.min_obj_distance / 2.0));
+
+    const ExPolygons allowed_region = offset_ex(bed, float(params.min_obj_distance / 2 - params.min_bed_distance));
+    if (allowed_region.empty()) {
+        for (ArrangePolygon &item : items)
+            item.bed_idx = UNARRANGED;
+        return;
+    }
+
+    const BoundingBox bedbb  = get_extents(allowed_region);
+    const Point       origin = bedbb.min;
+    // Only the cells entirely inside of the allowed region are free.
+    const std::vector<Span> allowed_cells = rasterize(offset_ex(allowed_region, - float(half_diagonal)), origin, resolution);
+    const OccupancyGrid     empty_grid(int((bedbb.max.x() - bedbb.min.x()) / resolution) + 1, int((bedbb.max.y() - bedbb.min.y()) / resolution) + 1, allowed_cells);
+    BoundingBox             allowed_bbox;
+    for (const Span &span : allowed_cells)
+        if (span.col_begin < span.col_end) {
+            allowed_bbox.merge(Point(span.col_begin, span.row));
+            allowed_bbox.merge(Point(span.col_end - 1, span.row));
+        }
+
+    std::vector<RasterBed> beds;
+    auto add_bed = [&beds, &empty_grid]() { beds.push_back({ empty_grid }); };
+
+    for (const ArrangePolygon &fixed : excludes) {
+        // The excludes, which are not on any logical bed, are considered to be on the physical bed, as done by libnest2d.
+        const size_t bed_idx = size_t(std::max(fixed.bed_idx, 0));
+        while (beds.size() <= bed_idx)
+            add_bed();
+        beds[bed_idx].has_excludes = true;
+        beds[bed_idx].grid.occupy(
+            rasterize(offset_ex(ExPolygon(fixed.transformed_poly().contour), float(infl + fixed.inflation + half_diagonal) - float(scaled(2. * EPSILON))), origin, resolution),
+            0, 0);
+    }
+
+    // Larger items first, see libnest2d::FirstFitSelection.
+    std::vector<double> areas;
+    areas.reserve(items.size());
+    for (const ArrangePolygon &item : items)
+        areas.emplace_back(std::abs(item.poly.contour.area()));
+    std::vector<size_t> order(items.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&items, &areas](size_t i1, size_t i2) {
+        return items[i1].priority > items[i2].priority || (items[i1].priority == items[i2].priority && areas[i1] > areas[i2]);
+    });
+
+    FootprintCache           cache(resolution, half_diagonal);
+    std::vector<Footprint*>  footprints;
+    unsigned                 remaining = unsigned(items.size());
+    for (size_t item_idx : order) {
+        if (params.stopcondition && params.stopcondition())
+            break;
+
+        ArrangePolygon &item = items[item_idx];
+        footprints.clear();
+        for (int i = 0; i < (params.allow_rotations ? 4 : 1); ++ i)
+            footprints.emplace_back(&cache.get(item.poly.contour, item.rotation + i * 0.5 * PI, infl + item.inflation));
+
+        item.bed_idx = UNARRANGED;
+        for (size_t bed_idx = 0;; ++ bed_idx) {
+            const bool new_bed = bed_idx == beds.size();
+            if (new_bed)
+                add_bed();
+            RasterBed &rbed = beds[bed_idx];
+            Footprint *best = nullptr;
+            Vec2i      best_pos;
+            for (Footprint *footprint : footprints) {
+                if (footprint->resume.size() <= bed_idx)
+                    footprint->resume.resize(bed_idx + 1, Vec2i(0, 0));
+                Vec2i &pos = footprint->resume[bed_idx];
+                if (! find_position(rbed.grid, *footprint, pos)) {
+                    pos = Vec2i(0, rbed.grid.rows());
+                    continue;
+                }
+                // Lowest top edge first to keep the pile compact, then leftmost.
+                if (best == nullptr || pos.y() + footprint->rows < best_pos.y() + best->rows ||
+                    (pos.y() + footprint->rows == best_pos.y() + best->rows && pos.x() < best_pos.x())) {
+                    best     = footprint;
+                    best_pos = pos;
+                }
+            }
+            if (best != nullptr) {
+                rbed.grid.occupy(best->spans, best_pos.x(), best_pos.y());
+                rbed.items.emplace_back(item_idx);
+                rbed.pile.merge(Point(best_pos.x(), best_pos.y()));
+                rbed.pile.merge(Point(best_pos.x() + best->cols - 1, best_pos.y() + best->rows - 1));
+                item.rotation    = best->rotation;
+                item.translation = origin + Point(best_pos.x() - best->offset.x(), best_pos.y() - best->offset.y()) * resolution;
+                item.bed_idx     = int(bed_idx);
+                break;
+            }
+            if (new_bed) {
+                // The item does not fit an empty bed.
+                beds.pop_back();
+                break;
+            }
+        }
+
+        if (params.on_packed && item.bed_idx != UNARRANGED)
+            params.on_packed(item);
+        if (params.progressind)
+            params.progressind(-- remaining);
+    }
+
+    // Align the piles on rectangular beds, where the grid cells of the allowed region form a rectangle.
+    if (! is_box(bed.contour.points) || ! bed.holes.empty())
+        return;
+    for (const RasterBed &rbed : beds) {
+        if (rbed.has_excludes || rbed.items.empty())
+            continue;
+        const BoundingBox &pile = rbed.pile;
+        Point              shift;
+        switch (params.alignment) {
+        case Pivots::Center:
+            shift = Point((allowed_bbox.min.x() + allowed_bbox.max.x() - pile.min.x() - pile.max.x()) / 2,
+                          (allowed_bbox.min.y() + allowed_bbox.max.y() - pile.min.y() - pile.max.y()) / 2);
+            break;
+        case Pivots::BottomLeft:
+            shift = allowed_bbox.min - pile.min;
+            break;
+        case Pivots::TopRight:
+            shift = allowed_bbox.max - pile.max;
+            break;
+        case Pivots::TopLeft:
+            shift = Point(allowed_bbox.min.x() - pile.min.x(), allowed_bbox.max.y() - pile.max.y());
+            break;
+        case Pivots::BottomRight:
+            shift = Point(allowed_bbox.max.x() - pile.max.x(), allowed_bbox.min.y() - pile.min.y());
+            break;
+        }
+        for (size_t item_idx : rbed.items)
+            items[item_idx].translation += shift * resolution;
+    }
+}
+
+}} // namespace Slic3r::arrangement
@@ -0,0 +1,18 @@
+#ifndef slic3r_ArrangeRaster_hpp_
+#define slic3r_ArrangeRaster_hpp_
+
+#include "Arrange.hpp"
+
+namespace Slic3r { namespace arrangement {
+
+// Arrangement by ArrangeEngine::Raster: The footprints of the items are rounded up to the cells of an occupancy grid
+// of ArrangeParams::raster_resolution and placed bottom left first. A footprint is stored as spans of its rows
+// and the grid keeps the number of free cells to the right of each cell, thus testing a position costs
+// a lookup per row of the footprint. The search for the copies of the same item continues where the previous copy
+// was placed, so that filling a bed with identical items takes time close to linear in their count.
+// Items, which do not fit the bed, are placed to the next logical beds, items not fitting an empty bed are UNARRANGED.
+void arrange_raster(ArrangePolygons &items, const ArrangePolygons &excludes, const ExPolygon &bed, const ArrangeParams &params);
+
+}} // namespace Slic3r::arrangement
+
+#endif // slic3r_ArrangeRaster_hpp_
@@ -3,6 +3,10 @@
 #include "ShortestPath.hpp"
 #include "Utils.hpp"
 
+#include <optional>
+
+#include <tbb/parallel_for.h>
+
 // #define CLIPPER_UTILS_TIMING
 
 #ifdef CLIPPER_UTILS_TIMING
@@ -269,6 +273,69 @@ bool has_duplicate_points(const ClipperLib::PolyTree &polytree)
 }
 #endif
 
+// ClipperLib::Clipper / ClipperLib::ClipperOffset owned by the calling thread and reused by all the operations below.
+// Only the containers not released by Clear() keep their capacity from one call to the next (the local minima list,
+// the offset buffers), the edges are allocated by each AddPaths() and freed by Clear().
+// If the engine of this thread is already taken (a reentrant call), a temporary engine is constructed instead.
+// The engine is returned cleared and with its options set to defaults.
+namespace {
+template<typename Engine>
+class ThreadLocalEngine
+{
+public:
+    ThreadLocalEngine() {
+        Slot &slot = this_thread_slot();
+        if (slot.in_use) {
+            m_temp.emplace();
+            m_engine = &(*m_temp);
+        } else {
+            slot.in_use = true;
+            m_slot      = &slot;
+            m_engine    = &slot.engine;
+        }
+    }
+    ~ThreadLocalEngine() {
+        if (m_slot) {
+            reset(*m_engine);
+            m_slot->in_use = false;
+        }
+    }
+    ThreadLocalEngine(const ThreadLocalEngine &) = delete;
+    ThreadLocalEngine& operator=(const ThreadLocalEngine &) = delete;
+
+    Engine& operator*()  { return *m_engine; }
+    Engine* operator->() { return m_engine; }
+
+private:
+    struct Slot {
+        Engine engine;
+        bool   in_use { false };
+    };
+    static Slot& this_thread_slot() { static thread_local Slot slot; return slot; }
+
+    static void reset(ClipperLib::Clipper &clipper) {
+        clipper.Clear();
+        clipper.ReverseSolution(false);
+        clipper.StrictlySimple(false);
+        clipper.PreserveCollinear(false);
+    }
+    static void reset(ClipperLib::ClipperOffset &co) {
+        co.Clear();
+        static const ClipperLib::ClipperOffset defaults;
+        co.MiterLimit         = defaults.MiterLimit;
+        co.ArcTolerance       = defaults.ArcTolerance;
+        co.ShortestEdgeLength = defaults.ShortestEdgeLength;
+    }
+
+    Slot                  *m_slot { nullptr };
+    std::optional<Engine>  m_temp;
+    Engine                *m_engine;
+};
+
+using ThreadLocalClipper       = ThreadLocalEngine<ClipperLib::Clipper>;
+using ThreadLocalClipperOffset = ThreadLocalEngine<ClipperLib::ClipperOffset>;
+} // anonymous namespace
+
 // Offset CCW contours outside, CW contours (holes) inside.
 // Don't calculate union of the output paths.
 template<typename PathsProvider, ClipperLib::EndType endType = ClipperLib::etClosedPolygon>
@@ -276,7 +343,8 @@ static ClipperLib::Paths raw_offset(PathsProvider &&paths, float offset, Clipper
 {
     CLIPPER_UTILS_TIME_LIMIT_MILLIS(CLIPPER_UTILS_TIME_LIMIT_DEFAULT);
 
-    ClipperLib::ClipperOffset co;
+    ThreadLocalClipperOffset engine;
+    ClipperLib::ClipperOffset &co = *engine;
     ClipperLib::Paths out;
     out.reserve(paths.size());
     ClipperLib::Paths out_this;
@@ -319,7 +387,8 @@ TResult clipper_do(
 {
     CLIPPER_UTILS_TIME_LIMIT_MILLIS(CLIPPER_UTILS_TIME_LIMIT_DEFAULT);
 
-    ClipperLib::Clipper clipper;
+    ThreadLocalClipper engine;
+    ClipperLib::Clipper &clipper = *engine;
     clipper.AddPaths(std::forward<TSubj>(subject), ClipperLib::ptSubject, true);
     clipper.AddPaths(std::forward<TClip>(clip),    ClipperLib::ptClip,    true);
     TResult retval;
@@ -350,7 +419,8 @@ TResult clipper_union(
 {
     CLIPPER_UTILS_TIME_LIMIT_MILLIS(CLIPPER_UTILS_TIME_LIMIT_DEFAULT);
 
-    ClipperLib::Clipper clipper;
+    ThreadLocalClipper engine;
+    ClipperLib::Clipper &clipper = *engine;
     clipper.AddPaths(std::forward<TSubj>(subject), ClipperLib::ptSubject, true);
     TResult retval;
     clipper.Execute(ClipperLib::ctUnion, retval, fillType, fillType);
@@ -393,7 +463,8 @@ static TResult shrink_paths(PathsProvider &&paths, float offset, ClipperLib::Joi
     assert(offset > 0);
     TResult out;
     if (auto raw = raw_offset(std::forward<PathsProvider>(paths), - offset, joinType, miterLimit); ! raw.empty()) {
-        ClipperLib::Clipper clipper;
+        ThreadLocalClipper engine;
+        ClipperLib::Clipper &clipper = *engine;
         clipper.AddPaths(raw, ClipperLib::ptSubject, true);
         ClipperLib::IntRect r = clipper.GetBounds();
         clipper.AddPath({ { r.left - 10, r.bottom + 10 }, { r.right + 10, r.bottom + 10 }, { r.right + 10, r.top - 10 }, { r.left - 10, r.top - 10 } }, ClipperLib::ptSubject, true);
@@ -434,7 +505,8 @@ static int offset_expolygon_inner(const Slic3r::ExPolygon &expoly, const float d
     // 1) Offset the outer contour.
     ClipperLib::Paths contours;
     {
-        ClipperLib::ClipperOffset co;
+        ThreadLocalClipperOffset engine;
+        ClipperLib::ClipperOffset &co = *engine;
         if (joinType == jtRound)
             co.ArcTolerance = miterLimit;
         else
@@ -454,13 +526,15 @@ static int offset_expolygon_inner(const Slic3r::ExPolygon &expoly, const float d
         // 2) Offset the holes one by one, collect the offsetted holes.
         ClipperLib::Paths holes;
         {
+            ThreadLocalClipperOffset engine;
+            ClipperLib::ClipperOffset &co = *engine;
+            if (joinType == jtRound)
+                co.ArcTolerance = miterLimit;
+            else
+                co.MiterLimit = miterLimit;
+            co.ShortestEdgeLength = std::abs(delta * ClipperOffsetShortestEdgeFactor);
             for (const Polygon &hole : expoly.holes) {
-                ClipperLib::ClipperOffset co;
-                if (joinType == jtRound)
-                    co.ArcTolerance = miterLimit;
-                else
-                    co.MiterLimit = miterLimit;
-                co.ShortestEdgeLength = std::abs(delta * ClipperOffsetShortestEdgeFactor);
+                co.Clear();
                 co.AddPath(hole.points, joinType, ClipperLib::etClosedPolygon);
                 ClipperLib::Paths out2;
                 // Execute reorients the contours so that the outer most contour has a positive area. Thus the output
@@ -783,7 +857,8 @@ Polylines _clipper_pl_open(ClipperLib::ClipType clipType, PathsProvider1 &&subje
 {
     CLIPPER_UTILS_TIME_LIMIT_MILLIS(CLIPPER_UTILS_TIME_LIMIT_DEFAULT);
 
-    ClipperLib::Clipper clipper;
+    ThreadLocalClipper engine;
+    ClipperLib::Clipper &clipper = *engine;
     clipper.AddPaths(std::forward<PathsProvider1>(subject), ClipperLib::ptSubject, false);
     clipper.AddPaths(std::forward<PathsProvider2>(clip), ClipperLib::ptClip, true);
     ClipperLib::PolyTree retval;
@@ -1399,4 +1474,18 @@ ExPolygons variable_offset_outer_ex(const ExPolygon &expoly, const std::vector<s
 	return output;
 }
 
+void ClipperUtils::Batch::execute()
+{
+    Value *results = m_results.data() + (m_results.size() - m_operations.size());
+    if (m_operations.size() == 1)
+        m_operations.front()(*results);
+    else if (m_operations.size() > 1)
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, m_operations.size(), 1),
+            [this, results](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i)
+                    m_operations[i](results[i]);
+            });
+    m_operations.clear();
+}
+
 }
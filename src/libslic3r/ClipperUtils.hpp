@@ -8,6 +8,10 @@
 #include "Polygon.hpp"
 #include "Surface.hpp"
 
+#include <functional>
+#include <type_traits>
+#include <variant>
+
 #ifdef SLIC3R_USE_CLIPPER2
 
 #include <clipper2.clipper.h>
@@ -598,6 +602,63 @@ void traverse_pt(const ClipperLib::PolyNodes &nodes, ExOrJustPolygons *retval)
 }
 
 
+/* BATCH */
+namespace ClipperUtils {
+    // Queue of independent boolean / offset operations of a single layer or region, executed at once by execute().
+    // All the operations of this file run on a ClipperLib::Clipper / ClipperOffset owned by the calling thread,
+    // which keeps its scratch buffers allocated between the calls. A batch additionally spreads the queued operations
+    // over the worker threads, each reusing its own Clipper engine.
+    // The queued operations must not depend on each other, and their inputs must stay valid until execute() returns.
+    // Spawning the tasks only pays off for large operations: Don't use a batch for a few small polygons
+    // or inside a loop, which already runs in parallel (over layers or regions).
+    //
+    //     ClipperUtils::Batch batch;
+    //     auto inner = batch.queue([&]{ return offset(last, - delta); });
+    //     auto outer = batch.queue([&]{ return offset(offsets, delta); });
+    //     batch.execute();
+    //     ExPolygons gaps = diff_ex(batch.take(inner), batch.take(outer));
+    class Batch {
+    public:
+        using Value = std::variant<std::monostate, Polygons, ExPolygons>;
+
+        // Handle to the result of a queued operation.
+        template<typename T>
+        class Result {
+        private:
+            explicit Result(size_t idx) : m_idx(idx) {}
+            size_t m_idx;
+            friend class Batch;
+        };
+
+        template<typename Operation>
+        Result<std::invoke_result_t<Operation>> queue(Operation &&operation) {
+            using T = std::invoke_result_t<Operation>;
+            static_assert(std::is_same_v<T, Polygons> || std::is_same_v<T, ExPolygons>, "ClipperUtils::Batch operation has to return Polygons or ExPolygons");
+            m_operations.emplace_back([operation = std::forward<Operation>(operation)](Value &out) { out = operation(); });
+            m_results.emplace_back();
+            return Result<T>(m_results.size() - 1);
+        }
+
+        // Execute the operations queued since the last execute(), in parallel if there are more of them.
+        void execute();
+
+        // Move the result of an executed operation out of the batch.
+        template<typename T>
+        T take(const Result<T> &result) {
+            assert(result.m_idx + m_operations.size() < m_results.size());
+            return std::move(std::get<T>(m_results[result.m_idx]));
+        }
+
+        // Release the queued operations and the results.
+        void clear() { m_operations.clear(); m_results.clear(); }
+
+    private:
+        // Operations not executed yet, producing the last m_operations.size() entries of m_results.
+        std::vector<std::function<void(Value&)>> m_operations;
+        std::vector<Value>                       m_results;
+    };
+}
+
 /* OTHER */
 Slic3r::Polygons simplify_polygons(const Slic3r::Polygons &subject);
 Slic3r::ExPolygons simplify_polygons_ex(const Slic3r::Polygons &subject);
@@ -64,6 +64,16 @@ public:
     double retract_length_toolchange() const;
     double retract_restart_extra_toolchange() const;
 
+    // State of the extruder axis and of the tachometer, see GCodeWriter::State.
+    struct State {
+        double E;
+        double absolute_E;
+        double retracted;
+        double restart_extra;
+    };
+    State  state() const { return { m_E, m_absolute_E, m_retracted, m_restart_extra }; }
+    void   set_state(const State &state) { m_E = state.E; m_absolute_E = state.absolute_E; m_retracted = state.retracted; m_restart_extra = state.restart_extra; }
+
 private:
     // Private constructor to create a key for a search in std::set.
     Extruder(unsigned int id) : m_id(id) {}
@@ -2,6 +2,7 @@
 #define slic3r_ExtrusionEntity_hpp_
 
 #include "libslic3r.h"
+#include "ExtrusionEntityArena.hpp"
 #include "ExtrusionRole.hpp"
 #include "Polygon.hpp"
 #include "Polyline.hpp"
@@ -28,6 +29,9 @@ public:
     // Create a new object, initialize it with this object using the move semantics.
     virtual ExtrusionEntity* clone_move() = 0;
     virtual ~ExtrusionEntity() = default;
+    // Placed into the ExtrusionEntityArena active on the current thread if there is one.
+    static void* operator new(size_t size) { return ExtrusionEntityArena::allocate(size); }
+    static void  operator delete(void *ptr) noexcept { ExtrusionEntityArena::deallocate(ptr); }
     virtual void reverse() = 0;
     virtual const Point& first_point() const = 0;
     virtual const Point& last_point() const = 0;
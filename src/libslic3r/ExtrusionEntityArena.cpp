@@ -0,0 +1,90 @@
+#include "ExtrusionEntityArena.hpp"
+
+#include <cassert>
+#include <new>
+
+namespace Slic3r {
+
+// Each allocation is prefixed with a pointer to its block, nullptr if allocated from the heap.
+static constexpr size_t header_size = alignof(std::max_align_t);
+
+static inline size_t align_up(size_t size) { return (size + header_size - 1) / header_size * header_size; }
+
+struct ExtrusionEntityArena::Block
+{
+    // Number of allocations placed into this block and not deleted yet, plus one while the block is being filled by its arena.
+    std::atomic<size_t> refcnt { 1 };
+    size_t              used   { 0 };
+
+    static size_t       data_offset() { return align_up(sizeof(Block)); }
+    static size_t       capacity()    { return block_size - data_offset(); }
+    char*               data()        { return reinterpret_cast<char*>(this) + data_offset(); }
+};
+
+static thread_local ExtrusionEntityArena *s_current_arena = nullptr;
+
+std::atomic<size_t> ExtrusionEntityArena::s_num_blocks_allocated { 0 };
+std::atomic<size_t> ExtrusionEntityArena::s_num_blocks_alive     { 0 };
+
+ExtrusionEntityArena::ExtrusionEntityArena() : m_parent(s_current_arena)
+{
+    s_current_arena = this;
+}
+
+ExtrusionEntityArena::~ExtrusionEntityArena()
+{
+    assert(s_current_arena == this);
+    s_current_arena = m_parent;
+    if (m_block)
+        release(m_block);
+}
+
+void* ExtrusionEntityArena::allocate(size_t size)
+{
+    const size_t          allocation_size = header_size + align_up(size);
+    ExtrusionEntityArena *arena           = s_current_arena;
+    if (arena == nullptr || allocation_size > Block::capacity() / 4) {
+        // No arena or a large collection, allocate from the heap.
+        char *header = static_cast<char*>(::operator new(header_size + size));
+        *reinterpret_cast<Block**>(header) = nullptr;
+        return header + header_size;
+    }
+    Block *block = arena->m_block;
+    if (block == nullptr || block->used + allocation_size > Block::capacity()) {
+        if (block)
+            // The block is released as soon as the entities placed into it are deleted.
+            release(block);
+        block = new (::operator new(block_size)) Block();
+        arena->m_block = block;
+        s_num_blocks_allocated.fetch_add(1, std::memory_order_relaxed);
+        s_num_blocks_alive.fetch_add(1, std::memory_order_relaxed);
+    }
+    char *header = block->data() + block->used;
+    block->used += allocation_size;
+    block->refcnt.fetch_add(1, std::memory_order_relaxed);
+    *reinterpret_cast<Block**>(header) = block;
+    return header + header_size;
+}
+
+void ExtrusionEntityArena::deallocate(void *ptr) noexcept
+{
+    if (ptr == nullptr)
+        return;
+    char  *header = static_cast<char*>(ptr) - header_size;
+    Block *block  = *reinterpret_cast<Block**>(header);
+    if (block == nullptr)
+        ::operator delete(header);
+    else
+        release(block);
+}
+
+void ExtrusionEntityArena::release(Block *block) noexcept
+{
+    if (block->refcnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        block->~Block();
+        ::operator delete(block);
+        s_num_blocks_alive.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace Slic3r
@@ -0,0 +1,50 @@
+#ifndef slic3r_ExtrusionEntityArena_hpp_
+#define slic3r_ExtrusionEntityArena_hpp_
+
+#include <atomic>
+#include <cstddef>
+
+namespace Slic3r {
+
+// Bump allocator for the ExtrusionEntities (paths, multi-paths, loops and collections) generated for a single layer.
+// While an ExtrusionEntityArena is alive, the ExtrusionEntities allocated by its thread are placed next to each other
+// into its blocks instead of being allocated one by one. The extrusions of a layer are deleted together when the layer
+// is invalidated, a block is returned to the system once all the entities placed into it were deleted.
+// The entities are still owned and deleted through raw pointers, thus an entity may outlive both the arena and its layer.
+class ExtrusionEntityArena
+{
+public:
+    ExtrusionEntityArena();
+    ~ExtrusionEntityArena();
+    ExtrusionEntityArena(const ExtrusionEntityArena &) = delete;
+    ExtrusionEntityArena& operator=(const ExtrusionEntityArena &) = delete;
+
+    // Allocate from the arena active on the current thread, from the heap if there is none. Called by ExtrusionEntity::operator new.
+    static void*    allocate(size_t size);
+    // Release memory returned by allocate(), possibly from another thread. Called by ExtrusionEntity::operator delete.
+    static void     deallocate(void *ptr) noexcept;
+
+    // Number of blocks allocated by all the arenas so far.
+    static size_t   num_blocks_allocated() { return s_num_blocks_allocated.load(std::memory_order_relaxed); }
+    // Number of blocks not yet returned to the system.
+    static size_t   num_blocks_alive() { return s_num_blocks_alive.load(std::memory_order_relaxed); }
+
+    // A block holds several hundreds of ExtrusionPaths.
+    static constexpr size_t block_size = 32768;
+
+private:
+    struct Block;
+    static void     release(Block *block) noexcept;
+
+    // Block being filled, nullptr before the first allocation.
+    Block                      *m_block  { nullptr };
+    // Arena active on this thread before this one, it is made active again by the destructor.
+    ExtrusionEntityArena       *m_parent { nullptr };
+
+    static std::atomic<size_t>  s_num_blocks_allocated;
+    static std::atomic<size_t>  s_num_blocks_alive;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_ExtrusionEntityArena_hpp_
@@ -8,6 +8,7 @@
 #include "../GCode/ThumbnailData.hpp"
 #include "../Semver.hpp"
 #include "../Time.hpp"
+#include "../Thread.hpp"
 
 #include "../I18N.hpp"
 
@@ -28,6 +29,11 @@
 #include <boost/spirit/include/qi_int.hpp>
 #include <boost/log/trivial.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+
 #include <boost/property_tree/xml_parser.hpp>
 namespace pt = boost::property_tree;
 
@@ -1725,10 +1731,17 @@ namespace Slic3r {
     {
         // appends the vertex coordinates
         // missing values are set equal to ZERO
-        m_curr_object.geometry.vertices.emplace_back(
-            m_unit_factor * get_attribute_value_float(attributes, num_attributes, X_ATTR),
-            m_unit_factor * get_attribute_value_float(attributes, num_attributes, Y_ATTR),
-            m_unit_factor * get_attribute_value_float(attributes, num_attributes, Z_ATTR));
+        // The attributes are parsed in a single pass, there may be millions of vertices.
+        Vec3f vertex = Vec3f::Zero();
+        for (unsigned int a = 0; a + 1 < num_attributes; a += 2) {
+            const char *key   = attributes[a];
+            const int   coord = ::strcmp(key, X_ATTR) == 0 ? 0 : ::strcmp(key, Y_ATTR) == 0 ? 1 : ::strcmp(key, Z_ATTR) == 0 ? 2 : -1;
+            if (coord != -1) {
+                const char *text = attributes[a + 1];
+                fast_float::from_chars(text, text + strlen(text), vertex[coord]);
+            }
+        }
+        m_curr_object.geometry.vertices.emplace_back(m_unit_factor * vertex);
         return true;
     }
 
@@ -1762,14 +1775,28 @@ namespace Slic3r {
 
         // appends the triangle's vertices indices
         // missing values are set equal to ZERO
-        m_curr_object.geometry.triangles.emplace_back(
-            get_attribute_value_int(attributes, num_attributes, V1_ATTR),
-            get_attribute_value_int(attributes, num_attributes, V2_ATTR),
-            get_attribute_value_int(attributes, num_attributes, V3_ATTR));
-
-        m_curr_object.geometry.custom_supports.push_back(get_attribute_value_string(attributes, num_attributes, CUSTOM_SUPPORTS_ATTR));
-        m_curr_object.geometry.custom_seam.push_back(get_attribute_value_string(attributes, num_attributes, CUSTOM_SEAM_ATTR));
-        m_curr_object.geometry.mmu_segmentation.push_back(get_attribute_value_string(attributes, num_attributes, MMU_SEGMENTATION_ATTR));
+        // The attributes are parsed in a single pass, there may be millions of triangles.
+        Vec3i       triangle         = Vec3i::Zero();
+        const char *custom_supports  = "";
+        const char *custom_seam      = "";
+        const char *mmu_segmentation = "";
+        for (unsigned int a = 0; a + 1 < num_attributes; a += 2) {
+            const char *key  = attributes[a];
+            const char *text = attributes[a + 1];
+            if (const int idx = ::strcmp(key, V1_ATTR) == 0 ? 0 : ::strcmp(key, V2_ATTR) == 0 ? 1 : ::strcmp(key, V3_ATTR) == 0 ? 2 : -1; idx != -1)
+                boost::spirit::qi::parse(text, text + strlen(text), boost::spirit::qi::int_, triangle[idx]);
+            else if (::strcmp(key, CUSTOM_SUPPORTS_ATTR) == 0)
+                custom_supports = text;
+            else if (::strcmp(key, CUSTOM_SEAM_ATTR) == 0)
+                custom_seam = text;
+            else if (::strcmp(key, MMU_SEGMENTATION_ATTR) == 0)
+                mmu_segmentation = text;
+        }
+        m_curr_object.geometry.triangles.emplace_back(triangle);
+
+        m_curr_object.geometry.custom_supports.emplace_back(custom_supports);
+        m_curr_object.geometry.custom_seam.emplace_back(custom_seam);
+        m_curr_object.geometry.mmu_segmentation.emplace_back(mmu_segmentation);
         return true;
     }
 
@@ -2760,55 +2787,47 @@ namespace Slic3r {
 
     bool _3MF_Exporter::_add_mesh_to_object_stream(mz_zip_writer_staged_context &context, ModelObject& object, VolumeToOffsetsMap& volumes_offsets)
     {
-        std::string output_buffer;
-        output_buffer += "   <";
-        output_buffer += MESH_TAG;
-        output_buffer += ">\n    <";
-        output_buffer += VERTICES_TAG;
-        output_buffer += ">\n";
-
-        auto flush = [this, &output_buffer, &context](bool force = false) {
-            if ((force && ! output_buffer.empty()) || output_buffer.size() >= 65536 * 16) {
-                if (! mz_zip_writer_add_staged_data(&context, output_buffer.data(), output_buffer.size())) {
-                    add_error("Error during writing or compression");
-                    return false;
-                }
-                output_buffer.clear();
-            }
-            return true;
+        // The vertices and triangles are formatted in blocks. The blocks are formatted in parallel in batches,
+        // while the previous batch is being compressed. All meshes are stored into the single model file
+        // of the 3MF archive, thus the compression itself is sequential.
+        // The blocks and batches are limited by the estimated size of their formatted text, which accounts for
+        // the painted triangle attributes. Two batches are held in memory at a time, thus about 2 * batch_bytes
+        // are buffered, exceeded only by a single triangle carrying more than block_bytes of painting data.
+        struct Block {
+            const ModelVolume *volume;
+            // Range of vertices or triangles of the volume.
+            bool               vertices;
+            int                begin;
+            int                end;
+            // Offset of the triangle vertex indices.
+            unsigned int       first_vertex_id;
+            // Estimated size of the formatted block.
+            size_t             bytes;
         };
-
-        auto format_coordinate = [](float f, char *buf) -> char* {
-            assert(is_decimal_separator_point());
-#if EXPORT_3MF_USE_SPIRIT_KARMA_FP
-            // Slightly faster than sprintf("%.9g"), but there is an issue with the karma floating point formatter,
-            // https://github.com/boostorg/spirit/pull/586
-            // where the exported string is one digit shorter than it should be to guarantee lossless round trip.
-            // The code is left here for the ocasion boost guys improve.
-            coordinate_type_fixed      const coordinate_fixed      = coordinate_type_fixed();
-            coordinate_type_scientific const coordinate_scientific = coordinate_type_scientific();
-            // Format "f" in a fixed format.
-            char *ptr = buf;
-            boost::spirit::karma::generate(ptr, coordinate_fixed, f);
-            // Format "f" in a scientific format.
-            char *ptr2 = ptr;
-            boost::spirit::karma::generate(ptr2, coordinate_scientific, f);
-            // Return end of the shorter string.
-            auto len2 = ptr2 - ptr;
-            if (ptr - buf > len2) {
-                // Move the shorter scientific form to the front.
-                memcpy(buf, ptr, len2);
-                ptr = buf + len2;
-            }
-            // Return pointer to the end.
-            return ptr;
-#else
-            // Round-trippable float, shortest possible.
-            return buf + sprintf(buf, "%.9g", f);
-#endif
+        static constexpr const int    block_size          = 16384;
+        static constexpr const size_t block_bytes         = 1 << 20;
+        static constexpr const size_t batch_bytes         = 16 << 20;
+        // Upper estimates of the lengths of the vertex and triangle lines without the painting attributes.
+        static constexpr const size_t vertex_line_bytes   = 80;
+        static constexpr const size_t triangle_line_bytes = 70;
+        const size_t                  batch_size          = std::clamp<size_t>(2 * size_t(tbb::this_task_arena::max_concurrency()), 2, 32);
+
+        // Appends the element of the given size to the block being accumulated, starts a new block if the current one is full.
+        std::vector<Block> blocks;
+        auto add_to_block = [&blocks](Block &block, int idx, size_t bytes) {
+            if (block.end > block.begin && (block.end - block.begin == block_size || block.bytes + bytes > block_bytes)) {
+                blocks.push_back(block);
+                block.begin = idx;
+                block.bytes = 0;
+            }
+            block.end    = idx + 1;
+            block.bytes += bytes;
+        };
+        auto finish_block = [&blocks](const Block &block) {
+            if (block.end > block.begin)
+                blocks.push_back(block);
         };
 
-        char buf[256];
         unsigned int vertices_count = 0;
         for (ModelVolume* volume : object.volumes) {
             if (volume == nullptr)
@@ -2823,37 +2842,17 @@ namespace Slic3r {
             }
 
             vertices_count += (int)its.vertices.size();
-
-            const Transform3d& matrix = volume->get_matrix();
-            for (const auto& vertex: its.vertices) {
-                Vec3f v = (matrix * vertex.cast<double>()).cast<float>();
-                char *ptr = buf;
-                boost::spirit::karma::generate(ptr, boost::spirit::lit("     <") << VERTEX_TAG << " x=\"");
-                ptr = format_coordinate(v.x(), ptr);
-                boost::spirit::karma::generate(ptr, "\" y=\"");
-                ptr = format_coordinate(v.y(), ptr);
-                boost::spirit::karma::generate(ptr, "\" z=\"");
-                ptr = format_coordinate(v.z(), ptr);
-                boost::spirit::karma::generate(ptr, "\"/>\n");
-                *ptr = '\0';
-                output_buffer += buf;
-                if (! flush())
-                    return false;
-            }
+            Block block{ volume, true, 0, 0, 0, 0 };
+            for (int i = 0; i < int(its.vertices.size()); ++ i)
+                add_to_block(block, i, vertex_line_bytes);
+            finish_block(block);
         }
 
-        output_buffer += "    </";
-        output_buffer += VERTICES_TAG;
-        output_buffer += ">\n    <";
-        output_buffer += TRIANGLES_TAG;
-        output_buffer += ">\n";
-
         unsigned int triangles_count = 0;
         for (ModelVolume* volume : object.volumes) {
             if (volume == nullptr)
                 continue;
 
-            bool is_left_handed = volume->is_left_handed();
             VolumeToOffsetsMap::iterator volume_it = volumes_offsets.find(volume);
             assert(volume_it != volumes_offsets.end());
 
@@ -2864,7 +2863,99 @@ namespace Slic3r {
             triangles_count += (int)its.indices.size();
             volume_it->second.last_triangle_id = triangles_count - 1;
 
+            // The painting data are stored as 4 bits per hexadecimal digit, sorted by the triangle index,
+            // see FacetsAnnotation::get_triangle_as_string().
+            const std::pair<const FacetsAnnotation*, size_t> annotations[] = {
+                { &volume->supported_facets,        strlen(CUSTOM_SUPPORTS_ATTR) + 4 },
+                { &volume->seam_facets,             strlen(CUSTOM_SEAM_ATTR) + 4 },
+                { &volume->mmu_segmentation_facets, strlen(MMU_SEGMENTATION_ATTR) + 4 }
+            };
+            size_t annotation_idx[] = { 0, 0, 0 };
+            Block  block{ volume, false, 0, 0, volume_it->second.first_vertex_id, 0 };
             for (int i = 0; i < int(its.indices.size()); ++ i) {
+                size_t bytes = triangle_line_bytes;
+                for (size_t k = 0; k < 3; ++ k) {
+                    const auto &[triangles, bitstream] = annotations[k].first->get_data();
+                    size_t     &idx = annotation_idx[k];
+                    while (idx < triangles.size() && triangles[idx].first < i)
+                        ++ idx;
+                    if (idx < triangles.size() && triangles[idx].first == i) {
+                        size_t end = idx + 1 < triangles.size() ? size_t(triangles[idx + 1].second) : bitstream.size();
+                        bytes += annotations[k].second + (end - size_t(triangles[idx].second)) / 4;
+                    }
+                }
+                add_to_block(block, i, bytes);
+            }
+            finish_block(block);
+        }
+
+        // Split the blocks into batches, batch i being formed by blocks [batches[i], batches[i + 1]).
+        std::vector<size_t> batches { 0 };
+        size_t              bytes_batched = 0;
+        for (size_t i = 0; i < blocks.size(); ++ i) {
+            if (i > batches.back() && (i - batches.back() == batch_size || bytes_batched + blocks[i].bytes > batch_bytes)) {
+                batches.push_back(i);
+                bytes_batched = 0;
+            }
+            bytes_batched += blocks[i].bytes;
+        }
+        if (! blocks.empty())
+            batches.push_back(blocks.size());
+
+        auto format_coordinate = [](float f, char *buf) -> char* {
+            assert(is_decimal_separator_point());
+#if EXPORT_3MF_USE_SPIRIT_KARMA_FP
+            // Slightly faster than sprintf("%.9g"), but there is an issue with the karma floating point formatter,
+            // https://github.com/boostorg/spirit/pull/586
+            // where the exported string is one digit shorter than it should be to guarantee lossless round trip.
+            // The code is left here for the ocasion boost guys improve.
+            coordinate_type_fixed      const coordinate_fixed      = coordinate_type_fixed();
+            coordinate_type_scientific const coordinate_scientific = coordinate_type_scientific();
+            // Format "f" in a fixed format.
+            char *ptr = buf;
+            boost::spirit::karma::generate(ptr, coordinate_fixed, f);
+            // Format "f" in a scientific format.
+            char *ptr2 = ptr;
+            boost::spirit::karma::generate(ptr2, coordinate_scientific, f);
+            // Return end of the shorter string.
+            auto len2 = ptr2 - ptr;
+            if (ptr - buf > len2) {
+                // Move the shorter scientific form to the front.
+                memcpy(buf, ptr, len2);
+                ptr = buf + len2;
+            }
+            // Return pointer to the end.
+            return ptr;
+#else
+            // Round-trippable float, shortest possible.
+            return buf + sprintf(buf, "%.9g", f);
+#endif
+        };
+
+        auto format_block = [&format_coordinate](const Block &block, std::string &output_buffer) {
+            char buf[256];
+            const indexed_triangle_set &its = block.volume->mesh().its;
+            if (block.vertices) {
+                const Transform3d& matrix = block.volume->get_matrix();
+                for (int i = block.begin; i < block.end; ++ i) {
+                    Vec3f v = (matrix * its.vertices[i].cast<double>()).cast<float>();
+                    char *ptr = buf;
+                    boost::spirit::karma::generate(ptr, boost::spirit::lit("     <") << VERTEX_TAG << " x=\"");
+                    ptr = format_coordinate(v.x(), ptr);
+                    boost::spirit::karma::generate(ptr, "\" y=\"");
+                    ptr = format_coordinate(v.y(), ptr);
+                    boost::spirit::karma::generate(ptr, "\" z=\"");
+                    ptr = format_coordinate(v.z(), ptr);
+                    boost::spirit::karma::generate(ptr, "\"/>\n");
+                    output_buffer.append(buf, ptr);
+                }
+                return;
+            }
+
+            const ModelVolume *volume          = block.volume;
+            bool               is_left_handed  = volume->is_left_handed();
+            unsigned int       first_vertex_id = block.first_vertex_id;
+            for (int i = block.begin; i < block.end; ++ i) {
                 {
                     const Vec3i &idx = its.indices[i];
                     char *ptr = buf;
@@ -2872,11 +2963,10 @@ namespace Slic3r {
                         " v1=\"" << boost::spirit::int_ <<
                         "\" v2=\"" << boost::spirit::int_ <<
                         "\" v3=\"" << boost::spirit::int_ << "\"",
-                        idx[is_left_handed ? 2 : 0] + volume_it->second.first_vertex_id,
-                        idx[1] + volume_it->second.first_vertex_id,
-                        idx[is_left_handed ? 0 : 2] + volume_it->second.first_vertex_id);
-                    *ptr = '\0';
-                    output_buffer += buf;
+                        idx[is_left_handed ? 2 : 0] + first_vertex_id,
+                        idx[1] + first_vertex_id,
+                        idx[is_left_handed ? 0 : 2] + first_vertex_id);
+                    output_buffer.append(buf, ptr);
                 }
 
                 std::string custom_supports_data_string = volume->supported_facets.get_triangle_as_string(i);
@@ -2907,20 +2997,67 @@ namespace Slic3r {
                 }
 
                 output_buffer += "/>\n";
+            }
+        };
+
+        // Formats the ibatch-th batch of blocks into out.
+        auto format_batch = [&blocks, &batches, &format_block](size_t ibatch, std::vector<std::string> &out) {
+            const size_t first_block = batches[ibatch];
+            out.resize(batches[ibatch + 1] - first_block);
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, out.size(), 1), [first_block, &blocks, &format_block, &out](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i) {
+                    out[i].clear();
+                    format_block(blocks[first_block + i], out[i]);
+                }
+            });
+        };
 
-                if (! flush())
+        auto write = [this, &context](const std::string &data) {
+            if (! data.empty() && ! mz_zip_writer_add_staged_data(&context, data.data(), data.size())) {
+                add_error("Error during writing or compression");
+                return false;
+            }
+            return true;
+        };
+
+        // Sets locales to "C" for the TBB worker threads formatting the blocks.
+        TBBLocalesSetter locales_setter;
+
+        const std::string open_triangles = std::string("    </") + VERTICES_TAG + ">\n    <" + TRIANGLES_TAG + ">\n";
+        bool              triangles_open = false;
+        if (! write(std::string("   <") + MESH_TAG + ">\n    <" + VERTICES_TAG + ">\n"))
+            return false;
+
+        std::vector<std::string> batch;
+        std::vector<std::string> next_batch;
+        tbb::task_group          formatter;
+        if (! blocks.empty())
+            format_batch(0, batch);
+        for (size_t ibatch = 0; ibatch + 1 < batches.size(); ++ ibatch) {
+            const size_t first_block = batches[ibatch];
+            if (ibatch + 2 < batches.size())
+                formatter.run([&format_batch, ibatch, &next_batch]() { format_batch(ibatch + 1, next_batch); });
+            for (size_t i = 0; i < batch.size(); ++ i) {
+                if (! blocks[first_block + i].vertices && ! triangles_open) {
+                    triangles_open = true;
+                    if (! write(open_triangles)) {
+                        formatter.wait();
+                        return false;
+                    }
+                }
+                if (! write(batch[i])) {
+                    formatter.wait();
                     return false;
+                }
             }
+            formatter.wait();
+            std::swap(batch, next_batch);
         }
 
-        output_buffer += "    </";
-        output_buffer += TRIANGLES_TAG;
-        output_buffer += ">\n   </";
-        output_buffer += MESH_TAG;
-        output_buffer += ">\n";
+        if (! triangles_open && ! write(open_triangles))
+            return false;
 
-        // Force flush.
-        return flush(true);
+        return write(std::string("    </") + TRIANGLES_TAG + ">\n   </" + MESH_TAG + ">\n");
     }
 
     void _3MF_Exporter::add_transformation(std::stringstream &stream, const Transform3d &tr)
@@ -3,6 +3,7 @@
 #include "SLA/RasterBase.hpp"
 #include "libslic3r/SLAPrint.hpp"
 
+#include <cstring>
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -29,8 +30,6 @@
 #define PREV_H 168
 #define PREV_DPI 42
 
-#define LAYER_SIZE_ESTIMATE (32 * 1024)
-
 namespace Slic3r {
 
 static void anycubicsla_get_pixel_span(const std::uint8_t* ptr, const std::uint8_t* end,
@@ -38,14 +37,22 @@ static void anycubicsla_get_pixel_span(const std::uint8_t* ptr, const std::uint8
 {
     size_t max_len;
 
-    span_len = 0;
     pixel = (*ptr) & 0xF0;
     // the maximum length of the span depends on the pixel color
     max_len = (pixel == 0 || pixel == 0xF0) ? 0xFFF : 0xF;
-    while (ptr < end && span_len < max_len && ((*ptr) & 0xF0) == pixel) {
-        span_len++;
-        ptr++;
+    const std::uint8_t *span_end = ptr + std::min(max_len, size_t(end - ptr));
+    const std::uint8_t *it       = ptr;
+    // Compare 8 pixels at once, most of a layer are long spans of fully transparent or opaque pixels.
+    const std::uint64_t mask    = 0xF0F0F0F0F0F0F0F0ull;
+    const std::uint64_t pattern = pixel * 0x0101010101010101ull;
+    for (std::uint64_t word; span_end - it >= 8; it += 8) {
+        std::memcpy(&word, it, 8);
+        if ((word & mask) != pattern)
+            break;
     }
+    while (it < span_end && ((*it) & 0xF0) == pixel)
+        ++it;
+    span_len = size_t(it - ptr);
 }
 
 struct AnycubicSLARasterEncoder
@@ -55,11 +62,14 @@ struct AnycubicSLARasterEncoder
                                   size_t      h,
                                   size_t      num_components)
     {
-        std::vector<uint8_t> dst;
+        // Encode into a buffer reused by the thread, so that the encoded layers kept until the export
+        // do not hold the capacity of a whole raw layer.
+        static thread_local std::vector<uint8_t> buffer;
         size_t               span_len;
         std::uint8_t         pixel;
         auto                 size = w * h * num_components;
-        dst.reserve(size);
+        buffer.clear();
+        buffer.reserve(size);
 
         const std::uint8_t *src = reinterpret_cast<const std::uint8_t *>(ptr);
         const std::uint8_t *src_end = src + size;
@@ -68,19 +78,15 @@ struct AnycubicSLARasterEncoder
             src += span_len;
             // fully transparent of fully opaque pixel
             if (pixel == 0 || pixel == 0xF0) {
-                pixel = pixel | (span_len >> 8);
-                std::copy(&pixel, (&pixel) + 1, std::back_inserter(dst));
-                pixel = span_len & 0xFF;
-                std::copy(&pixel, (&pixel) + 1, std::back_inserter(dst));
+                buffer.push_back(std::uint8_t(pixel | (span_len >> 8)));
+                buffer.push_back(std::uint8_t(span_len & 0xFF));
             }
             // antialiased pixel
-            else {
-                pixel = pixel | span_len;
-                std::copy(&pixel, (&pixel) + 1, std::back_inserter(dst));
-            }
+            else
+                buffer.push_back(std::uint8_t(pixel | span_len));
         }
 
-        return sla::EncodedRaster(std::move(dst), "pwimg");
+        return sla::EncodedRaster(std::vector<uint8_t>(buffer.begin(), buffer.end()), "pwimg");
     }
 };
 
@@ -503,7 +509,6 @@ void AnycubicSLAArchive::export_print(const std::string     fname,
     anycubicsla_format_preview       preview = {};
     anycubicsla_format_layers_header layers_header = {};
     anycubicsla_format_misc          misc = {};
-    std::vector<uint8_t>      layer_images;
     std::uint32_t             image_offset;
 
     assert(m_version == ANYCUBIC_SLA_FORMAT_VERSION_1);
@@ -534,7 +539,6 @@ void AnycubicSLAArchive::export_print(const std::string     fname,
         anycubicsla_write_layers_header(out, layers_header);
 
         //layers
-        layer_images.reserve(layer_count * LAYER_SIZE_ESTIMATE);
         image_offset = intro.image_data_offset;
         size_t i = 0;
         for (const sla::EncodedRaster &rst : m_layers) {
@@ -555,14 +559,12 @@ void AnycubicSLAArchive::export_print(const std::string     fname,
             }
             image_offset += l.image_size;
             anycubicsla_write_layer(out, l);
-            // add the rle encoded layer image into the buffer
-            const char* img_start = reinterpret_cast<const char*>(rst.data());
-            const char* img_end = img_start + rst.size();
-            std::copy(img_start, img_end, std::back_inserter(layer_images));
             i++;
         }
-        const char* img_buffer = reinterpret_cast<const char*>(layer_images.data());
-        out.write(img_buffer, layer_images.size());
+        // the rle encoded layer images follow the layer headers, write them
+        // directly without collecting them into a buffer first
+        for (const sla::EncodedRaster &rst : m_layers)
+            out.write(reinterpret_cast<const char*>(rst.data()), rst.size());
         out.close();
     } catch(std::exception& e) {
         BOOST_LOG_TRIVIAL(error) << e.what();
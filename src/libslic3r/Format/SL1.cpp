@@ -24,6 +24,7 @@
 #include "libslic3r/PNGReadWrite.hpp"
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Execution/ExecutionTBB.hpp"
+#include "libslic3r/Utils.hpp"
 
 #include "libslic3r/SLA/RasterBase.hpp"
 
@@ -32,6 +33,8 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <tbb/task_group.h>
+
 namespace Slic3r {
 
 using ConfMap = std::map<std::string, std::string>;
@@ -163,7 +166,8 @@ std::unique_ptr<sla::RasterBase> SL1Archive::create_raster() const
 
 sla::RasterEncoder SL1Archive::get_encoder() const
 {
-    return sla::PNGRasterEncoder{};
+    // Without anti-aliasing the layers are black and white only, compressed well enough by the fastest deflate.
+    return sla::PNGRasterEncoder{ m_cfg.gamma_correction.getFloat() > 0. ? MZ_DEFAULT_LEVEL : MZ_BEST_SPEED };
 }
 
 static void write_thumbnail(Zipper &zipper, const ThumbnailData &data)
@@ -184,6 +188,43 @@ static void write_thumbnail(Zipper &zipper, const ThumbnailData &data)
     }
 }
 
+// Compress the layer images in parallel, in batches of a bounded size, while
+// the previous batch is being written into the archive.
+static void write_layers(Zipper                                &zipper,
+                         const std::vector<sla::EncodedRaster> &layers,
+                         const std::string                     &project)
+{
+    static constexpr const size_t batch_size = 32;
+
+    std::vector<Zipper::CompressedEntry> batch;
+    std::vector<Zipper::CompressedEntry> next_batch;
+    auto compress_batch = [&zipper, &layers](size_t first, std::vector<Zipper::CompressedEntry> &out) {
+        out.resize(std::min(batch_size, layers.size() - first));
+        execution::for_each(ex_tbb, size_t(0), out.size(), [&zipper, &layers, &out, first](size_t i) {
+            const sla::EncodedRaster &rst = layers[first + i];
+            out[i] = zipper.compress_entry(rst.data(), rst.size());
+        });
+    };
+
+    tbb::task_group compressor;
+    // Don't let the compressor outlive the batches if writing throws.
+    ScopeGuard      wait_for_compressor([&compressor]() { try { compressor.wait(); } catch (...) {} });
+    if (! layers.empty())
+        compress_batch(0, batch);
+    for (size_t first = 0; first < layers.size(); first += batch_size) {
+        const size_t next_first = first + batch_size;
+        if (next_first < layers.size())
+            compressor.run([&compress_batch, &next_batch, next_first]() { compress_batch(next_first, next_batch); });
+        for (size_t i = 0; i < batch.size(); ++ i) {
+            std::string imgname = project + string_printf("%.5d", int(first + i)) + "." +
+                                  layers[first + i].extension();
+            zipper.add_entry(imgname, batch[i]);
+        }
+        compressor.wait();
+        std::swap(batch, next_batch);
+    }
+}
+
 void SL1Archive::export_print(Zipper               &zipper,
                               const SLAPrint       &print,
                               const ThumbnailsList &thumbnails,
@@ -207,14 +248,7 @@ void SL1Archive::export_print(Zipper               &zipper,
         zipper.add_entry("prusaslicer.ini");
         zipper << to_ini(slicerconf);
 
-        size_t i = 0;
-        for (const sla::EncodedRaster &rst : m_layers) {
-
-            std::string imgname = project + string_printf("%.5d", i++) + "." +
-                                  rst.extension();
-
-            zipper.add_entry(imgname.c_str(), rst.data(), rst.size());
-        }
+        write_layers(zipper, m_layers, project);
 
         for (const ThumbnailData& data : thumbnails)
             if (data.is_valid())
@@ -15,6 +15,7 @@
 #include "ShortestPath.hpp"
 #include "Print.hpp"
 #include "Thread.hpp"
+#include "Trace.hpp"
 #include "Utils.hpp"
 #include "ClipperUtils.hpp"
 #include "libslic3r.h"
@@ -25,6 +26,7 @@
 #include <cstdlib>
 #include <chrono>
 #include <math.h>
+#include <numeric>
 #include <string>
 #include <string_view>
 
@@ -857,6 +859,10 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         throw;
     }
     file.close();
+    if (file.is_error()) {
+        boost::nowide::remove(path_tmp.c_str());
+        throw Slic3r::RuntimeError(std::string("G-code export to ") + path + " failed\nIs the disk full?\n");
+    }
 
     if (! m_placeholder_parser_integration.failed_templates.empty()) {
         // G-code export proceeded, but some of the PlaceholderParser substitutions failed.
@@ -1041,6 +1047,78 @@ namespace DoExport {
         }
         return filament_stats_string_out;
     }
+
+    // Fingerprint of the inputs of GCode::process_layer() of a non-sequential print, see GCodeLayersCache.
+    static size_t layers_fingerprint(const Print &print)
+    {
+        // Configuration keys consumed only before the first layer / after the last layer (and not changing the state
+        // of the G-code generator at the start of the first layer) or by the CoolingBuffer and find / replace filters,
+        // which process the cached layers again. The time stamp keys are ignored as well.
+        // Note that end_filament_gcode is not on the list, it is emitted by GCode::set_extruder() at each tool change.
+        static const std::set<std::string_view> ignored_keys {
+            "notes", "thumbnails", "thumbnails_format", "remaining_times", "post_process", "output_filename_format",
+            "end_gcode", "gcode_substitutions",
+            "cooling", "fan_always_on", "min_fan_speed", "max_fan_speed", "bridge_fan_speed", "disable_fan_first_layers",
+            "full_fan_speed_layer", "fan_below_layer_time", "slowdown_below_layer_time", "min_print_speed",
+            "timestamp", "year", "month", "day", "hour", "minute", "second"
+        };
+        // Any of the keys above may be referenced by a custom G-code, which is expanded inside the layers or which
+        // sets a global variable read by the layers. Such a key is not ignored. A key is considered referenced
+        // if its name appears anywhere in the template, which is conservative.
+        const PrintConfig &print_config = print.config();
+        std::vector<const std::string*> templates {
+            &print_config.start_gcode.value, &print_config.before_layer_gcode.value, &print_config.layer_gcode.value,
+            &print_config.toolchange_gcode.value, &print_config.color_change_gcode.value, &print_config.pause_print_gcode.value,
+            &print_config.template_custom_gcode.value
+        };
+        for (const std::string &templ : print_config.start_filament_gcode.values)
+            templates.emplace_back(&templ);
+        for (const std::string &templ : print_config.end_filament_gcode.values)
+            templates.emplace_back(&templ);
+        auto is_ignored = [&templates](const std::string &key) {
+            return ignored_keys.find(key) != ignored_keys.end() &&
+                std::none_of(templates.begin(), templates.end(), [&key](const std::string *templ) { return templ->find(key) != std::string::npos; });
+        };
+        size_t seed = 0;
+        auto hash_config = [&seed, &is_ignored](const ConfigBase &config) {
+            for (const std::string &key : config.keys())
+                if (! is_ignored(key)) {
+                    boost::hash_combine(seed, key);
+                    boost::hash_combine(seed, config.option(key)->hash());
+                }
+        };
+        hash_config(print.full_print_config());
+        hash_config(print.placeholder_parser().config());
+        for (const PrintObject *object : print.objects()) {
+            boost::hash_combine(seed, object->id().id);
+            boost::hash_combine(seed, object->config().hash());
+            boost::hash_combine(seed, object->model_object()->name);
+            for (const PrintInstance &instance : object->instances()) {
+                boost::hash_combine(seed, instance.shift.x());
+                boost::hash_combine(seed, instance.shift.y());
+            }
+            // Any change of the slices, perimeters, infill or supports bumps the time stamp of the respective step.
+            for (int step = 0; step < int(posCount); ++ step)
+                boost::hash_combine(seed, object->step_state_with_timestamp(PrintObjectStep(step)).timestamp);
+        }
+        for (size_t region_id = 0; region_id < print.num_print_regions(); ++ region_id)
+            boost::hash_combine(seed, print.get_print_region(region_id).config().hash());
+        for (int step = 0; step < int(psCount); ++ step)
+            if (step != int(psGCodeExport))
+                boost::hash_combine(seed, print.step_state_with_timestamp(PrintStep(step)).timestamp);
+        // Color changes, pauses and custom G-codes inserted at print_z.
+        const CustomGCode::Info &custom_gcodes = print.model().custom_gcode_per_print_z;
+        boost::hash_combine(seed, int(custom_gcodes.mode));
+        for (const CustomGCode::Item &item : custom_gcodes.gcodes) {
+            boost::hash_combine(seed, item.print_z);
+            boost::hash_combine(seed, int(item.type));
+            boost::hash_combine(seed, item.extruder);
+            boost::hash_combine(seed, item.color);
+            boost::hash_combine(seed, item.extra);
+        }
+        // Zero is reserved for "no fingerprint".
+        return std::max<size_t>(seed, 1);
+    }
 }
 
 #if 0
@@ -1082,6 +1160,7 @@ std::vector<const PrintInstance*> sort_object_instances_by_model_order(const Pri
 
 void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGeneratorCallback thumbnail_cb)
 {
+    SLIC3R_TRACE_SCOPE("GCode::_do_export");
     // modifies m_silent_time_estimator_enabled
     DoExport::init_gcode_processor(print.config(), m_processor, m_silent_time_estimator_enabled);
 
@@ -1330,9 +1409,22 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
 
     print.throw_if_canceled();
 
-    // Collect custom seam data from all objects.
-    std::function<void(void)> throw_if_canceled_func = [&print]() { print.throw_if_canceled();};
-    m_seam_placer.init(print, throw_if_canceled_func);
+    // Reuse the G-code of the layers generated by the last export if none of their inputs changed.
+    // Only for a non-sequential print and not in the low memory mode, where the layers are released while exported.
+    const size_t layers_fingerprint = print.config().complete_objects.value || print.low_memory_mode() ? 0 : DoExport::layers_fingerprint(print);
+    std::shared_ptr<const GCodeLayersCache> layers_cache;
+    if (layers_fingerprint != 0 && print.m_gcode_layers_cache && print.m_gcode_layers_cache->fingerprint == layers_fingerprint) {
+        ++ print.m_gcode_layers_cache->num_reused;
+        layers_cache = print.m_gcode_layers_cache;
+    } else
+        // Release the stale cache before the layers are generated again.
+        print.m_gcode_layers_cache.reset();
+
+    if (! layers_cache) {
+        // Collect custom seam data from all objects.
+        std::function<void(void)> throw_if_canceled_func = [&print]() { print.throw_if_canceled();};
+        m_seam_placer.init(print, throw_if_canceled_func);
+    }
 
     if (! (has_wipe_tower && print.config().single_extruder_multi_material_priming)) {
         // Set initial extruder only after custom start G-code.
@@ -1384,13 +1476,20 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
             // Process all layers of a single object instance (sequential mode) with a parallel pipeline:
             // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
             // and export G-code into file.
-            this->process_layers(print, tool_ordering, collect_layers_to_print(object), *print_object_instance_sequential_active - object.instances().data(), file);
+            // In low memory mode, the layers of the object are released after its last instance is printed.
+            const bool release_layers = print.low_memory_mode() &&
+                std::none_of(print_object_instance_sequential_active + 1, print_object_instances_ordering.cend(),
+                    [&object](const PrintInstance *instance) { return instance->print_object == &object; });
+            this->process_layers(print, tool_ordering, collect_layers_to_print(object), *print_object_instance_sequential_active - object.instances().data(), release_layers, file);
             ++ finished_objects;
             // Flag indicating whether the nozzle temperature changes from 1st to 2nd layer were performed.
             // Reset it when starting another object from 1st layer.
             m_second_layer_things_done = false;
             prev_object = &object;
         }
+        // Write end commands to file.
+        file.write(this->retract());
+        file.write(m_writer.set_fan(0));
     } else {
         // Sort layers by Z.
         // All extrusion moves with the same top layer height are extruded uninterrupted.
@@ -1437,19 +1536,48 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
             }
             print.throw_if_canceled();
         }
-        // Process all layers of all objects (non-sequential mode) with a parallel pipeline:
-        // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
-        // and export G-code into file.
-        this->process_layers(print, tool_ordering, print_object_instances_ordering, layers_to_print, file);
-        if (m_wipe_tower)
-            // Purge the extruder, pull out the active filament.
-            file.write(m_wipe_tower->finalize(*this));
+        if (layers_cache) {
+            BOOST_LOG_TRIVIAL(debug) << "Reusing the G-code of " << layers_cache->layers.size() << " layers of the last export";
+            // Run the G-code of the layers cached by the last export through the filters (vase mode, cooling buffer),
+            // run the G-code analyser and export G-code into file.
+            this->process_layers(print, tool_ordering, print_object_instances_ordering, layers_to_print, &layers_cache->layers, nullptr, file);
+            file.write(layers_cache->end_of_layers_gcode);
+            // Continue with the state of the G-code generator after the last layer.
+            m_writer.set_state(layers_cache->writer_state);
+            m_layer_index = layers_cache->layer_index;
+            m_max_layer_z = layers_cache->max_layer_z;
+            // Only restore the placeholder parser variables modified by the layers. The rest of the placeholder parser
+            // configuration, including the time stamp and the keys ignored by the fingerprint, is the current one.
+            this->placeholder_parser().set("current_extruder", layers_cache->current_extruder);
+            *m_placeholder_parser_integration.context.global_config = layers_cache->placeholder_parser_global_config;
+        } else {
+            std::shared_ptr<GCodeLayersCache> new_cache = layers_fingerprint == 0 ? nullptr : std::make_shared<GCodeLayersCache>();
+            // Process all layers of all objects (non-sequential mode) with a parallel pipeline:
+            // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
+            // and export G-code into file.
+            this->process_layers(print, tool_ordering, print_object_instances_ordering, layers_to_print, nullptr, new_cache ? &new_cache->layers : nullptr, file);
+            std::string end_of_layers_gcode;
+            if (m_wipe_tower)
+                // Purge the extruder, pull out the active filament.
+                end_of_layers_gcode = m_wipe_tower->finalize(*this);
+            // Write end commands to file.
+            end_of_layers_gcode += this->retract();
+            end_of_layers_gcode += m_writer.set_fan(0);
+            file.write(end_of_layers_gcode);
+            // Don't cache the layers if a custom G-code failed to process, the export will be rejected.
+            if (new_cache && m_placeholder_parser_integration.failed_templates.empty()) {
+                new_cache->fingerprint                      = layers_fingerprint;
+                new_cache->end_of_layers_gcode              = std::move(end_of_layers_gcode);
+                new_cache->writer_state                     = m_writer.state();
+                new_cache->layer_index                      = m_layer_index;
+                new_cache->max_layer_z                      = m_max_layer_z;
+                new_cache->current_extruder                 = this->placeholder_parser().config().opt_int("current_extruder");
+                new_cache->placeholder_parser_global_config = *m_placeholder_parser_integration.context.global_config;
+                print.m_gcode_layers_cache = std::move(new_cache);
+            }
+        }
     }
 
-    // Write end commands to file.
-    file.write(this->retract());
-    file.write(m_writer.set_fan(0));
-
     // adds tag for processor
     file.write_format(";%s%s\n", GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Role).c_str(), gcode_extrusion_role_to_string(GCodeExtrusionRole::Custom).c_str());
 
@@ -1515,6 +1643,57 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
     print.throw_if_canceled();
 }
 
+// Print::low_memory_mode(): Release the slices and extrusions of the layers just converted to G-code.
+// The G-code generator accesses the layers being exported, all data needed from the preceding layers
+// (overhang boundaries, curled extrusions, seams) is cached by the G-code generator. The only exception
+// are the lslices of the object layers read by AvoidCrossingPerimeters: The external boundary is collected
+// from the object layers of all objects at the print_z being exported and, for a support layer, from the last
+// object layer below the print_z of each object. If keep_lslices is set, the lslices of the object layers
+// are not released, see release_lslices_below().
+static void release_exported_layers(const GCode::ObjectsLayerToPrint &layers, bool keep_lslices)
+{
+    for (const GCode::ObjectLayerToPrint &layer : layers) {
+        // The layers are owned by their PrintObjects, which are modifiable by the caller of GCode::do_export().
+        if (layer.object_layer) {
+            Layer *object_layer = const_cast<Layer*>(layer.object_layer);
+            object_layer->release_exported_data();
+            if (! keep_lslices)
+                object_layer->release_lslices();
+        }
+        if (layer.support_layer) {
+            // lslices of a support layer are only read while exporting the support layer itself.
+            SupportLayer *support_layer = const_cast<SupportLayer*>(layer.support_layer);
+            support_layer->release_exported_data();
+            support_layer->release_lslices();
+        }
+    }
+}
+
+// Print::low_memory_mode() with avoid_crossing_perimeters, non-sequential print: The lslices of the last exported
+// layer of each object are read by AvoidCrossingPerimeters up to and including the print_z of the next layer of the same
+// object. Once the layers at the print_z of the next layer were exported, the lslices of the layer below are released.
+// last_object_layers holds the last exported layer of each object, all of them are released after the last layer.
+static void release_lslices_below(const GCode::ObjectsLayerToPrint &layers, std::vector<Layer*> &last_object_layers, bool last_layer)
+{
+    for (const GCode::ObjectLayerToPrint &layer : layers)
+        if (layer.object_layer) {
+            Layer *object_layer = const_cast<Layer*>(layer.object_layer);
+            auto   it           = std::find_if(last_object_layers.begin(), last_object_layers.end(),
+                [object_layer](const Layer *l) { return l->object() == object_layer->object(); });
+            if (it == last_object_layers.end()) {
+                last_object_layers.emplace_back(object_layer);
+            } else {
+                (*it)->release_lslices();
+                *it = object_layer;
+            }
+        }
+    if (last_layer) {
+        for (Layer *layer : last_object_layers)
+            layer->release_lslices();
+        last_object_layers.clear();
+    }
+}
+
 // Process all layers of all objects (non-sequential mode) with a parallel pipeline:
 // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
 // and export G-code into file.
@@ -1523,41 +1702,102 @@ void GCode::process_layers(
     const ToolOrdering                                                  &tool_ordering,
     const std::vector<const PrintInstance*>                             &print_object_instances_ordering,
     const std::vector<std::pair<coordf_t, ObjectsLayerToPrint>>         &layers_to_print,
+    const std::vector<LayerResult>                                      *cached_layers,
+    std::vector<LayerResult>                                            *layers_to_cache,
     GCodeOutputStream                                                   &output_stream)
 {
+    assert(cached_layers == nullptr || cached_layers->size() == layers_to_print.size());
     // The pipeline is variable: The vase mode filter is optional.
-    size_t layer_to_print_idx = 0;
-    const auto generator = tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> LayerResult {
-            if (layer_to_print_idx >= layers_to_print.size()) {
-                if ((!m_pressure_equalizer && layer_to_print_idx == layers_to_print.size()) || (m_pressure_equalizer && layer_to_print_idx == (layers_to_print.size() + 1))) {
-                    fc.stop();
-                    return {};
-                } else {
-                    // Pressure equalizer need insert empty input. Because it returns one layer back.
-                    // Insert NOP (no operation) layer;
-                    ++layer_to_print_idx;
-                    return LayerResult::make_nop_layer_result();
+    // Index of a layer to print passed from next_layer over prepare to generator, layers_to_print.size() for the NOP layer
+    // of the pressure equalizer. The data of the layer independent of the G-code emitted so far are built by prepare.
+    // The G-code itself is emitted by the serial generator: The extrusions are chained starting from the last position
+    // of the layer below and the extruder state (E, retraction, Z, fan) is carried from layer to layer.
+    struct PreparedLayer {
+        size_t                                                    layer_to_print_idx { 0 };
+        AvoidCrossingPerimeters::PreparedLayers                   avoid_crossing_perimeters;
+        std::vector<ExtrusionQualityEstimator::LayerDistancers>   extrusion_quality;
+    };
+    size_t next_layer_idx = 0;
+    // Pressure equalizer need insert empty input. Because it returns one layer back.
+    const size_t num_layers = layers_to_print.size() + (m_pressure_equalizer ? 1 : 0);
+    const auto next_layer = tbb::make_filter<void, PreparedLayer>(slic3r_tbb_filtermode::serial_in_order,
+        [&next_layer_idx, num_layers](tbb::flow_control& fc) -> PreparedLayer {
+            if (next_layer_idx == num_layers) {
+                fc.stop();
+                return {};
+            }
+            return { next_layer_idx ++ };
+        });
+    // The AvoidCrossingPerimeters boundaries are built for several layers in parallel ahead of the serial G-code generator.
+    // Not in Print::low_memory_mode(): The boundaries read the lslices of the object layers below, which are being
+    // released by the generator. The boundaries for travels around the objects are only needed with multiple instances
+    // or with a wipe tower. Boundaries not prepared are built by AvoidCrossingPerimeters on demand.
+    const bool prepare_avoid_crossing_perimeters = cached_layers == nullptr && print.config().avoid_crossing_perimeters && ! print.low_memory_mode();
+    const bool prepare_external_boundary         = m_wipe_tower ||
+        std::accumulate(print.objects().begin(), print.objects().end(), size_t(0), [](size_t n, const PrintObject *object){ return n + object->instances().size(); }) > 1;
+    // The distancers of ExtrusionQualityEstimator only read the object layers at print_z, they are prepared in low memory mode as well.
+    const auto prepare = tbb::make_filter<PreparedLayer, PreparedLayer>(slic3r_tbb_filtermode::parallel,
+        [&print, &layers_to_print, cached_layers, prepare_avoid_crossing_perimeters, prepare_external_boundary](PreparedLayer in) -> PreparedLayer {
+            if (cached_layers == nullptr && in.layer_to_print_idx < layers_to_print.size() && ! print.canceled()) {
+                SLIC3R_TRACE_SCOPE_ARG("GCode::prepare_layer", in.layer_to_print_idx);
+                const ObjectsLayerToPrint &layers = layers_to_print[in.layer_to_print_idx].second;
+                in.extrusion_quality.reserve(layers.size());
+                for (const ObjectLayerToPrint &layer : layers)
+                    if (layer.object_layer)
+                        in.extrusion_quality.emplace_back(ExtrusionQualityEstimator::make_layer_distancers(layer.object_layer));
+                if (prepare_avoid_crossing_perimeters) {
+                    std::vector<const Layer*> layers_avoid_crossing;
+                    for (const ObjectLayerToPrint &layer : layers)
+                        layers_avoid_crossing.emplace_back(layer.layer());
+                    in.avoid_crossing_perimeters = AvoidCrossingPerimeters::prepare_layers(layers_avoid_crossing, prepare_external_boundary);
                 }
+            }
+            return in;
+        });
+    // Print::low_memory_mode(): Layers, whose lslices are still read by AvoidCrossingPerimeters.
+    std::vector<Layer*> last_object_layers;
+    const auto generate = tbb::make_filter<PreparedLayer, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print, &last_object_layers, cached_layers, layers_to_cache](PreparedLayer in) -> LayerResult {
+            const size_t layer_to_print_idx = in.layer_to_print_idx;
+            if (layer_to_print_idx == layers_to_print.size()) {
+                // Insert NOP (no operation) layer for the pressure equalizer.
+                return LayerResult::make_nop_layer_result();
+            } else if (cached_layers) {
+                return (*cached_layers)[layer_to_print_idx];
             } else {
-                const std::pair<coordf_t, ObjectsLayerToPrint> &layer = layers_to_print[layer_to_print_idx++];
+                const std::pair<coordf_t, ObjectsLayerToPrint> &layer = layers_to_print[layer_to_print_idx];
                 const LayerTools& layer_tools = tool_ordering.tools_for_layer(layer.first);
                 if (m_wipe_tower && layer_tools.has_wipe_tower)
                     m_wipe_tower->next_layer();
                 print.throw_if_canceled();
-                return this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, size_t(-1));
+                SLIC3R_TRACE_SCOPE_ARG("GCode::process_layer", layer_to_print_idx);
+                m_avoid_crossing_perimeters.set_prepared_layers(std::move(in.avoid_crossing_perimeters));
+                m_extrusion_quality_estimator.set_prepared_layers(std::move(in.extrusion_quality));
+                LayerResult result = this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, size_t(-1));
+                if (layers_to_cache)
+                    layers_to_cache->emplace_back(result);
+                if (print.low_memory_mode()) {
+                    const bool keep_lslices = print.config().avoid_crossing_perimeters.value;
+                    release_exported_layers(layer.second, keep_lslices);
+                    if (keep_lslices)
+                        release_lslices_below(layer.second, last_object_layers, &layer == &layers_to_print.back());
+                }
+                return result;
             }
         });
+    const auto generator = next_layer & prepare & generate;
     const auto spiral_vase = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
         [spiral_vase = this->m_spiral_vase.get()](LayerResult in) -> LayerResult {
             if (in.nop_layer_result)
                 return in;
 
+            SLIC3R_TRACE_SCOPE_ARG("GCode::SpiralVase", in.layer_id);
             spiral_vase->enable(in.spiral_vase_enable);
             return { spiral_vase->process_layer(std::move(in.gcode)), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush};
         });
     const auto pressure_equalizer = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
         [pressure_equalizer = this->m_pressure_equalizer.get()](LayerResult in) -> LayerResult {
+            SLIC3R_TRACE_SCOPE_ARG("GCode::PressureEqualizer", in.layer_id);
             return pressure_equalizer->process_layer(std::move(in));
         });
     const auto cooling = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
@@ -1565,14 +1805,19 @@ void GCode::process_layers(
              if (in.nop_layer_result)
                 return in.gcode;
 
+             SLIC3R_TRACE_SCOPE_ARG("GCode::CoolingBuffer", in.layer_id);
              return cooling_buffer->process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
         });
     const auto find_replace = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
         [find_replace = this->m_find_replace.get()](std::string s) -> std::string {
+            SLIC3R_TRACE_SCOPE("GCode::GCodeFindReplace");
             return find_replace->process_layer(std::move(s));
         });
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+        [&output_stream](std::string s) {
+            SLIC3R_TRACE_SCOPE("GCode::output");
+            output_stream.write(s);
+        }
     );
 
     // It registers a handler that sets locales to "C" before any TBB thread starts participating in tbb::parallel_pipeline.
@@ -1608,12 +1853,13 @@ void GCode::process_layers(
     const ToolOrdering                      &tool_ordering,
     ObjectsLayerToPrint                      layers_to_print,
     const size_t                             single_object_idx,
+    const bool                               release_layers,
     GCodeOutputStream                       &output_stream)
 {
     // The pipeline is variable: The vase mode filter is optional.
     size_t layer_to_print_idx = 0;
     const auto generator = tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &tool_ordering, &layers_to_print, &layer_to_print_idx, single_object_idx](tbb::flow_control& fc) -> LayerResult {
+        [this, &print, &tool_ordering, &layers_to_print, &layer_to_print_idx, single_object_idx, release_layers](tbb::flow_control& fc) -> LayerResult {
             if (layer_to_print_idx >= layers_to_print.size()) {
                 if ((!m_pressure_equalizer && layer_to_print_idx == layers_to_print.size()) || (m_pressure_equalizer && layer_to_print_idx == (layers_to_print.size() + 1))) {
                     fc.stop();
@@ -1627,32 +1873,45 @@ void GCode::process_layers(
             } else {
                 ObjectLayerToPrint &layer = layers_to_print[layer_to_print_idx ++];
                 print.throw_if_canceled();
-                return this->process_layer(print, { std::move(layer) }, tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back(), nullptr, single_object_idx);
+                SLIC3R_TRACE_SCOPE_ARG("GCode::process_layer", layer_to_print_idx - 1);
+                LayerResult result = this->process_layer(print, { layer }, tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back(), nullptr, single_object_idx);
+                if (release_layers)
+                    // AvoidCrossingPerimeters reads the lslices of all objects at print_z, thus they are kept
+                    // until the objects printed later were exported.
+                    release_exported_layers({ layer }, print.config().avoid_crossing_perimeters.value);
+                return result;
             }
         });
     const auto spiral_vase = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
         [spiral_vase = this->m_spiral_vase.get()](LayerResult in)->LayerResult {
             if (in.nop_layer_result)
                 return in;
+            SLIC3R_TRACE_SCOPE_ARG("GCode::SpiralVase", in.layer_id);
             spiral_vase->enable(in.spiral_vase_enable);
             return { spiral_vase->process_layer(std::move(in.gcode)), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush };
         });
     const auto pressure_equalizer = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
         [pressure_equalizer = this->m_pressure_equalizer.get()](LayerResult in) -> LayerResult {
+             SLIC3R_TRACE_SCOPE_ARG("GCode::PressureEqualizer", in.layer_id);
              return pressure_equalizer->process_layer(std::move(in));
         });
     const auto cooling = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
         [cooling_buffer = this->m_cooling_buffer.get()](LayerResult in)->std::string {
             if (in.nop_layer_result)
                 return in.gcode;
+            SLIC3R_TRACE_SCOPE_ARG("GCode::CoolingBuffer", in.layer_id);
             return cooling_buffer->process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
         });
     const auto find_replace = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
         [find_replace = this->m_find_replace.get()](std::string s) -> std::string {
+            SLIC3R_TRACE_SCOPE("GCode::GCodeFindReplace");
             return find_replace->process_layer(std::move(s));
         });
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+        [&output_stream](std::string s) {
+            SLIC3R_TRACE_SCOPE("GCode::output");
+            output_stream.write(s);
+        }
     );
 
     // It registers a handler that sets locales to "C" before any TBB thread starts participating in tbb::parallel_pipeline.
@@ -2697,7 +2956,7 @@ std::string GCode::extrude_loop(ExtrusionLoop loop, const std::string_view descr
     std::string gcode;
     for (ExtrusionPath &path : paths) {
         path.simplify(m_scaled_resolution);
-        gcode += this->_extrude(path, description, speed);
+        this->_extrude(gcode, path, description, speed);
     }
 
     // reset acceleration
@@ -2752,7 +3011,7 @@ std::string GCode::extrude_loop(ExtrusionLoop loop, const std::string_view descr
         // Rotate pt inside around the seam point.
         pt.rotate(angle_inside / 3., paths.front().polyline.points.front());
         // generate the travel move
-        gcode += m_writer.travel_to_xy(this->point_to_gcode(pt), "move inwards before travel");
+        m_writer.travel_to_xy(gcode, this->point_to_gcode(pt), "move inwards before travel");
     }
 
     return gcode;
@@ -2768,7 +3027,7 @@ std::string GCode::extrude_multi_path(ExtrusionMultiPath multipath, const std::s
     std::string gcode;
     for (ExtrusionPath path : multipath.paths) {
         path.simplify(m_scaled_resolution);
-        gcode += this->_extrude(path, description, speed);
+        this->_extrude(gcode, path, description, speed);
     }
     if (m_wipe.enable) {
         m_wipe.path = std::move(multipath.paths.back().polyline);
@@ -2807,7 +3066,8 @@ std::string GCode::extrude_entity(const ExtrusionEntity &entity, const std::stri
 std::string GCode::extrude_path(ExtrusionPath path, std::string_view description, double speed)
 {
     path.simplify(m_scaled_resolution);
-    std::string gcode = this->_extrude(path, description, speed);
+    std::string gcode;
+    this->_extrude(gcode, path, description, speed);
     if (m_wipe.enable) {
         m_wipe.path = std::move(path.polyline);
         m_wipe.path.reverse();
@@ -2852,31 +3112,69 @@ std::string GCode::extrude_support(const ExtrusionEntityCollection &support_fill
 
 bool GCode::GCodeOutputStream::is_error() const 
 {
-    return ::ferror(this->f);
+    return m_write_failed || (this->f != nullptr && ::ferror(this->f));
 }
 
 void GCode::GCodeOutputStream::flush()
 { 
-    ::fflush(this->f);
+    this->write_buffer();
+    m_writer.wait();
+    if (::fflush(this->f) != 0)
+        m_write_failed = true;
 }
 
 void GCode::GCodeOutputStream::close()
 { 
     if (this->f) {
-        ::fclose(this->f);
+        this->write_buffer();
+        m_writer.wait();
+        // fclose() flushes the stdio buffer, which may fail as well.
+        if (::ferror(this->f) || ::fclose(this->f) != 0)
+            m_write_failed = true;
         this->f = nullptr;
     }
 }
 
+void GCode::GCodeOutputStream::write(const std::string &what)
+{
+    if (m_find_replace) {
+        std::string gcode = m_find_replace->process_layer(what);
+        this->append(gcode.data(), gcode.size());
+    } else
+        this->append(what.data(), what.size());
+}
+
 void GCode::GCodeOutputStream::write(const char *what)
 {
-    if (what != nullptr) {
-        //FIXME don't allocate a string, maybe process a batch of lines?
-        std::string gcode(m_find_replace ? m_find_replace->process_layer(what) : what);
-        // writes string to file
-        fwrite(gcode.c_str(), 1, gcode.size(), this->f);
-        m_processor.process_buffer(gcode);
-    }
+    if (what == nullptr)
+        return;
+    if (m_find_replace)
+        this->write(std::string(what));
+    else
+        this->append(what, strlen(what));
+}
+
+void GCode::GCodeOutputStream::append(const char *data, size_t size)
+{
+    m_buffer.append(data, size);
+    if (m_buffer.size() >= 1024 * 1024)
+        this->write_buffer();
+}
+
+void GCode::GCodeOutputStream::write_buffer()
+{
+    if (m_buffer.empty())
+        return;
+    // The G-code processor parses the collected G-code in one go instead of a call per write().
+    m_processor.process_buffer(m_buffer);
+    // Wait for the previous write, then hand over the collected G-code to the background writer.
+    m_writer.wait();
+    m_buffer_writing.swap(m_buffer);
+    m_buffer.clear();
+    m_writer.run([this]() {
+        if (::fwrite(m_buffer_writing.data(), 1, m_buffer_writing.size(), this->f) != m_buffer_writing.size())
+            m_write_failed = true;
+    });
 }
 
 void GCode::GCodeOutputStream::writeln(const std::string &what)
@@ -2917,9 +3215,8 @@ void GCode::GCodeOutputStream::write_format(const char* format, ...)
     va_end(args);
 }
 
-std::string GCode::_extrude(const ExtrusionPath &path, const std::string_view description, double speed)
+void GCode::_extrude(std::string &gcode, const ExtrusionPath &path, const std::string_view description, double speed)
 {
-    std::string gcode;
     const std::string_view description_bridge = path.role().is_bridge() ? " (bridge)"sv : ""sv;
 
     // go to first point of extrusion path
@@ -3111,7 +3408,7 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string_view de
 
     if (!variable_speed_or_fan_speed) {
         // F is mm per minute.
-        gcode += m_writer.set_speed(F, "", cooling_marker_setspeed_comments);
+        m_writer.set_speed(gcode, F, "", cooling_marker_setspeed_comments);
         double path_length = 0.;
         std::string comment;
         if (m_config.gcode_comments) {
@@ -3125,7 +3422,7 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string_view de
             Vec2d p = this->point_to_gcode_quantized(*it);
             const double line_length = (p - prev).norm();
             path_length += line_length;
-            gcode += m_writer.extrude_to_xy(p, e_per_mm * line_length, comment);
+            m_writer.extrude_to_xy(gcode, p, e_per_mm * line_length, comment);
             prev = p;
         }
     } else {
@@ -3136,18 +3433,18 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string_view de
         }
         double last_set_speed     = new_points[0].speed * 60.0;
         double last_set_fan_speed = new_points[0].fan_speed;
-        gcode += m_writer.set_speed(last_set_speed, "", cooling_marker_setspeed_comments);
+        m_writer.set_speed(gcode, last_set_speed, "", cooling_marker_setspeed_comments);
         gcode += "\n;_SET_FAN_SPEED" + std::to_string(int(last_set_fan_speed)) + "\n";
         Vec2d prev = this->point_to_gcode_quantized(new_points[0].p);
         for (size_t i = 1; i < new_points.size(); i++) {
             const ProcessedPoint &processed_point = new_points[i];
             Vec2d                 p               = this->point_to_gcode_quantized(processed_point.p);
             const double          line_length     = (p - prev).norm();
-            gcode += m_writer.extrude_to_xy(p, e_per_mm * line_length, marked_comment);
+            m_writer.extrude_to_xy(gcode, p, e_per_mm * line_length, marked_comment);
             prev             = p;
             double new_speed = processed_point.speed * 60.0;
             if (last_set_speed != new_speed) {
-                gcode += m_writer.set_speed(new_speed, "", cooling_marker_setspeed_comments);
+                m_writer.set_speed(gcode, new_speed, "", cooling_marker_setspeed_comments);
                 last_set_speed = new_speed;
             }
             if (last_set_fan_speed != processed_point.fan_speed) {
@@ -3162,7 +3459,6 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string_view de
         gcode += path.role().is_bridge() ? ";_BRIDGE_FAN_END\n" : ";_EXTRUDE_END\n";
 
     this->set_last_pos(path.last_point());
-    return gcode;
 }
 
 // This method accepts &point in print coordinates.
@@ -3235,7 +3531,7 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
         gcode += m_writer.set_travel_acceleration((unsigned int)(m_config.travel_acceleration.value + 0.5));
 
         for (size_t i = 1; i < travel.size(); ++ i)
-            gcode += m_writer.travel_to_xy(this->point_to_gcode(travel.points[i]), comment);
+            m_writer.travel_to_xy(gcode, this->point_to_gcode(travel.points[i]), comment);
 
         if (! GCodeWriter::supports_separate_travel_acceleration(config().gcode_flavor)) {
             // In case that this flavor does not support separate print and travel acceleration,
@@ -22,10 +22,13 @@
 #include "EdgeGrid.hpp"
 #include "GCode/ThumbnailData.hpp"
 
+#include <atomic>
 #include <memory>
 #include <map>
 #include <string>
 
+#include <tbb/task_group.h>
+
 #include "GCode/PressureEqualizer.hpp"
 
 namespace Slic3r {
@@ -129,6 +132,32 @@ struct LayerResult {
     static LayerResult make_nop_layer_result() { return {"", std::numeric_limits<coord_t>::max(), false, false, true}; }
 };
 
+// G-code of all layers of a non-sequential print, kept by Print from one G-code export to the next one.
+// If none of the inputs of GCode::process_layer() changed since the G-code was generated (see the fingerprint),
+// the layers are not generated again: Their G-code is replayed through the G-code filters (vase mode, pressure equalizer,
+// cooling buffer, find / replace), which are cheap and which may have been reconfigured, and the G-code generator continues
+// with the end G-code from the state it had after the last layer.
+struct GCodeLayersCache
+{
+    // Hash of the configuration, of the custom G-codes per print_z, of the instances and of the time stamps
+    // of all the Print and PrintObject steps preceding psGCodeExport.
+    size_t                  fingerprint { 0 };
+    // Number of G-code exports, which reused the layers.
+    size_t                  num_reused { 0 };
+    // Output of GCode::process_layer(), before the G-code filters.
+    std::vector<LayerResult> layers;
+    // G-code emitted after the last layer and before the end G-code: wipe tower final purge, retraction, fan off.
+    std::string             end_of_layers_gcode;
+    // State of the G-code generator after end_of_layers_gcode.
+    GCodeWriter::State      writer_state;
+    int                     layer_index { -1 };
+    float                   max_layer_z { 0.f };
+    // Placeholder parser state modified by the layers: The "current_extruder" variable and the global variables
+    // possibly set by the custom G-codes. The other placeholder parser variables are taken from the current export.
+    int                     current_extruder { 0 };
+    DynamicConfig           placeholder_parser_global_config;
+};
+
 class GCode {
 public:        
     GCode() : 
@@ -215,13 +244,17 @@ private:
         void find_replace_supress() { m_find_replace = nullptr; }
 
         bool is_open() const { return f; }
+        // The G-code is written by a background writer, thus a write error is only known
+        // after flush() or close() returned. Call is_error() after either of them.
         bool is_error() const;
         
+        // Write out the buffered G-code and wait for the background writer.
         void flush();
+        // Write out the buffered G-code and close the file. An error when closing is reported by is_error().
         void close();
 
         // Write a string into a file.
-        void write(const std::string& what) { this->write(what.c_str()); }
+        void write(const std::string& what);
         void write(const char* what);
 
         // Write a string into a file. 
@@ -233,12 +266,24 @@ private:
         void write_format(const char* format, ...);
 
     private:
+        // Collect the G-code into m_buffer.
+        void append(const char *data, size_t size);
+        // Pass m_buffer to the G-code processor and hand it over to the background writer.
+        void write_buffer();
+
         FILE             *f { nullptr };
         // Find-replace post-processor to be called before GCodePostProcessor.
         GCodeFindReplace *m_find_replace { nullptr };
         // If suppressed, the backoup holds m_find_replace.
         GCodeFindReplace *m_find_replace_backup { nullptr };
         GCodeProcessor   &m_processor;
+        // G-code collected until it is large enough to be written by m_writer.
+        std::string       m_buffer;
+        // G-code being written by m_writer. The two buffers are swapped, thus their memory is reused.
+        std::string       m_buffer_writing;
+        std::atomic<bool> m_write_failed { false };
+        // Writes the G-code in the background, so that a slow disk does not stall the export.
+        tbb::task_group   m_writer;
     };
     void            _do_export(Print &print, GCodeOutputStream &file, ThumbnailsGeneratorCallback thumbnail_cb);
 
@@ -264,6 +309,10 @@ private:
         const ToolOrdering                                            &tool_ordering,
         const std::vector<const PrintInstance*>                       &print_object_instances_ordering,
         const std::vector<std::pair<coordf_t, ObjectsLayerToPrint>>   &layers_to_print,
+        // If set, the layers are not generated, but their G-code is taken from here.
+        const std::vector<LayerResult>                                *cached_layers,
+        // If set, the G-code of the generated layers is stored here for the next export.
+        std::vector<LayerResult>                                      *layers_to_cache,
         GCodeOutputStream                                             &output_stream);
     // Process all layers of a single object instance (sequential mode) with a parallel pipeline:
     // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
@@ -273,6 +322,8 @@ private:
         const ToolOrdering                      &tool_ordering,
         ObjectsLayerToPrint                      layers_to_print,
         const size_t                             single_object_idx,
+        // Release the exported layers in Print::low_memory_mode(), if this is the last instance of the object to be printed.
+        const bool                               release_layers,
         GCodeOutputStream                       &output_stream);
 
     void            set_last_pos(const Point &pos) { m_last_pos = pos; m_last_pos_defined = true; }
@@ -434,7 +485,8 @@ private:
     // Processor
     GCodeProcessor                      m_processor;
 
-    std::string                         _extrude(const ExtrusionPath &path, const std::string_view description, double speed = -1);
+    // Append the G-code of the extrusion path to gcode.
+    void                                _extrude(std::string &gcode, const ExtrusionPath &path, const std::string_view description, double speed = -1);
     void                                print_machine_envelope(GCodeOutputStream &file, Print &print);
     void                                _print_first_layer_bed_temperature(GCodeOutputStream &file, Print &print, const std::string &gcode, unsigned int first_printing_extruder_id, bool wait);
     void                                _print_first_layer_extruder_temperatures(GCodeOutputStream &file, Print &print, const std::string &gcode, unsigned int first_printing_extruder_id, bool wait);
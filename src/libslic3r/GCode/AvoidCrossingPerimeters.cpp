@@ -9,6 +9,8 @@
 #include "../SVG.hpp"
 #include "AvoidCrossingPerimeters.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <numeric>
 #include <unordered_set>
 #include <boost/range/adaptor/reversed.hpp>
@@ -1088,9 +1090,8 @@ static ExPolygons get_boundary(const Layer &layer)
 }
 
 // called by AvoidCrossingPerimeters::travel_to()
-static Polygons get_boundary_external(const Layer &layer)
+static Polygons get_boundary_external(const Layer &layer, const float perimeter_spacing)
 {
-    const float perimeter_spacing = get_perimeter_spacing_external(layer);
     const float perimeter_offset  = perimeter_spacing / 2.f;
     auto const *support_layer     = dynamic_cast<const SupportLayer *>(&layer);
     Polygons    boundary;
@@ -1166,6 +1167,52 @@ static void init_boundary(AvoidCrossingPerimeters::Boundary *boundary, Polygons
     init_boundary_distances(boundary);
 }
 
+static std::shared_ptr<const AvoidCrossingPerimeters::Boundary> make_boundary(Polygons &&boundary_polygons)
+{
+    auto boundary = std::make_shared<AvoidCrossingPerimeters::Boundary>();
+    init_boundary(boundary.get(), std::move(boundary_polygons));
+    return boundary;
+}
+
+static AvoidCrossingPerimeters::ExternalKey external_key(const Layer &layer)
+{
+    return { layer.print_z, dynamic_cast<const SupportLayer*>(&layer) != nullptr, get_perimeter_spacing_external(layer) };
+}
+
+static std::shared_ptr<const AvoidCrossingPerimeters::LslicesOffset> make_lslices_offset(const Layer &layer)
+{
+    auto  out              = std::make_shared<AvoidCrossingPerimeters::LslicesOffset>();
+    float perimeter_offset = -get_external_perimeter_width(layer) / float(2.);
+    out->lslices_offset    = offset_ex(layer.lslices, perimeter_offset);
+
+    out->bboxes.reserve(out->lslices_offset.size());
+    for (const ExPolygon &ex_poly : out->lslices_offset)
+        out->bboxes.emplace_back(get_extents(ex_poly));
+
+    BoundingBox bbox_slice(get_extents(layer.lslices));
+    bbox_slice.offset(SCALED_EPSILON);
+
+    out->grid.set_bbox(bbox_slice);
+    out->grid.create(out->lslices_offset, coord_t(scale_(1.)));
+    return out;
+}
+
+AvoidCrossingPerimeters::PreparedLayers AvoidCrossingPerimeters::prepare_layers(const std::vector<const Layer*> &layers, bool external)
+{
+    PreparedLayers out;
+    out.internal.reserve(layers.size());
+    for (const Layer *layer : layers)
+        if (layer != nullptr && std::none_of(out.internal.begin(), out.internal.end(), [layer](const PreparedLayers::Internal &l){ return l.layer == layer; })) {
+            out.internal.push_back({ layer, make_lslices_offset(*layer), make_boundary(to_polygons(get_boundary(*layer))) });
+            if (external) {
+                ExternalKey key = external_key(*layer);
+                if (std::none_of(out.external.begin(), out.external.end(), [&key](const auto &l){ return l.first == key; }))
+                    out.external.emplace_back(key, make_boundary(get_boundary_external(*layer, key.perimeter_spacing)));
+            }
+        }
+    return out;
+}
+
 // Plan travel, which avoids perimeter crossings by following the boundaries of the layer.
 Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &point, bool *could_be_wipe_disabled)
 {
@@ -1183,25 +1230,42 @@ Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &
     Vec2d endf   = end  .cast<double>();
 
     bool is_support_layer = dynamic_cast<const SupportLayer *>(gcodegen.layer()) != nullptr;
-    if (!use_external && (is_support_layer || (!m_lslices_offset.empty() && !any_expolygon_contains(m_lslices_offset, m_lslices_offset_bboxes, m_grid_lslices_offset, travel)))) {
+    const LslicesOffset &lslices_offset = *m_lslices_offset;
+    if (!use_external && (is_support_layer || (!lslices_offset.lslices_offset.empty() && !any_expolygon_contains(lslices_offset.lslices_offset, lslices_offset.bboxes, lslices_offset.grid, travel)))) {
         // Initialize m_internal only when it is necessary.
-        if (m_internal.boundaries.empty())
-            init_boundary(&m_internal, to_polygons(get_boundary(*gcodegen.layer())));
+        if (! m_internal_valid) {
+            if (m_internal_layer != gcodegen.layer()) {
+                auto it = std::find_if(m_prepared.internal.begin(), m_prepared.internal.end(),
+                    [layer = gcodegen.layer()](const PreparedLayers::Internal &l){ return l.layer == layer; });
+                m_internal       = it == m_prepared.internal.end() ? make_boundary(to_polygons(get_boundary(*gcodegen.layer()))) : it->boundary;
+                m_internal_layer = gcodegen.layer();
+            }
+            m_internal_valid = true;
+        }
 
         // Trim the travel line by the bounding box.
-        if (!m_internal.boundaries.empty() && Geometry::liang_barsky_line_clipping(startf, endf, m_internal.bbox)) {
-            travel_intersection_count = avoid_perimeters(m_internal, startf.cast<coord_t>(), endf.cast<coord_t>(), *gcodegen.layer(), result_pl);
+        if (!m_internal->boundaries.empty() && Geometry::liang_barsky_line_clipping(startf, endf, m_internal->bbox)) {
+            travel_intersection_count = avoid_perimeters(*m_internal, startf.cast<coord_t>(), endf.cast<coord_t>(), *gcodegen.layer(), result_pl);
             result_pl.points.front()  = start;
             result_pl.points.back()   = end;
         }
     } else if(use_external) {
         // Initialize m_external only when exist any external travel for the current layer.
-        if (m_external.boundaries.empty())
-            init_boundary(&m_external, get_boundary_external(*gcodegen.layer()));
+        if (! m_external_valid) {
+            const Layer &layer = *gcodegen.layer();
+            // The boundary is collected over all objects and their instances, thus it only depends on ExternalKey.
+            ExternalKey key = external_key(layer);
+            if (! m_external || ! (key == m_external_key)) {
+                auto it = std::find_if(m_prepared.external.begin(), m_prepared.external.end(), [&key](const auto &l){ return l.first == key; });
+                m_external     = it == m_prepared.external.end() ? make_boundary(get_boundary_external(layer, key.perimeter_spacing)) : it->second;
+                m_external_key = key;
+            }
+            m_external_valid = true;
+        }
 
         // Trim the travel line by the bounding box.
-        if (!m_external.boundaries.empty() && Geometry::liang_barsky_line_clipping(startf, endf, m_external.bbox)) {
-            travel_intersection_count = avoid_perimeters(m_external, startf.cast<coord_t>(), endf.cast<coord_t>(), *gcodegen.layer(), result_pl);
+        if (!m_external->boundaries.empty() && Geometry::liang_barsky_line_clipping(startf, endf, m_external->bbox)) {
+            travel_intersection_count = avoid_perimeters(*m_external, startf.cast<coord_t>(), endf.cast<coord_t>(), *gcodegen.layer(), result_pl);
             result_pl.points.front()  = start;
             result_pl.points.back()   = end;
         }
@@ -1233,7 +1297,7 @@ Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &
     } else if (max_detour_length_exceeded) {
         *could_be_wipe_disabled = false;
     } else
-        *could_be_wipe_disabled = !need_wipe(gcodegen, m_lslices_offset, m_lslices_offset_bboxes, m_grid_lslices_offset, travel, result_pl, travel_intersection_count);
+        *could_be_wipe_disabled = !need_wipe(gcodegen, lslices_offset.lslices_offset, lslices_offset.bboxes, lslices_offset.grid, travel, result_pl, travel_intersection_count);
 
     return result_pl;
 }
@@ -1242,23 +1306,15 @@ Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &
 
 void AvoidCrossingPerimeters::init_layer(const Layer &layer)
 {
-    m_internal.clear();
-    m_external.clear();
-    m_lslices_offset.clear();
-    m_lslices_offset_bboxes.clear();
-
-    float perimeter_offset = -get_external_perimeter_width(layer) / float(2.);
-    m_lslices_offset        = offset_ex(layer.lslices, perimeter_offset);
-
-    m_lslices_offset_bboxes.reserve(m_lslices_offset.size());
-    for (const ExPolygon &ex_poly : m_lslices_offset)
-        m_lslices_offset_bboxes.emplace_back(get_extents(ex_poly));
-
-    BoundingBox bbox_slice(get_extents(layer.lslices));
-    bbox_slice.offset(SCALED_EPSILON);
-
-    m_grid_lslices_offset.set_bbox(bbox_slice);
-    m_grid_lslices_offset.create(m_lslices_offset, coord_t(scale_(1.)));
+    // The boundaries are kept for reuse, see m_internal_valid.
+    m_internal_valid = false;
+    m_external_valid = false;
+    if (&layer == m_lslices_offset_layer)
+        // Another instance of the same object or another extruder at the same layer.
+        return;
+    m_lslices_offset_layer = &layer;
+    auto it = std::find_if(m_prepared.internal.begin(), m_prepared.internal.end(), [&layer](const PreparedLayers::Internal &l){ return l.layer == &layer; });
+    m_lslices_offset = it == m_prepared.internal.end() ? make_lslices_offset(layer) : it->lslices_offset;
 }
 
 #if 0
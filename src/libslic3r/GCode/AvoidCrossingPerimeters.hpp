@@ -5,6 +5,8 @@
 #include "../ExPolygon.hpp"
 #include "../EdgeGrid.hpp"
 
+#include <memory>
+
 namespace Slic3r {
 
 // Forward declarations.
@@ -50,6 +52,45 @@ public:
         }
     };
 
+    // Lslices offseted by half an external perimeter width. Used for detection if line or polyline is inside of any polygon.
+    struct LslicesOffset {
+        ExPolygons               lslices_offset;
+        std::vector<BoundingBox> bboxes;
+        // Used for detection of line or polyline is inside of any polygon.
+        EdgeGrid::Grid           grid;
+    };
+
+    // The boundary for travels around the objects is collected over all objects and their instances,
+    // thus it only depends on print_z, on the kind of the layer and on the perimeter spacing.
+    struct ExternalKey {
+        coordf_t print_z           { -1. };
+        bool     support_layer     { false };
+        float    perimeter_spacing { 0.f };
+        bool operator==(const ExternalKey &rhs) const
+            { return print_z == rhs.print_z && support_layer == rhs.support_layer && perimeter_spacing == rhs.perimeter_spacing; }
+    };
+
+    // Data of the layers printed at a single print_z, built by prepare_layers() ahead of the G-code emission.
+    struct PreparedLayers {
+        struct Internal {
+            const Layer                            *layer { nullptr };
+            std::shared_ptr<const LslicesOffset>    lslices_offset;
+            // Boundary for travels inside the layer, in the coordinate system of its object, shared by all its instances.
+            std::shared_ptr<const Boundary>         boundary;
+        };
+        std::vector<Internal>                                                   internal;
+        // Boundaries for travels around the objects, one per ExternalKey of the layers.
+        std::vector<std::pair<ExternalKey, std::shared_ptr<const Boundary>>>   external;
+    };
+
+    // Build the data of the layers printed at a single print_z. The boundaries for travels around the objects are only built
+    // if external is set. Thread safe, it only reads the layers at print_z and the object layers below them, thus the data
+    // of multiple print_z are built in parallel with the G-code emission.
+    static PreparedLayers prepare_layers(const std::vector<const Layer*> &layers, bool external);
+    // init_layer() and travel_to() take the data from prepared instead of building them, until the next call.
+    // Data of layers missing in prepared are built on demand as before.
+    void        set_prepared_layers(PreparedLayers &&prepared) { m_prepared = std::move(prepared); }
+
 private:
     bool           m_use_external_mp { false };
     // just for the next travel move
@@ -58,15 +99,23 @@ private:
     // we enable it by default for the first travel move in print
     bool           m_disabled_once { true };
 
-    // Lslices offseted by half an external perimeter width. Used for detection if line or polyline is inside of any polygon.
-    ExPolygons               m_lslices_offset;
-    std::vector<BoundingBox> m_lslices_offset_bboxes;
-    // Used for detection of line or polyline is inside of any polygon.
-    EdgeGrid::Grid           m_grid_lslices_offset;
+    // Lslices of the current layer offseted by half an external perimeter width.
+    std::shared_ptr<const LslicesOffset> m_lslices_offset { std::make_shared<LslicesOffset>() };
+    // Layer of m_lslices_offset, which is reused by init_layer() for the next instance or the next extruder at the same layer.
+    const Layer                         *m_lslices_offset_layer { nullptr };
     // Store all needed data for travels inside object
-    Boundary m_internal;
+    std::shared_ptr<const Boundary>      m_internal;
     // Store all needed data for travels outside object
-    Boundary m_external;
+    std::shared_ptr<const Boundary>      m_external;
+    // The boundaries are taken from m_prepared or built by travel_to() for the first travel after init_layer() needing them.
+    // They are a function of the layer only, thus they are kept over init_layer() and reused if the next instance of the same
+    // object, the next extruder or the next object at the same print_z needs them again.
+    bool                                 m_internal_valid { false };
+    const Layer                         *m_internal_layer { nullptr };
+    bool                                 m_external_valid { false };
+    ExternalKey                          m_external_key;
+    // Data of the layers being exported, see set_prepared_layers().
+    PreparedLayers                       m_prepared;
 };
 
 } // namespace Slic3r
@@ -220,24 +220,55 @@ struct ProcessedPoint
 
 class ExtrusionQualityEstimator
 {
+public:
+    // Distancers of a single object layer. They only depend on the layer, thus they may be built by make_layer_distancers()
+    // in parallel ahead of the G-code emission and passed over set_prepared_layers().
+    struct LayerDistancers
+    {
+        const Layer                              *layer { nullptr };
+        AABBTreeLines::LinesDistancer<Linef>      boundaries;
+        AABBTreeLines::LinesDistancer<CurledLine> curled_extrusions;
+    };
+
+private:
     std::unordered_map<const PrintObject *, AABBTreeLines::LinesDistancer<Linef>> prev_layer_boundaries;
     std::unordered_map<const PrintObject *, AABBTreeLines::LinesDistancer<Linef>> next_layer_boundaries;
     std::unordered_map<const PrintObject *, AABBTreeLines::LinesDistancer<CurledLine>> prev_curled_extrusions;
     std::unordered_map<const PrintObject *, AABBTreeLines::LinesDistancer<CurledLine>> next_curled_extrusions;
     const PrintObject                                                            *current_object;
+    std::vector<LayerDistancers>                                                  prepared_layers;
 
 public:
+    static LayerDistancers make_layer_distancers(const Layer *layer)
+    {
+        LayerDistancers out;
+        if (layer != nullptr) {
+            out.layer             = layer;
+            out.boundaries        = AABBTreeLines::LinesDistancer<Linef>{to_unscaled_linesf(layer->lslices)};
+            out.curled_extrusions = AABBTreeLines::LinesDistancer<CurledLine>{layer->curled_lines};
+        }
+        return out;
+    }
+
+    // prepare_for_new_layer() takes the distancers from prepared instead of building them, until the next call.
+    void set_prepared_layers(std::vector<LayerDistancers> &&prepared) { prepared_layers = std::move(prepared); }
+
     void set_current_object(const PrintObject *object) { current_object = object; }
 
     void prepare_for_new_layer(const Layer *layer)
     {
         if (layer == nullptr)
             return;
+        auto it = std::find_if(prepared_layers.begin(), prepared_layers.end(), [layer](const LayerDistancers &l) { return l.layer == layer; });
+        LayerDistancers distancers = it == prepared_layers.end() ? make_layer_distancers(layer) : std::move(*it);
+        if (it != prepared_layers.end())
+            // Moved from, a layer is only prepared once.
+            it->layer = nullptr;
         const PrintObject *object      = layer->object();
-        prev_layer_boundaries[object]  = next_layer_boundaries[object];
-        next_layer_boundaries[object]  = AABBTreeLines::LinesDistancer<Linef>{to_unscaled_linesf(layer->lslices)};
-        prev_curled_extrusions[object] = next_curled_extrusions[object];
-        next_curled_extrusions[object] = AABBTreeLines::LinesDistancer<CurledLine>{layer->curled_lines};
+        prev_layer_boundaries[object]  = std::move(next_layer_boundaries[object]);
+        next_layer_boundaries[object]  = std::move(distancers.boundaries);
+        prev_curled_extrusions[object] = std::move(next_curled_extrusions[object]);
+        next_curled_extrusions[object] = std::move(distancers.curled_extrusions);
     }
 
     std::vector<ProcessedPoint> estimate_speed_from_extrusion_quality(
@@ -5,6 +5,7 @@
 #include "libslic3r/format.hpp"
 #include "libslic3r/I18N.hpp"
 #include "libslic3r/GCodeWriter.hpp"
+#include "libslic3r/Trace.hpp"
 #include "libslic3r/I18N.hpp"
 #include "GCodeProcessor.hpp"
 
@@ -17,6 +18,8 @@
 #include <boost/filesystem/path.hpp>
 
 #include <float.h>
+#include <cstring>
+#include <limits>
 #include <assert.h>
 
 #if __has_include(<charconv>)
@@ -189,6 +192,7 @@ void GCodeProcessor::TimeMachine::CustomGCodeTime::reset()
 
 void GCodeProcessor::TimeMachine::reset()
 {
+    planner.wait();
     enabled = false;
     acceleration = 0.0f;
     max_acceleration = 0.0f;
@@ -204,18 +208,37 @@ void GCodeProcessor::TimeMachine::reset()
     prev.reset();
     gcode_time.reset();
     blocks = std::vector<TimeBlock>();
+    queued_blocks = std::vector<TimeBlock>();
+    planner_kept_blocks = 0;
     g1_times_cache = std::vector<G1LinesCacheItem>();
     std::fill(moves_time.begin(), moves_time.end(), 0.0f);
     std::fill(roles_time.begin(), roles_time.end(), 0.0f);
     layers_time = std::vector<float>();
 }
 
+void GCodeProcessor::TimeMachine::queue_block(const TimeBlock& block)
+{
+    queued_blocks.push_back(block);
+    if (planner_kept_blocks + queued_blocks.size() > TimeProcessor::Planner::refresh_threshold) {
+        // Wait for the previous planning round, which works on this->blocks.
+        planner.wait();
+        append(blocks, std::move(queued_blocks));
+        queued_blocks.clear();
+        planner_kept_blocks = TimeProcessor::Planner::queue_size;
+        planner.run([this]() { calculate_time(TimeProcessor::Planner::queue_size); });
+    }
+}
+
 void GCodeProcessor::TimeMachine::simulate_st_synchronize(float additional_time)
 {
     if (!enabled)
         return;
 
+    planner.wait();
+    append(blocks, std::move(queued_blocks));
+    queued_blocks.clear();
     calculate_time(0, additional_time);
+    planner_kept_blocks = blocks.size();
 }
 
 static void planner_forward_pass_kernel(GCodeProcessor::TimeBlock& prev, GCodeProcessor::TimeBlock& curr)
@@ -436,9 +459,204 @@ void GCodeProcessor::UsedFilaments::process_caches(const GCodeProcessor* process
     process_role_cache(processor);
 }
 
+std::optional<uint16_t> GCodeProcessorResult::Moves::PaletteColumn::palette_index(float value)
+{
+    uint32_t bits;
+    static_assert(sizeof(bits) == sizeof(value));
+    std::memcpy(&bits, &value, sizeof(value));
+    if (! m_palette.empty() && bits == m_last_bits)
+        return m_last_index;
+    auto it = m_palette_map.find(bits);
+    if (it == m_palette_map.end()) {
+        if (m_palette.size() > size_t(std::numeric_limits<uint16_t>::max()))
+            // Palette is full.
+            return std::nullopt;
+        it = m_palette_map.insert({ bits, uint16_t(m_palette.size()) }).first;
+        m_palette.emplace_back(value);
+    }
+    m_last_bits  = bits;
+    m_last_index = it->second;
+    return it->second;
+}
+
+void GCodeProcessorResult::Moves::PaletteColumn::make_dense()
+{
+    assert(! m_dense);
+    m_values.clear();
+    m_values.reserve(m_indices.capacity());
+    for (uint16_t idx : m_indices)
+        m_values.emplace_back(m_palette[idx]);
+    m_dense = true;
+    m_indices       = std::vector<uint16_t>();
+    m_palette       = std::vector<float>();
+    m_palette_map   = std::unordered_map<uint32_t, uint16_t>();
+}
+
+void GCodeProcessorResult::Moves::PaletteColumn::push_back(float value)
+{
+    if (! m_dense) {
+        if (std::optional<uint16_t> idx = this->palette_index(value); idx) {
+            m_indices.emplace_back(*idx);
+            return;
+        }
+        this->make_dense();
+    }
+    m_values.emplace_back(value);
+}
+
+void GCodeProcessorResult::Moves::PaletteColumn::set(size_t id, float value)
+{
+    if (! m_dense) {
+        if (std::optional<uint16_t> idx = this->palette_index(value); idx) {
+            m_indices[id] = *idx;
+            return;
+        }
+        this->make_dense();
+    }
+    m_values[id] = value;
+}
+
+void GCodeProcessorResult::Moves::PaletteColumn::erase(size_t id)
+{
+    if (m_dense)
+        m_values.erase(m_values.begin() + id);
+    else
+        m_indices.erase(m_indices.begin() + id);
+}
+
+void GCodeProcessorResult::Moves::PaletteColumn::clear()
+{
+    m_dense = false;
+    m_indices.clear();
+    m_palette.clear();
+    m_palette_map.clear();
+    m_values.clear();
+}
+
+void GCodeProcessorResult::Moves::PaletteColumn::shrink_to_fit()
+{
+    m_indices.shrink_to_fit();
+    m_palette.shrink_to_fit();
+    m_values.shrink_to_fit();
+}
+
+size_t GCodeProcessorResult::Moves::PaletteColumn::memory_size() const
+{
+    return SLIC3R_STDVEC_MEMSIZE(m_indices, uint16_t) + SLIC3R_STDVEC_MEMSIZE(m_palette, float) + SLIC3R_STDVEC_MEMSIZE(m_values, float) +
+        // Approximate size of the nodes and of the buckets of the hash map.
+        m_palette_map.size() * (sizeof(std::pair<const uint32_t, uint16_t>) + sizeof(void*)) + m_palette_map.bucket_count() * sizeof(void*);
+}
+
+GCodeProcessorResult::MoveVertex GCodeProcessorResult::Moves::operator[](size_t id) const
+{
+    return {
+        m_gcode_id[id],
+        m_type[id],
+        m_extrusion_role[id],
+        m_extruder_id[id],
+        m_cp_color_id[id],
+        m_position[id],
+        m_delta_extruder[id],
+        m_feedrate[id],
+        m_width[id],
+        m_height[id],
+        m_mm3_per_mm[id],
+        m_fan_speed[id],
+        m_temperature[id],
+        m_time[id],
+        m_internal_only[id] != 0
+    };
+}
+
+void GCodeProcessorResult::Moves::push_back(const MoveVertex& move)
+{
+    m_gcode_id.emplace_back(move.gcode_id);
+    m_type.emplace_back(move.type);
+    m_extrusion_role.emplace_back(move.extrusion_role);
+    m_extruder_id.emplace_back(move.extruder_id);
+    m_cp_color_id.emplace_back(move.cp_color_id);
+    m_position.emplace_back(move.position);
+    m_delta_extruder.emplace_back(move.delta_extruder);
+    m_feedrate.push_back(move.feedrate);
+    m_width.push_back(move.width);
+    m_height.push_back(move.height);
+    m_mm3_per_mm.push_back(move.mm3_per_mm);
+    m_fan_speed.push_back(move.fan_speed);
+    m_temperature.push_back(move.temperature);
+    m_time.emplace_back(move.time);
+    m_internal_only.emplace_back(move.internal_only);
+}
+
+void GCodeProcessorResult::Moves::erase(size_t id)
+{
+    m_gcode_id.erase(m_gcode_id.begin() + id);
+    m_type.erase(m_type.begin() + id);
+    m_extrusion_role.erase(m_extrusion_role.begin() + id);
+    m_extruder_id.erase(m_extruder_id.begin() + id);
+    m_cp_color_id.erase(m_cp_color_id.begin() + id);
+    m_position.erase(m_position.begin() + id);
+    m_delta_extruder.erase(m_delta_extruder.begin() + id);
+    m_feedrate.erase(id);
+    m_width.erase(id);
+    m_height.erase(id);
+    m_mm3_per_mm.erase(id);
+    m_fan_speed.erase(id);
+    m_temperature.erase(id);
+    m_time.erase(m_time.begin() + id);
+    m_internal_only.erase(m_internal_only.begin() + id);
+}
+
+void GCodeProcessorResult::Moves::clear()
+{
+    m_gcode_id.clear();
+    m_type.clear();
+    m_extrusion_role.clear();
+    m_extruder_id.clear();
+    m_cp_color_id.clear();
+    m_position.clear();
+    m_delta_extruder.clear();
+    m_feedrate.clear();
+    m_width.clear();
+    m_height.clear();
+    m_mm3_per_mm.clear();
+    m_fan_speed.clear();
+    m_temperature.clear();
+    m_time.clear();
+    m_internal_only.clear();
+}
+
+void GCodeProcessorResult::Moves::shrink_to_fit()
+{
+    m_gcode_id.shrink_to_fit();
+    m_type.shrink_to_fit();
+    m_extrusion_role.shrink_to_fit();
+    m_extruder_id.shrink_to_fit();
+    m_cp_color_id.shrink_to_fit();
+    m_position.shrink_to_fit();
+    m_delta_extruder.shrink_to_fit();
+    m_feedrate.shrink_to_fit();
+    m_width.shrink_to_fit();
+    m_height.shrink_to_fit();
+    m_mm3_per_mm.shrink_to_fit();
+    m_fan_speed.shrink_to_fit();
+    m_temperature.shrink_to_fit();
+    m_time.shrink_to_fit();
+    m_internal_only.shrink_to_fit();
+}
+
+size_t GCodeProcessorResult::Moves::memory_size() const
+{
+    return SLIC3R_STDVEC_MEMSIZE(m_gcode_id, unsigned int) + SLIC3R_STDVEC_MEMSIZE(m_type, EMoveType) +
+        SLIC3R_STDVEC_MEMSIZE(m_extrusion_role, GCodeExtrusionRole) + SLIC3R_STDVEC_MEMSIZE(m_extruder_id, unsigned char) +
+        SLIC3R_STDVEC_MEMSIZE(m_cp_color_id, unsigned char) + SLIC3R_STDVEC_MEMSIZE(m_position, Vec3f) +
+        SLIC3R_STDVEC_MEMSIZE(m_delta_extruder, float) + m_feedrate.memory_size() + m_width.memory_size() + m_height.memory_size() +
+        m_mm3_per_mm.memory_size() + m_fan_speed.memory_size() + m_temperature.memory_size() +
+        SLIC3R_STDVEC_MEMSIZE(m_time, float) + SLIC3R_STDVEC_MEMSIZE(m_internal_only, unsigned char);
+}
+
 #if ENABLE_GCODE_VIEWER_STATISTICS
 void GCodeProcessorResult::reset() {
-    moves = std::vector<GCodeProcessorResult::MoveVertex>();
+    moves = GCodeProcessorResult::Moves();
     bed_shape = Pointfs();
     max_print_height = 0.0f;
     settings_ids.reset();
@@ -1024,6 +1242,7 @@ static inline const char* remove_eols(const char *begin, const char *end) {
 // throws CanceledException through print->throw_if_canceled() (sent by the caller as callback).
 void GCodeProcessor::process_file(const std::string& filename, std::function<void()> cancel_callback)
 {
+    SLIC3R_TRACE_SCOPE("GCodeProcessor::process_file");
     CNumericLocalesSetter locales_setter;
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
@@ -1105,6 +1324,7 @@ void GCodeProcessor::initialize(const std::string& filename)
 
 void GCodeProcessor::process_buffer(const std::string &buffer)
 {
+    SLIC3R_TRACE_SCOPE("GCodeProcessor::process_buffer");
     //FIXME maybe cache GCodeLine gline to be over multiple parse_buffer() invocations.
     m_parser.parse_buffer(buffer, [this](GCodeReader&, const GCodeReader::GCodeLine& line) { 
         this->process_gcode_line(line, false);
@@ -1113,19 +1333,24 @@ void GCodeProcessor::process_buffer(const std::string &buffer)
 
 void GCodeProcessor::finalize(bool perform_post_process)
 {
+    SLIC3R_TRACE_SCOPE("GCodeProcessor::finalize");
     // update width/height of wipe moves
-    for (GCodeProcessorResult::MoveVertex& move : m_result.moves) {
-        if (move.type == EMoveType::Wipe) {
-            move.width = Wipe_Width;
-            move.height = Wipe_Height;
+    GCodeProcessorResult::Moves& moves = m_result.moves;
+    for (size_t i = 0; i < moves.size(); ++i) {
+        if (moves.type(i) == EMoveType::Wipe) {
+            moves.set_width(i, Wipe_Width);
+            moves.set_height(i, Wipe_Height);
         }
     }
+    moves.shrink_to_fit();
+    BOOST_LOG_TRIVIAL(debug) << "GCodeProcessor: " << moves.size() << " moves stored in " << moves.memory_size() << " bytes, "
+        << moves.size() * sizeof(GCodeProcessorResult::MoveVertex) << " bytes as an array of MoveVertex";
 
     // process the time blocks
     for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
         TimeMachine& machine = m_time_processor.machines[i];
         TimeMachine::CustomGCodeTime& gcode_time = machine.gcode_time;
-        machine.calculate_time();
+        machine.simulate_st_synchronize();
         if (gcode_time.needed && gcode_time.cache != 0.0f)
             gcode_time.times.push_back({ CustomGCode::ColorChange, gcode_time.cache });
     }
@@ -2515,7 +2740,6 @@ void GCodeProcessor::process_G1(const std::array<std::optional<double>, 4>& axes
 
         TimeMachine::State& curr = machine.curr;
         TimeMachine::State& prev = machine.prev;
-        std::vector<TimeBlock>& blocks = machine.blocks;
 
         curr.feedrate = (delta_pos[E] == 0.0f) ? minimum_travel_feedrate(static_cast<PrintEstimatedStatistics::ETimeMode>(i), m_feedrate) :
             minimum_feedrate(static_cast<PrintEstimatedStatistics::ETimeMode>(i), m_feedrate);
@@ -2579,7 +2803,7 @@ void GCodeProcessor::process_G1(const std::array<std::optional<double>, 4>& axes
 
         // calculates block entry feedrate
         float vmax_junction = curr.safe_feedrate;
-        if (!blocks.empty() && prev.feedrate > PREVIOUS_FEEDRATE_THRESHOLD) {
+        if (machine.has_blocks() && prev.feedrate > PREVIOUS_FEEDRATE_THRESHOLD) {
             const bool prev_speed_larger = prev.feedrate > block.feedrate_profile.cruise;
             const float smaller_speed_factor = prev_speed_larger ? (block.feedrate_profile.cruise / prev.feedrate) : (prev.feedrate / block.feedrate_profile.cruise);
             // Pick the smaller of the nominal speeds. Higher speed shall not be achieved at the junction during coasting.
@@ -2649,16 +2873,13 @@ void GCodeProcessor::process_G1(const std::array<std::optional<double>, 4>& axes
         // updates previous
         prev = curr;
 
-        blocks.push_back(block);
-
-        if (blocks.size() > TimeProcessor::Planner::refresh_threshold)
-            machine.calculate_time(TimeProcessor::Planner::queue_size);
+        machine.queue_block(block);
     }
 
     if (m_seams_detector.is_active()) {
         // check for seam starting vertex
         if (type == EMoveType::Extrude && m_extrusion_role == GCodeExtrusionRole::ExternalPerimeter && !m_seams_detector.has_first_vertex())
-            m_seams_detector.set_first_vertex(m_result.moves.back().position - m_extruder_offsets[m_extruder_id]);
+            m_seams_detector.set_first_vertex(m_result.moves.position(m_result.moves.size() - 1) - m_extruder_offsets[m_extruder_id]);
         // check for seam ending vertex and store the resulting move
         else if ((type != EMoveType::Extrude || (m_extrusion_role != GCodeExtrusionRole::ExternalPerimeter && m_extrusion_role != GCodeExtrusionRole::OverhangPerimeter)) && m_seams_detector.has_first_vertex()) {
             auto set_end_position = [this](const Vec3f& pos) {
@@ -2666,7 +2887,7 @@ void GCodeProcessor::process_G1(const std::array<std::optional<double>, 4>& axes
             };
 
             const Vec3f curr_pos(m_end_position[X], m_end_position[Y], m_end_position[Z]);
-            const Vec3f new_pos = m_result.moves.back().position - m_extruder_offsets[m_extruder_id];
+            const Vec3f new_pos = m_result.moves.position(m_result.moves.size() - 1) - m_extruder_offsets[m_extruder_id];
             const std::optional<Vec3f> first_vertex = m_seams_detector.get_first_vertex();
             // the threshold value = 0.0625f == 0.25 * 0.25 is arbitrary, we may find some smarter condition later
 
@@ -2681,7 +2902,7 @@ void GCodeProcessor::process_G1(const std::array<std::optional<double>, 4>& axes
     }
     else if (type == EMoveType::Extrude && m_extrusion_role == GCodeExtrusionRole::ExternalPerimeter) {
         m_seams_detector.activate(true);
-        m_seams_detector.set_first_vertex(m_result.moves.back().position - m_extruder_offsets[m_extruder_id]);
+        m_seams_detector.set_first_vertex(m_result.moves.position(m_result.moves.size() - 1) - m_extruder_offsets[m_extruder_id]);
     }
 
     if (m_spiral_vase_active && !m_result.spiral_vase_layers.empty()) {
@@ -3428,6 +3649,7 @@ void GCodeProcessor::process_T(const std::string_view command)
 
 void GCodeProcessor::post_process()
 {
+    SLIC3R_TRACE_SCOPE("GCodeProcessor::post_process");
     FilePtr in{ boost::nowide::fopen(m_result.filename.c_str(), "rb") };
     if (in.f == nullptr)
         throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot open file for reading.\n"));
@@ -3555,6 +3777,14 @@ void GCodeProcessor::post_process()
         size_t m_curr_g1_id{ 0 };
         size_t m_out_file_pos{ 0 };
 
+        // Output collected until it is large enough to be written to file by m_writer.
+        std::string m_out_buffer;
+        // Output being written to file by m_writer.
+        std::string m_out_buffer_writing;
+        bool m_write_failed{ false };
+        // Writes the output in the background, so that writing overlaps the processing of the following lines.
+        tbb::task_group m_writer;
+
     public:
         ExportLines(EWriteType type, TimeMachine& machine)
 #ifndef NDEBUG
@@ -3562,6 +3792,8 @@ void GCodeProcessor::post_process()
 #else
         : m_write_type(type), m_machine(machine) {}
 #endif // NDEBUG
+        // Don't let the background writer outlive its buffer.
+        ~ExportLines() { m_writer.wait(); }
 
         void update(size_t lines_counter, size_t g1_lines_counter) {
             m_gcode_lines_map.push_back({ lines_counter, 0 });
@@ -3672,7 +3904,7 @@ void GCodeProcessor::post_process()
                 }
             }
 
-            write_to_file(out, out_string, result, out_path);
+            write_to_file(out, std::move(out_string), result, out_path, false);
         }
 
         // flush the current content of the cache to file
@@ -3688,36 +3920,57 @@ void GCodeProcessor::post_process()
             m_statistics.remove_all_lines();
 #endif // NDEBUG
 
-            write_to_file(out, out_string, result, out_path);
+            write_to_file(out, std::move(out_string), result, out_path, true);
+            // Wait for the background writer to finish.
+            m_writer.wait();
+            check_write(out, out_path);
         }
 
         void synchronize_moves(GCodeProcessorResult& result) const {
             auto it = m_gcode_lines_map.begin();
-            for (GCodeProcessorResult::MoveVertex& move : result.moves) {
-                while (it != m_gcode_lines_map.end() && it->first < move.gcode_id) {
+            for (size_t i = 0; i < result.moves.size(); ++i) {
+                const unsigned int gcode_id = result.moves.gcode_id(i);
+                while (it != m_gcode_lines_map.end() && it->first < gcode_id) {
                     ++it;
                 }
-                if (it != m_gcode_lines_map.end() && it->first == move.gcode_id)
-                    move.gcode_id = it->second;
+                if (it != m_gcode_lines_map.end() && it->first == gcode_id)
+                    result.moves.set_gcode_id(i, it->second);
             }
         }
 
         size_t get_size() const { return m_size; }
 
     private:
-        void write_to_file(FilePtr& out, const std::string& out_string, GCodeProcessorResult& result, const std::string& out_path) {
+        void write_to_file(FilePtr& out, std::string&& out_string, GCodeProcessorResult& result, const std::string& out_path, bool force) {
             if (!out_string.empty()) {
-                fwrite((const void*)out_string.c_str(), 1, out_string.length(), out.f);
-                if (ferror(out.f)) {
-                    out.close();
-                    boost::nowide::remove(out_path.c_str());
-                    throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nIs the disk full?\n"));
-                }
                 for (size_t i = 0; i < out_string.size(); ++i) {
                     if (out_string[i] == '\n')
                         result.lines_ends.emplace_back(m_out_file_pos + i + 1);
                 }
                 m_out_file_pos += out_string.size();
+                if (m_out_buffer.empty())
+                    m_out_buffer = std::move(out_string);
+                else
+                    m_out_buffer += out_string;
+            }
+            if (m_out_buffer.size() > 65536 * 4 || (force && !m_out_buffer.empty())) {
+                // Wait for the previous write, then hand over the collected output to the background writer.
+                m_writer.wait();
+                check_write(out, out_path);
+                m_out_buffer_writing.swap(m_out_buffer);
+                m_out_buffer.clear();
+                m_writer.run([this, f = out.f]() {
+                    fwrite((const void*)m_out_buffer_writing.c_str(), 1, m_out_buffer_writing.length(), f);
+                    m_write_failed = ferror(f) != 0;
+                });
+            }
+        }
+
+        void check_write(FilePtr& out, const std::string& out_path) {
+            if (m_write_failed) {
+                out.close();
+                boost::nowide::remove(out_path.c_str());
+                throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nIs the disk full?\n"));
             }
         }
     };
@@ -3975,15 +4228,33 @@ void GCodeProcessor::post_process()
     float max_backtrace_time = 120.0f;
 
     {
-        // Read the input stream 64kB at a time, extract lines and process them.
+        // Read the input stream 640kB at a time, extract lines and process them.
+        // The next block is read in the background while the current block is being processed.
         std::vector<char> buffer(65536 * 10, 0);
+        std::vector<char> buffer_next(buffer.size(), 0);
+        size_t            cnt_read_next = 0;
+        bool              read_failed   = false;
+        auto read_block = [&in, &read_failed](std::vector<char> &buffer) {
+            size_t cnt_read = ::fread(buffer.data(), 1, buffer.size(), in.f);
+            read_failed = ::ferror(in.f) != 0;
+            return cnt_read;
+        };
+        tbb::task_group reader;
+        auto wait_for_reader = [&reader]() {
+            reader.cancel();
+            reader.wait();
+        };
         // Line buffer.
         assert(gcode_line.empty());
+        size_t cnt_read = read_block(buffer);
         for (;;) {
-            size_t cnt_read = ::fread(buffer.data(), 1, buffer.size(), in.f);
-            if (::ferror(in.f))
+            if (read_failed)
                 throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nError while reading from file.\n"));
             bool eof = cnt_read == 0;
+            if (! eof)
+                reader.run([&read_block, &buffer_next, &cnt_read_next]() { cnt_read_next = read_block(buffer_next); });
+            // Don't let the background reader outlive the data it works on.
+            ScopeGuard reader_guard(wait_for_reader);
             auto it = buffer.begin();
             auto it_bufend = buffer.begin() + cnt_read;
             while (it != it_bufend || (eof && !gcode_line.empty())) {
@@ -4030,6 +4301,10 @@ void GCodeProcessor::post_process()
             }
             if (eof)
                 break;
+            reader_guard.reset();
+            reader.wait();
+            buffer.swap(buffer_next);
+            cnt_read = cnt_read_next;
         }
     }
 
@@ -4076,6 +4351,8 @@ void GCodeProcessor::store_move_vertex(EMoveType type, bool internal_only)
             if (!machine.enabled)
                 continue;
 
+            // The background planner updates the stop times.
+            machine.wait_for_planner();
             machine.stop_times.push_back({ m_g1_line_id, 0.0f });
         }
     }
@@ -13,6 +13,10 @@
 #include <string>
 #include <string_view>
 #include <optional>
+#include <iterator>
+#include <unordered_map>
+
+#include <tbb/task_group.h>
 
 namespace Slic3r {
 
@@ -134,9 +138,120 @@ namespace Slic3r {
             float volumetric_rate() const { return feedrate * mm3_per_mm; }
         };
 
+        // Moves stored column by column. The columns taking just a few distinct values along the G-code
+        // (feedrate, width, height, fan speed...) are stored as 16 bit indices into a palette of the values,
+        // the other columns are stored as plain arrays. Consumers should read just the columns they need,
+        // operator[] materializes a whole MoveVertex.
+        class Moves
+        {
+        public:
+            size_t     size() const  { return m_gcode_id.size(); }
+            bool       empty() const { return m_gcode_id.empty(); }
+
+            MoveVertex operator[](size_t id) const;
+            MoveVertex back() const { assert(! this->empty()); return (*this)[this->size() - 1]; }
+
+            void       push_back(const MoveVertex& move);
+            void       erase(size_t id);
+            void       clear();
+            void       shrink_to_fit();
+            // Memory allocated by the columns, in bytes.
+            size_t     memory_size() const;
+
+            unsigned int       gcode_id(size_t id) const        { return m_gcode_id[id]; }
+            EMoveType          type(size_t id) const            { return m_type[id]; }
+            GCodeExtrusionRole extrusion_role(size_t id) const  { return m_extrusion_role[id]; }
+            unsigned char      extruder_id(size_t id) const     { return m_extruder_id[id]; }
+            unsigned char      cp_color_id(size_t id) const     { return m_cp_color_id[id]; }
+            const Vec3f&       position(size_t id) const        { return m_position[id]; }
+            float              delta_extruder(size_t id) const  { return m_delta_extruder[id]; }
+            float              feedrate(size_t id) const        { return m_feedrate[id]; }
+            float              width(size_t id) const           { return m_width[id]; }
+            float              height(size_t id) const          { return m_height[id]; }
+            float              mm3_per_mm(size_t id) const      { return m_mm3_per_mm[id]; }
+            float              fan_speed(size_t id) const       { return m_fan_speed[id]; }
+            float              temperature(size_t id) const     { return m_temperature[id]; }
+            float              time(size_t id) const            { return m_time[id]; }
+            bool               internal_only(size_t id) const   { return m_internal_only[id] != 0; }
+            float              volumetric_rate(size_t id) const { return m_feedrate[id] * m_mm3_per_mm[id]; }
+
+            void set_gcode_id(size_t id, unsigned int gcode_id) { m_gcode_id[id] = gcode_id; }
+            void set_width(size_t id, float width)              { m_width.set(id, width); }
+            void set_height(size_t id, float height)            { m_height.set(id, height); }
+
+            // Iterates over the materialized moves.
+            class const_iterator
+            {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type        = MoveVertex;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = void;
+                using reference         = MoveVertex;
+
+                const_iterator(const Moves* moves, size_t id) : m_moves(moves), m_id(id) {}
+                MoveVertex      operator*() const { return (*m_moves)[m_id]; }
+                const_iterator& operator++() { ++ m_id; return *this; }
+                bool            operator==(const const_iterator& rhs) const { return m_id == rhs.m_id; }
+                bool            operator!=(const const_iterator& rhs) const { return m_id != rhs.m_id; }
+
+            private:
+                const Moves* m_moves;
+                size_t       m_id;
+            };
+            const_iterator begin() const { return { this, 0 }; }
+            const_iterator end() const   { return { this, this->size() }; }
+
+        private:
+            // Column of floats stored as 16 bit indices into a palette of distinct values.
+            // The values are stored exactly. Once the palette overflows, the column switches to plain floats.
+            class PaletteColumn
+            {
+            public:
+                float  operator[](size_t id) const { return m_dense ? m_values[id] : m_palette[m_indices[id]]; }
+                void   push_back(float value);
+                void   set(size_t id, float value);
+                void   erase(size_t id);
+                void   clear();
+                void   shrink_to_fit();
+                size_t memory_size() const;
+
+            private:
+                std::optional<uint16_t> palette_index(float value);
+                void                    make_dense();
+
+                bool                                   m_dense { false };
+                std::vector<uint16_t>                  m_indices;
+                std::vector<float>                     m_palette;
+                // Bit pattern of a value -> index of the value in m_palette.
+                std::unordered_map<uint32_t, uint16_t> m_palette_map;
+                // The last value looked up, consecutive moves mostly share their values.
+                uint32_t                               m_last_bits { 0 };
+                uint16_t                               m_last_index { 0 };
+                // Values of a column with too many distinct values.
+                std::vector<float>                     m_values;
+            };
+
+            std::vector<unsigned int>       m_gcode_id;
+            std::vector<EMoveType>          m_type;
+            std::vector<GCodeExtrusionRole> m_extrusion_role;
+            std::vector<unsigned char>      m_extruder_id;
+            std::vector<unsigned char>      m_cp_color_id;
+            std::vector<Vec3f>              m_position;
+            std::vector<float>              m_delta_extruder;
+            PaletteColumn                   m_feedrate;
+            PaletteColumn                   m_width;
+            PaletteColumn                   m_height;
+            PaletteColumn                   m_mm3_per_mm;
+            PaletteColumn                   m_fan_speed;
+            PaletteColumn                   m_temperature;
+            std::vector<float>              m_time;
+            std::vector<unsigned char>      m_internal_only;
+        };
+
         std::string filename;
         unsigned int id;
-        std::vector<MoveVertex> moves;
+        Moves moves;
         // Positions of ends of lines of the final G-code this->filename after TimeProcessor::post_process() finalizes the G-code.
         std::vector<size_t> lines_ends;
         Pointfs bed_shape;
@@ -328,14 +443,29 @@ namespace Slic3r {
             State curr;
             State prev;
             CustomGCodeTime gcode_time;
+            // Blocks owned by the planner, accessed by the background planner task.
             std::vector<TimeBlock> blocks;
+            // Blocks created by process_G1() and not yet handed over to the planner.
+            std::vector<TimeBlock> queued_blocks;
+            // Number of blocks left in this->blocks by the last planning round.
+            size_t planner_kept_blocks;
             std::vector<G1LinesCacheItem> g1_times_cache;
             std::array<float, static_cast<size_t>(EMoveType::Count)> moves_time;
             std::array<float, static_cast<size_t>(GCodeExtrusionRole::Count)> roles_time;
             std::vector<float> layers_time;
+            // Runs calculate_time() in the background, so that the time machines plan concurrently
+            // with each other and with the G-code parser. The times above are valid only after wait_for_planner().
+            tbb::task_group planner;
+
+            ~TimeMachine() { planner.wait(); }
 
             void reset();
 
+            // Any block queued or kept by the planner for the next planning round?
+            bool has_blocks() const { return ! queued_blocks.empty() || planner_kept_blocks > 0; }
+            // Queue a block, hand over the queued blocks to the background planner once enough of them accumulate.
+            void queue_block(const TimeBlock& block);
+            void wait_for_planner() { planner.wait(); }
             // Simulates firmware st_synchronize() call
             void simulate_st_synchronize(float additional_time = 0.0f);
             void calculate_time(size_t keep_last_n_blocks = 0, float additional_time = 0.0f);
@@ -439,12 +569,13 @@ namespace Slic3r {
                 if (!m_move_id.has_value() || !m_custom_gcode_per_print_z_id.has_value())
                     return;
 
-                const Vec3f position = m_result.moves.back().position;
+                const Vec3f position = m_result.moves.position(m_result.moves.size() - 1);
 
-                GCodeProcessorResult::MoveVertex& move = m_result.moves.emplace_back(m_result.moves[*m_move_id]);
+                GCodeProcessorResult::MoveVertex move = m_result.moves[*m_move_id];
                 move.position = position;
                 move.height = height;
-                m_result.moves.erase(m_result.moves.begin() + *m_move_id);
+                m_result.moves.push_back(move);
+                m_result.moves.erase(*m_move_id);
                 m_result.custom_gcode_per_print_z[*m_custom_gcode_per_print_z_id].print_z = position.z();
                 reset();
             }
@@ -642,7 +773,7 @@ namespace Slic3r {
         void initialize_result_moves() {
             // 1st move must be a dummy move
             assert(m_result.moves.empty());
-            m_result.moves.emplace_back(GCodeProcessorResult::MoveVertex());
+            m_result.moves.push_back(GCodeProcessorResult::MoveVertex());
         }
         void process_buffer(const std::string& buffer);
         void finalize(bool post_process);
@@ -0,0 +1,184 @@
+#include "ToolpathLayers.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Slic3r {
+
+ToolpathLayers toolpath_layers(const GCodeProcessorResult &result)
+{
+    const GCodeProcessorResult::Moves &moves = result.moves;
+    ToolpathLayers                     layers;
+
+    // Ids of travel moves with the seams not counted (s_id) and the ids into moves.
+    size_t last_travel_s_id  = 0;
+    size_t first_travel_s_id = 0;
+    size_t last_travel_id    = 0;
+    size_t first_travel_id   = 0;
+    size_t seams_count       = 0;
+    for (size_t i = 0; i < moves.size(); ++ i) {
+        const EMoveType type = moves.type(i);
+        if (type == EMoveType::Seam)
+            ++ seams_count;
+
+        const size_t move_id = i - seams_count;
+
+        if (type == EMoveType::Extrude) {
+            if (! moves.internal_only(i)) {
+                const double z = static_cast<double>(moves.position(i).z());
+                if (layers.empty() || z < layers.zs.back() - EPSILON || layers.zs.back() + EPSILON < z) {
+                    // Start the layer with the first travel move, or with the last travel move before this extrusion.
+                    const bool from_first_travel = layers.empty() && first_travel_s_id != 0;
+                    layers.zs.emplace_back(z);
+                    layers.ranges.push_back({ from_first_travel ? first_travel_s_id : last_travel_s_id, move_id });
+                    layers.moves_ranges.push_back({ from_first_travel ? first_travel_id : last_travel_id, i });
+                } else {
+                    layers.ranges.back().last       = move_id;
+                    layers.moves_ranges.back().last = i;
+                }
+            }
+        } else if (type == EMoveType::Travel) {
+            if (move_id - last_travel_s_id > 1 && ! layers.empty()) {
+                layers.ranges.back().last       = move_id;
+                layers.moves_ranges.back().last = i;
+            } else if (layers.empty() && first_travel_s_id == 0) {
+                first_travel_s_id = move_id;
+                first_travel_id   = i;
+            }
+            last_travel_s_id = move_id;
+            last_travel_id   = i;
+        }
+    }
+
+    // Replace the layers in spiral vase mode.
+    if (! result.spiral_vase_layers.empty()) {
+        layers = ToolpathLayers();
+        for (const auto &[z, range] : result.spiral_vase_layers) {
+            layers.zs.emplace_back(z);
+            layers.ranges.push_back({ range.first, range.second });
+            layers.moves_ranges.push_back({ range.first, range.second });
+        }
+    }
+
+    return layers;
+}
+
+// Are the moves drawn with equal type, color and dimensions, so that they could be merged?
+static bool same_properties(const GCodeProcessorResult::Moves &moves, size_t a, size_t b)
+{
+    return moves.type(a)           == moves.type(b)           &&
+           moves.extrusion_role(a) == moves.extrusion_role(b) &&
+           moves.extruder_id(a)    == moves.extruder_id(b)    &&
+           moves.cp_color_id(a)    == moves.cp_color_id(b)    &&
+           moves.width(a)          == moves.width(b)          &&
+           moves.height(a)         == moves.height(b)         &&
+           moves.feedrate(a)       == moves.feedrate(b)       &&
+           moves.mm3_per_mm(a)     == moves.mm3_per_mm(b)     &&
+           moves.fan_speed(a)      == moves.fan_speed(b)      &&
+           moves.temperature(a)    == moves.temperature(b);
+}
+
+static float squared_distance_to_segment(const Vec3f &p, const Vec3f &a, const Vec3f &b)
+{
+    const Vec3f ab = b - a;
+    const float l2 = ab.squaredNorm();
+    const float t  = l2 > 0.f ? std::clamp((p - a).dot(ab) / l2, 0.f, 1.f) : 0.f;
+    return (a + t * ab - p).squaredNorm();
+}
+
+std::vector<size_t> decimate_toolpaths(const GCodeProcessorResult::Moves &moves, size_t first, size_t last, float tolerance)
+{
+    assert(first <= last && last < moves.size());
+    std::vector<size_t> out;
+    out.emplace_back(first);
+    if (first == last)
+        return out;
+
+    // Bounds the number of moves replaced by a single segment, thus the cost of testing the deviation.
+    static constexpr const size_t max_dropped = 64;
+    const float         tolerance2 = tolerance * tolerance;
+    // Moves dropped since the last kept move.
+    std::vector<size_t> dropped;
+    for (size_t i = first + 1; i < last; ++ i) {
+        // The move i ends at position(i). If it is dropped, the next move starts at the end of the last kept move.
+        const EMoveType type = moves.type(i);
+        bool drop = dropped.size() < max_dropped && (type == EMoveType::Extrude || type == EMoveType::Travel) && same_properties(moves, i, i + 1);
+        if (drop) {
+            const Vec3f &a = moves.position(out.back());
+            const Vec3f &b = moves.position(i + 1);
+            drop = squared_distance_to_segment(moves.position(i), a, b) < tolerance2 &&
+                std::all_of(dropped.begin(), dropped.end(), [&moves, &a, &b, tolerance2](size_t id) {
+                    return squared_distance_to_segment(moves.position(id), a, b) < tolerance2;
+                });
+        }
+        if (drop)
+            dropped.emplace_back(i);
+        else {
+            out.emplace_back(i);
+            dropped.clear();
+        }
+    }
+    out.emplace_back(last);
+    return out;
+}
+
+float toolpath_lod_tolerance(unsigned int lod)
+{
+    // 0.01mm at level 1, about the resolution of the G-code, up to 0.64mm at TOOLPATH_LOD_MAX.
+    return lod == 0 ? 0.f : 0.01f * float(1 << (2 * (std::min(lod, TOOLPATH_LOD_MAX) - 1)));
+}
+
+unsigned int toolpath_lod(float pixel_size)
+{
+    unsigned int lod = 0;
+    while (lod < TOOLPATH_LOD_MAX && toolpath_lod_tolerance(lod + 1) <= pixel_size)
+        ++ lod;
+    return lod;
+}
+
+ToolpathRangeData build_toolpath_range(const GCodeProcessorResult::Moves &moves, const ToolpathLayers &layers, size_t first_layer, size_t last_layer, unsigned int lod)
+{
+    assert(first_layer <= last_layer && last_layer < layers.size());
+    const size_t      first = layers.moves_ranges[first_layer].first;
+    const size_t      last  = layers.moves_ranges[last_layer].last;
+    ToolpathRangeData out;
+
+    // Segment from the end of the previous move drawn to the end of the move id.
+    auto add_segment = [&moves, &out](size_t prev, size_t id) {
+        if (const EMoveType type = moves.type(id); type == EMoveType::Extrude || type == EMoveType::Travel) {
+            out.positions.emplace_back(moves.position(prev));
+            out.positions.emplace_back(moves.position(id));
+            out.move_ids.emplace_back(uint32_t(id));
+        }
+    };
+    if (lod == 0) {
+        out.positions.reserve(2 * (last - first));
+        out.move_ids.reserve(last - first);
+        for (size_t id = first + 1; id <= last; ++ id)
+            add_segment(id - 1, id);
+    } else {
+        const std::vector<size_t> ids = decimate_toolpaths(moves, first, last, toolpath_lod_tolerance(lod));
+        out.positions.reserve(2 * ids.size());
+        out.move_ids.reserve(ids.size());
+        for (size_t i = 1; i < ids.size(); ++ i)
+            add_segment(ids[i - 1], ids[i]);
+    }
+    return out;
+}
+
+ToolpathRangeBuilder::ToolpathRangeBuilder(const GCodeProcessorResult &result, size_t capacity) :
+    m_moves(result.moves),
+    m_layers(toolpath_layers(result)),
+    m_cache(capacity, [](const ToolpathRangeData &data) { return data.memory_size(); })
+{}
+
+const ToolpathRangeData& ToolpathRangeBuilder::get(size_t first_layer, size_t last_layer, unsigned int lod)
+{
+    assert(first_layer <= last_layer && last_layer < m_layers.size());
+    return m_cache.get({ { first_layer, last_layer }, std::min(lod, TOOLPATH_LOD_MAX) }, [this](const Key &key) {
+        ++ m_num_built;
+        return build_toolpath_range(m_moves, m_layers, key.layers.first, key.layers.last, key.lod);
+    });
+}
+
+} // namespace Slic3r
@@ -0,0 +1,158 @@
+#ifndef slic3r_ToolpathLayers_hpp_
+#define slic3r_ToolpathLayers_hpp_
+
+// Preparation of the toolpaths of a processed G-code for the preview.
+// Independent of OpenGL, so that it may be run, tested and benchmarked headless.
+
+#include "GCodeProcessor.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <vector>
+
+namespace Slic3r {
+
+// Layers of the toolpaths of a processed G-code.
+struct ToolpathLayers
+{
+    struct Range
+    {
+        size_t first{ 0 };
+        size_t last{ 0 };
+
+        bool operator==(const Range &rhs) const { return first == rhs.first && last == rhs.last; }
+        bool operator!=(const Range &rhs) const { return ! (*this == rhs); }
+        bool operator<(const Range &rhs) const { return first < rhs.first || (first == rhs.first && last < rhs.last); }
+    };
+
+    // print_z of the layers.
+    std::vector<double> zs;
+    // Ranges of the moves of the layers, with the seam moves not counted, as indexed by the GCodeViewer.
+    std::vector<Range>  ranges;
+    // Ranges of the moves of the layers, indexing GCodeProcessorResult::moves.
+    std::vector<Range>  moves_ranges;
+
+    size_t size() const { return zs.size(); }
+    bool   empty() const { return zs.empty(); }
+};
+
+// Split the moves into layers by the z of the extrusions, or by GCodeProcessorResult::spiral_vase_layers in spiral vase mode.
+ToolpathLayers toolpath_layers(const GCodeProcessorResult &result);
+
+// Simplify the moves [first, last] for displaying them from far away. Returns ids of the moves to keep.
+// A move is dropped if the next move continues it with equal type and properties and if dropping it moves
+// the resulting polyline by less than tolerance (mm). The first and the last move are always kept.
+std::vector<size_t> decimate_toolpaths(const GCodeProcessorResult::Moves &moves, size_t first, size_t last, float tolerance);
+
+// Levels of detail of the toolpaths: Level 0 shows all the moves, the higher levels are decimated
+// with a tolerance growing four times with each level.
+static constexpr const unsigned int TOOLPATH_LOD_MAX = 4;
+// Tolerance (mm) of decimate_toolpaths() at a level of detail.
+float        toolpath_lod_tolerance(unsigned int lod);
+// The coarsest level of detail, whose tolerance does not exceed the size of a screen pixel in mm.
+unsigned int toolpath_lod(float pixel_size);
+
+// Vertex data of the toolpaths of a range of layers, prepared for the preview.
+struct ToolpathRangeData
+{
+    // Two vertices per segment: The end of the previous move and the end of the move drawn.
+    std::vector<Vec3f>    positions;
+    // Id into GCodeProcessorResult::moves of the move drawn by each segment.
+    // If the moves were decimated, a segment stands for the moves dropped before it, too.
+    std::vector<uint32_t> move_ids;
+
+    size_t num_segments() const { return move_ids.size(); }
+    size_t memory_size() const { return positions.capacity() * sizeof(Vec3f) + move_ids.capacity() * sizeof(uint32_t); }
+};
+
+// Build the segments of the extrusions and travels of layers [first_layer, last_layer] at the level of detail.
+ToolpathRangeData build_toolpath_range(const GCodeProcessorResult::Moves &moves, const ToolpathLayers &layers, size_t first_layer, size_t last_layer, unsigned int lod);
+
+// Least recently used cache of data built for ranges of layers, limited by the total size of the data.
+template<typename Key, typename Data>
+class LayerRangeCache
+{
+public:
+    // capacity - maximum total size of the cached data, as returned by data_size.
+    LayerRangeCache(size_t capacity, std::function<size_t(const Data&)> data_size) :
+        m_capacity(capacity), m_data_size(std::move(data_size)) {}
+
+    // Returns the cached data of the key, or builds it by build(key) and caches it.
+    // Cached data of other keys may be evicted, invalidating references returned by former calls.
+    template<typename BuildFn>
+    const Data& get(const Key &key, BuildFn &&build) {
+        if (auto it = m_map.find(key); it != m_map.end()) {
+            // Move to the front of the LRU list.
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            return it->second->data;
+        }
+        Data   data = build(key);
+        size_t size = m_data_size(data);
+        // Evict the least recently used data, but keep at least the data being inserted.
+        while (! m_lru.empty() && m_size + size > m_capacity) {
+            m_size -= m_lru.back().size;
+            m_map.erase(m_lru.back().key);
+            m_lru.pop_back();
+        }
+        m_lru.push_front({ key, std::move(data), size });
+        m_map.insert({ key, m_lru.begin() });
+        m_size += size;
+        return m_lru.front().data;
+    }
+
+    bool   contains(const Key &key) const { return m_map.find(key) != m_map.end(); }
+    size_t size() const { return m_lru.size(); }
+    // Total size of the cached data.
+    size_t data_size() const { return m_size; }
+    void   clear() { m_lru.clear(); m_map.clear(); m_size = 0; }
+
+private:
+    struct Entry {
+        Key    key;
+        Data   data;
+        size_t size;
+    };
+
+    size_t                                                  m_capacity;
+    std::function<size_t(const Data&)>                      m_data_size;
+    size_t                                                  m_size { 0 };
+    // The most recently used data first.
+    std::list<Entry>                                        m_lru;
+    std::map<Key, typename std::list<Entry>::iterator>      m_map;
+};
+
+// Builds the vertex data of the toolpaths on demand for the layer ranges being displayed,
+// keeping the most recently displayed ranges up to a memory limit.
+class ToolpathRangeBuilder
+{
+public:
+    // The result has to outlive the builder.
+    ToolpathRangeBuilder(const GCodeProcessorResult &result, size_t capacity);
+
+    const ToolpathLayers&       layers() const { return m_layers; }
+    // Vertex data of layers [first_layer, last_layer] at the level of detail.
+    // The reference is valid until the next call to get().
+    const ToolpathRangeData&    get(size_t first_layer, size_t last_layer, unsigned int lod);
+    // Number of layer ranges built since construction, thus not served from the cache.
+    size_t                      num_built() const { return m_num_built; }
+    // Memory held by the cached layer ranges.
+    size_t                      cache_size() const { return m_cache.data_size(); }
+
+private:
+    struct Key {
+        ToolpathLayers::Range   layers;
+        unsigned int            lod;
+        bool operator<(const Key &rhs) const { return layers < rhs.layers || (layers == rhs.layers && lod < rhs.lod); }
+    };
+
+    const GCodeProcessorResult::Moves          &m_moves;
+    ToolpathLayers                              m_layers;
+    LayerRangeCache<Key, ToolpathRangeData>     m_cache;
+    size_t                                      m_num_built { 0 };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_ToolpathLayers_hpp_
@@ -10,6 +10,10 @@
 
 #include "LocalesUtils.hpp"
 
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+
 #include <fast_float/fast_float.h>
 
 namespace Slic3r {
@@ -35,6 +39,19 @@ void GCodeReader::apply_config(const DynamicPrintConfig &config)
 }
 
 const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
+{
+    const char *c = this->parse_line_tokens(ptr, end, gline, command);
+
+    if (gline.has(E) && m_config.use_relative_e_distances)
+        m_position[E] = 0;
+
+    if (m_verbose)
+        std::cout << gline.m_raw << std::endl;
+
+    return c;
+}
+
+const char* GCodeReader::parse_line_tokens(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command) const
 {
     assert(is_decimal_separator_point());
     
@@ -86,9 +103,6 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 c = skip_word(c);
         }
     }
-    
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
 
     // Skip the rest of the line.
     for (; ! is_end_of_line(*c); ++ c);
@@ -103,9 +117,6 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
 	if (*c == '\n')
 		++ c;
 
-    if (m_verbose)
-        std::cout << gline.m_raw << std::endl;
-
     return c;
 }
 
@@ -178,16 +189,141 @@ bool GCodeReader::parse_file_raw_internal(const std::string &filename, ParseLine
     return true;
 }
 
+struct GCodeReader::FileChunk
+{
+    // Whole lines of the G-code, the last line may be missing its end of line only at the end of the file.
+    std::string                 buffer;
+    // Position of buffer in the G-code file.
+    size_t                      file_pos { 0 };
+    std::vector<GCodeLine>      lines;
+    // Position in the file after the '\n' ending each line, zero if the line was not terminated by '\n'.
+    std::vector<size_t>         lines_ends;
+};
+
+void GCodeReader::parse_chunk(FileChunk &chunk) const
+{
+    // fast_float is locale independent, parse_line_tokens() asserts the "C" locale anyways.
+    CNumericLocalesSetter locales_setter;
+    const char *ptr = chunk.buffer.c_str();
+    const char *end = ptr + chunk.buffer.size();
+    chunk.lines.clear();
+    chunk.lines_ends.clear();
+    while (ptr < end) {
+        GCodeLine &gline = chunk.lines.emplace_back();
+        std::pair<const char*, const char*> cmd;
+        const char *line_end = this->parse_line_tokens(ptr, end, gline, cmd);
+        if (line_end < end && *line_end == 0) {
+            // Zero character inside a line. Ignore the rest of the line.
+            for (; line_end < end && *line_end != '\r' && *line_end != '\n'; ++ line_end) ;
+            if (line_end < end && *line_end == '\r')
+                ++ line_end;
+            if (line_end < end && *line_end == '\n')
+                ++ line_end;
+        }
+        chunk.lines_ends.emplace_back(line_end[-1] == '\n' ? chunk.file_pos + (line_end - chunk.buffer.c_str()) : 0);
+        ptr = line_end;
+    }
+}
+
+// Parsing is split into two phases: Blocks of whole lines are read and tokenized in parallel in the background,
+// while the stateful update of the reader and the callbacks are executed sequentially on the calling thread.
 template<typename ParseLineCallback, typename LineEndCallback>
 bool GCodeReader::parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback)
 {
-    GCodeLine gline;    
-    return this->parse_file_raw_internal(filename, 
-        [this, &gline, parse_line_callback](const char *begin, const char *end) {
-            gline.reset();
-            this->parse_line(begin, end, gline, parse_line_callback);
-        }, 
-        line_end_callback);
+    FilePtr in{ boost::nowide::fopen(filename.c_str(), "rb") };
+    if (in.f == nullptr)
+        return false;
+
+    static constexpr const size_t chunk_size = 256 * 1024;
+    const size_t num_chunks = 2 * size_t(tbb::this_task_arena::max_concurrency());
+
+    // Partial line at the end of the last chunk read.
+    std::string carry;
+    size_t      file_pos   = 0;
+    bool        eof        = false;
+    bool        read_error = false;
+    // Read a batch of chunks and parse them in parallel.
+    auto read_and_parse = [this, &in, &carry, &file_pos, &eof, &read_error, num_chunks](std::vector<FileChunk> &chunks) {
+        chunks.clear();
+        while (chunks.size() < num_chunks && ! eof) {
+            FileChunk &chunk = chunks.emplace_back();
+            chunk.buffer   = std::move(carry);
+            chunk.file_pos = file_pos - chunk.buffer.size();
+            carry.clear();
+            for (;;) {
+                size_t old_size = chunk.buffer.size();
+                chunk.buffer.resize(old_size + chunk_size);
+                size_t cnt_read = ::fread(chunk.buffer.data() + old_size, 1, chunk_size, in.f);
+                chunk.buffer.resize(old_size + cnt_read);
+                file_pos += cnt_read;
+                if (::ferror(in.f)) {
+                    read_error = true;
+                    eof        = true;
+                    break;
+                }
+                if (cnt_read == 0) {
+                    eof = true;
+                    break;
+                }
+                // Find the last end of line, memrchr is not portable.
+                size_t i = chunk.buffer.size();
+                for (; i > old_size && chunk.buffer[i - 1] != '\n'; -- i) ;
+                if (i > old_size) {
+                    carry.assign(chunk.buffer.begin() + i, chunk.buffer.end());
+                    chunk.buffer.erase(i);
+                    break;
+                }
+            }
+        }
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, chunks.size(), 1), [this, &chunks](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                this->parse_chunk(chunks[i]);
+        });
+    };
+
+    std::vector<FileChunk> chunks;
+    std::vector<FileChunk> chunks_next;
+    read_and_parse(chunks);
+    m_parsing = true;
+    tbb::task_group background;
+    try {
+        while (! chunks.empty()) {
+            if (! eof)
+                background.run([&read_and_parse, &chunks_next]() { read_and_parse(chunks_next); });
+            for (FileChunk &chunk : chunks)
+                for (size_t i = 0; i < chunk.lines.size(); ++ i) {
+                    GCodeLine &gline = chunk.lines[i];
+                    if (gline.has(E) && m_config.use_relative_e_distances)
+                        m_position[E] = 0;
+                    if (m_verbose)
+                        std::cout << gline.m_raw << std::endl;
+                    parse_line_callback(*this, gline);
+                    std::pair<const char*, const char*> cmd;
+                    cmd.first  = skip_whitespaces(gline.m_raw.c_str());
+                    cmd.second = skip_word(cmd.first);
+                    update_coordinates(gline, cmd);
+                    if (! m_parsing) {
+                        // The callback wishes to exit.
+                        background.wait();
+                        return true;
+                    }
+                    if (chunk.lines_ends[i] != 0)
+                        line_end_callback(chunk.lines_ends[i]);
+                }
+            background.wait();
+            chunks.swap(chunks_next);
+            chunks_next.clear();
+        }
+    } catch (...) {
+        // Don't let the background task outlive the data it works on.
+        background.cancel();
+        try {
+            background.wait();
+        } catch (...) {
+        }
+        throw;
+    }
+    return ! read_error;
 }
 
 bool GCodeReader::parse_file(const std::string &file, callback_t callback)
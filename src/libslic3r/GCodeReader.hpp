@@ -156,12 +156,19 @@ public:
 //  void   set_extrusion_axis(char axis) { m_extrusion_axis = axis; }
 
 private:
+    // Block of whole lines of a G-code file, parsed in parallel by parse_file_internal().
+    struct FileChunk;
+
     template<typename ParseLineCallback, typename LineEndCallback>
     bool        parse_file_raw_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
     template<typename ParseLineCallback, typename LineEndCallback>
     bool        parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
+    // Parse lines of a chunk into GCodeLines. Does not modify the state of the reader, thus it may be called from multiple threads.
+    void        parse_chunk(FileChunk &chunk) const;
 
     const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    // Tokenize a single line without modifying the state of the reader.
+    const char* parse_line_tokens(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command) const;
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
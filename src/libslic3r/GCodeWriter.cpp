@@ -49,6 +49,37 @@ void GCodeWriter::set_extruders(std::vector<unsigned int> extruder_ids)
     this->multiple_extruders = (*std::max_element(extruder_ids.begin(), extruder_ids.end())) > 0;
 }
 
+GCodeWriter::State GCodeWriter::state() const
+{
+    State out;
+    out.extruders.reserve(m_extruders.size());
+    for (const Extruder &extruder : m_extruders)
+        out.extruders.emplace_back(extruder.state());
+    out.active_extruder              = m_extruder == nullptr ? -1 : int(m_extruder - m_extruders.data());
+    out.position                     = m_pos;
+    out.lifted                       = m_lifted;
+    out.last_acceleration            = m_last_acceleration;
+    out.last_travel_acceleration     = m_last_travel_acceleration;
+    out.last_bed_temperature         = m_last_bed_temperature;
+    out.last_bed_temperature_reached = m_last_bed_temperature_reached;
+    return out;
+}
+
+void GCodeWriter::set_state(const State &state)
+{
+    assert(state.extruders.size() == m_extruders.size());
+    assert(state.active_extruder < int(m_extruders.size()));
+    for (size_t i = 0; i < m_extruders.size(); ++ i)
+        m_extruders[i].set_state(state.extruders[i]);
+    m_extruder                     = state.active_extruder == -1 ? nullptr : &m_extruders[state.active_extruder];
+    m_pos                          = state.position;
+    m_lifted                       = state.lifted;
+    m_last_acceleration            = state.last_acceleration;
+    m_last_travel_acceleration     = state.last_travel_acceleration;
+    m_last_bed_temperature         = state.last_bed_temperature;
+    m_last_bed_temperature_reached = state.last_bed_temperature_reached;
+}
+
 std::string GCodeWriter::preamble()
 {
     std::ostringstream gcode;
@@ -245,7 +276,7 @@ std::string GCodeWriter::toolchange(unsigned int extruder_id)
     return gcode.str();
 }
 
-std::string GCodeWriter::set_speed(double F, const std::string &comment, const std::string &cooling_marker) const
+void GCodeWriter::set_speed(std::string &out, double F, const std::string &comment, const std::string &cooling_marker) const
 {
     assert(F > 0.);
     assert(F < 100000.);
@@ -254,10 +285,10 @@ std::string GCodeWriter::set_speed(double F, const std::string &comment, const s
     w.emit_f(F);
     w.emit_comment(this->config.gcode_comments, comment);
     w.emit_string(cooling_marker);
-    return w.string();
+    w.append_to(out);
 }
 
-std::string GCodeWriter::travel_to_xy(const Vec2d &point, const std::string &comment)
+void GCodeWriter::travel_to_xy(std::string &out, const Vec2d &point, const std::string &comment)
 {
     m_pos.x() = point.x();
     m_pos.y() = point.y();
@@ -266,7 +297,7 @@ std::string GCodeWriter::travel_to_xy(const Vec2d &point, const std::string &com
     w.emit_xy(point);
     w.emit_f(this->config.travel_speed.value * 60.0);
     w.emit_comment(this->config.gcode_comments, comment);
-    return w.string();
+    w.append_to(out);
 }
 
 std::string GCodeWriter::travel_to_xyz(const Vec3d &point, const std::string &comment)
@@ -348,7 +379,7 @@ bool GCodeWriter::will_move_z(double z) const
     return true;
 }
 
-std::string GCodeWriter::extrude_to_xy(const Vec2d &point, double dE, const std::string &comment)
+void GCodeWriter::extrude_to_xy(std::string &out, const Vec2d &point, double dE, const std::string &comment)
 {
     m_pos.x() = point.x();
     m_pos.y() = point.y();
@@ -357,7 +388,7 @@ std::string GCodeWriter::extrude_to_xy(const Vec2d &point, double dE, const std:
     w.emit_xy(point);
     w.emit_e(m_extrusion_axis, m_extruder->extrude(dE).second);
     w.emit_comment(this->config.gcode_comments, comment);
-    return w.string();
+    w.append_to(out);
 }
 
 #if 0
@@ -56,12 +56,20 @@ public:
     // printed with the same extruder.
     std::string toolchange_prefix() const;
     std::string toolchange(unsigned int extruder_id);
-    std::string set_speed(double F, const std::string &comment = std::string(), const std::string &cooling_marker = std::string()) const;
-    std::string travel_to_xy(const Vec2d &point, const std::string &comment = std::string());
+    std::string set_speed(double F, const std::string &comment = std::string(), const std::string &cooling_marker = std::string()) const
+        { std::string out; this->set_speed(out, F, comment, cooling_marker); return out; }
+    std::string travel_to_xy(const Vec2d &point, const std::string &comment = std::string())
+        { std::string out; this->travel_to_xy(out, point, comment); return out; }
     std::string travel_to_xyz(const Vec3d &point, const std::string &comment = std::string());
     std::string travel_to_z(double z, const std::string &comment = std::string());
     bool        will_move_z(double z) const;
-    std::string extrude_to_xy(const Vec2d &point, double dE, const std::string &comment = std::string());
+    std::string extrude_to_xy(const Vec2d &point, double dE, const std::string &comment = std::string())
+        { std::string out; this->extrude_to_xy(out, point, dE, comment); return out; }
+    // Variants appending the G-code to out. Used by the hot loops of the G-code export, where a temporary
+    // string per G-code line would be allocated otherwise.
+    void        set_speed(std::string &out, double F, const std::string &comment = std::string(), const std::string &cooling_marker = std::string()) const;
+    void        travel_to_xy(std::string &out, const Vec2d &point, const std::string &comment = std::string());
+    void        extrude_to_xy(std::string &out, const Vec2d &point, double dE, const std::string &comment = std::string());
 //    std::string extrude_to_xyz(const Vec3d &point, double dE, const std::string &comment = std::string());
     std::string retract(bool before_wipe = false);
     std::string retract_for_toolchange(bool before_wipe = false);
@@ -81,6 +89,23 @@ public:
     // by this function while the current Z-hop accumulator is updated.
     void        update_position(const Vec3d &new_pos);
 
+    // State of the extruders and of the print head, which is carried over from one layer to the next.
+    // Used to continue G-code generation after the G-code of the layers was spliced from GCodeLayersCache.
+    struct State {
+        // Indexed by the order of extruders(), thus only valid for the same set of extruders.
+        std::vector<Extruder::State> extruders;
+        // Index of the active extruder in extruders(), -1 if no extruder is active.
+        int                          active_extruder { -1 };
+        Vec3d                        position { Vec3d::Zero() };
+        double                       lifted { 0 };
+        unsigned int                 last_acceleration { (unsigned int)(-1) };
+        unsigned int                 last_travel_acceleration { (unsigned int)(-1) };
+        unsigned int                 last_bed_temperature { 0 };
+        bool                         last_bed_temperature_reached { true };
+    };
+    State       state() const;
+    void        set_state(const State &state);
+
     // Returns whether this flavor supports separate print and travel acceleration.
     static bool supports_separate_travel_acceleration(GCodeFlavor flavor);
 
@@ -198,6 +223,12 @@ public:
         return std::string(this->buf, ptr_err.ptr - buf);
     }
 
+    // Append the formatted line to out, without a temporary string.
+    void append_to(std::string &out) {
+        *ptr_err.ptr ++ = '\n';
+        out.append(this->buf, ptr_err.ptr - buf);
+    }
+
 protected:
     static constexpr const size_t   buflen = 256;
     char                            buf[buflen];
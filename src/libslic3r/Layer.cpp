@@ -608,6 +608,24 @@ ExPolygons Layer::merged(float offset_scaled) const
     return out;
 }
 
+void Layer::release_exported_data()
+{
+    for (LayerRegion *layerm : m_regions)
+        layerm->release_data();
+    // The islands reference the extrusions of the layer regions.
+    lslices_ex                              = {};
+    lslice_indices_sorted_by_print_order    = {};
+    curled_lines                            = {};
+}
+
+void SupportLayer::release_exported_data()
+{
+    Layer::release_exported_data();
+    support_islands         = {};
+    support_islands_bboxes  = {};
+    support_fills.clear();
+}
+
 // Here the perimeters are created cummulatively for all layer regions sharing the same parameters influencing the perimeters.
 // The perimeter paths and the thin fills (ExtrusionEntityCollection) are assigned to the first compatible layer region.
 // The resulting fill surface is split back among the originating regions.
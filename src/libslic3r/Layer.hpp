@@ -166,6 +166,8 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     bool    has_extrusions() const { return ! this->perimeters().empty() || ! this->fills().empty(); }
+    // Release all slices and extrusions, see Layer::release_exported_data().
+    void    release_data();
 
 protected:
     friend class Layer;
@@ -385,6 +387,11 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     virtual bool            has_extrusions() const { for (auto layerm : m_regions) if (layerm->has_extrusions()) return true; return false; }
+    // Release slices and extrusions of this layer after the layer was converted to G-code in Print::low_memory_mode().
+    // Only the Z coordinates, the links to the neighbor layers and lslices are kept, lslices are read
+    // by the G-code export of the layers above, see release_lslices().
+    virtual void            release_exported_data();
+    void                    release_lslices() { lslices = {}; }
 //    virtual bool            has_extrusions() const { for (const LayerSlice &lslice : lslices_ex) if (lslice.has_extrusions()) return true; return false; }
 
 protected:
@@ -438,6 +445,7 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     virtual bool                has_extrusions() const { return ! support_fills.empty(); }
+    void                        release_exported_data() override;
 
     // Zero based index of an interface layer, used for alternating direction of interface / contact layers.
     size_t                      interface_id() const { return m_interface_id; }
@@ -852,6 +852,22 @@ void LayerRegion::elephant_foot_compensation_step(const float elephant_foot_comp
     m_slices.set(union_ex(tmp), stInternal);
 }
 
+void LayerRegion::release_data()
+{
+    // Assigning an empty container releases the memory, clear() keeps the capacity.
+    m_raw_slices                        = {};
+    m_slices.surfaces                   = {};
+    m_fill_expolygons                   = {};
+    m_fill_expolygons_bboxes            = {};
+    m_fill_expolygons_composite         = {};
+    m_fill_expolygons_composite_bboxes  = {};
+    m_fill_surfaces.surfaces            = {};
+    m_unsupported_bridge_edges          = {};
+    m_thin_fills.clear();
+    m_perimeters.clear();
+    m_fills.clear();
+}
+
 void LayerRegion::export_region_slices_to_svg(const char *path) const
 {
     BoundingBox bbox;
@@ -19,7 +19,9 @@
 #include <float.h>
 
 #include <algorithm>
+#include <deque>
 #include <limits>
+#include <map>
 #include <string>
 #include <unordered_set>
 #include <boost/filesystem/path.hpp>
@@ -27,6 +29,8 @@
 #include <boost/log/trivial.hpp>
 #include <boost/regex.hpp>
 
+#include <tbb/flow_graph.h>
+
 namespace Slic3r {
 
 template class PrintState<PrintStep, psCount>;
@@ -45,6 +49,7 @@ void Print::clear()
 	m_objects.clear();
     m_print_regions.clear();
     m_model.clear_objects();
+    m_gcode_layers_cache.reset();
 }
 
 // Called by Print::apply().
@@ -900,20 +905,7 @@ void Print::process()
     name_tbb_thread_pool_threads_set_locale();
 
     BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
-    for (PrintObject *obj : m_objects)
-        obj->make_perimeters();
-    for (PrintObject *obj : m_objects)
-        obj->infill();
-    for (PrintObject *obj : m_objects)
-        obj->ironing();
-    for (PrintObject *obj : m_objects)
-        obj->generate_support_spots();
-    // check data from previous step, format the error message(s) and send alert to ui
-    alert_when_supports_needed();
-    for (PrintObject *obj : m_objects)
-        obj->generate_support_material();
-    for (PrintObject *obj : m_objects)
-        obj->estimate_curled_extrusions();
+    this->process_objects();
     if (this->set_started(psWipeTower)) {
         m_wipe_tower_data.clear();
         m_tool_ordering.clear();
@@ -977,6 +969,70 @@ void Print::process()
     BOOST_LOG_TRIVIAL(info) << "Slicing process finished." << log_memory_info();
 }
 
+// Run the PrintObject steps (perimeters / infill / ironing / support spots / support material / curled extrusions)
+// of all objects as a TBB flow graph instead of barrier synchronized loops over all objects.
+// Slicing is not a node of its own, it is run by make_perimeters() as its prerequisite.
+// The steps of a single object are chained in the PrintObjectStep order, while there are no edges between the chains
+// of different objects, thus perimeters of one object may be calculated while another object is being infilled
+// and the idle TBB workers pick up work of other objects at the end of each step.
+// There are just two synchronization points shared by multiple objects:
+// 1) Objects sharing PrintObjectRegions share the support spots search result, the first object of such a group
+//    calculates it, therefore the support spots search is serialized inside the group.
+// 2) psAlertWhenSupportsNeeded collects the support spots of all objects. It precedes the support material generation
+//    of all objects, so that its warning is issued before any support material is generated.
+// Exceptions (including CanceledException) thrown by the steps cancel the graph and they are rethrown by wait_for_all().
+// As the steps of different objects interleave, the reported progress is clamped to never go backwards.
+void Print::process_objects()
+{
+    m_status_percent   = -1;
+    m_status_monotonic = true;
+    ScopeGuard status_monotonic_guard([this]() { m_status_monotonic = false; });
+
+    using StepNode = tbb::flow::continue_node<tbb::flow::continue_msg>;
+
+    tbb::flow::graph                                    graph;
+    tbb::flow::broadcast_node<tbb::flow::continue_msg>  start(graph);
+    // std::deque does not move its elements when growing, the graph nodes are not movable.
+    std::deque<StepNode>                                nodes;
+    auto add_node = [&graph, &nodes](auto &&step) -> StepNode& {
+        nodes.emplace_back(graph, [step](const tbb::flow::continue_msg&) { step(); });
+        return nodes.back();
+    };
+    auto add_chain = [&add_node](StepNode *prev, std::initializer_list<std::function<void()>> steps) -> StepNode* {
+        for (const std::function<void()> &step : steps) {
+            StepNode &node = add_node(step);
+            if (prev != nullptr)
+                tbb::flow::make_edge(*prev, node);
+            prev = &node;
+        }
+        return prev;
+    };
+
+    // Check data from the support spots search, format the error message(s) and send alert to UI.
+    StepNode &alert = add_node([this]() { this->alert_when_supports_needed(); });
+    tbb::flow::make_edge(start, alert);
+    // Last support spots node of a group of objects sharing PrintObjectRegions.
+    std::map<const PrintObjectRegions*, StepNode*> last_support_spots;
+    for (PrintObject *obj : m_objects) {
+        StepNode &perimeters = add_node([obj]() { obj->make_perimeters(); });
+        tbb::flow::make_edge(start, perimeters);
+        StepNode *ironing = add_chain(&perimeters, { [obj]() { obj->infill(); }, [obj]() { obj->ironing(); } });
+        StepNode &support_spots = add_node([obj]() { obj->generate_support_spots(); });
+        tbb::flow::make_edge(*ironing, support_spots);
+        StepNode *&last = last_support_spots[obj->shared_regions()];
+        if (last != nullptr)
+            tbb::flow::make_edge(*last, support_spots);
+        last = &support_spots;
+        tbb::flow::make_edge(support_spots, alert);
+        // The alert about the missing supports is issued before any support material is generated, as with the sequential
+        // processing, thus the support material of all objects waits for the support spots search of all objects.
+        add_chain(&alert, { [obj]() { obj->generate_support_material(); }, [obj]() { obj->estimate_curled_extrusions(); } });
+    }
+
+    start.try_put(tbb::flow::continue_msg());
+    graph.wait_for_all();
+}
+
 // G-code export process, running at a background thread.
 // The export_gcode may die for various reasons (fails to process output_filename_format,
 // write error into the G-code, cannot execute post-processing scripts).
@@ -1003,6 +1059,13 @@ std::string Print::export_gcode(const std::string& path_template, GCodeProcessor
     if (m_conflict_result.has_value())
         result->conflict_result = *m_conflict_result;
 
+    if (m_low_memory_mode) {
+        // The layers were released while being exported, the slicing result is no more valid.
+        std::scoped_lock<std::mutex> lock(this->state_mutex());
+        for (PrintObject *object : m_objects)
+            object->invalidate_step(posSlice);
+    }
+
     return path.c_str();
 }
 
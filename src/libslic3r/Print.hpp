@@ -23,6 +23,7 @@
 #include <Eigen/Geometry>
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <set>
 #include <tcbspan/span.hpp>
@@ -30,6 +31,7 @@
 namespace Slic3r {
 
 class GCode;
+struct GCodeLayersCache;
 class Layer;
 class ModelObject;
 class Print;
@@ -632,6 +634,21 @@ public:
     const PrintStatistics&      print_statistics() const { return m_print_statistics; }
     PrintStatistics&            print_statistics() { return m_print_statistics; }
 
+    // Low memory mode for single shot (command line) slicing: The infill acceleration structures are released
+    // once the infill is generated and the slices / extrusions of each layer are released as soon as the layer
+    // is converted to G-code, thus the memory is returned as the G-code export progresses. With avoid_crossing_perimeters,
+    // the outlines of a layer (lslices) are kept until no other layer being exported reads them. The peak memory is not bounded:
+    // all layers are still held in memory when the G-code export starts.
+    // The slicing result cannot be reused after the G-code export, all PrintObject steps are invalidated.
+    // Not to be used by the GUI, which keeps the slicing result for the preview.
+    bool                        low_memory_mode() const { return m_low_memory_mode; }
+    void                        set_low_memory_mode(bool enable) { m_low_memory_mode = enable; }
+
+    // Directory of the persistent slice cache (see SliceCache.hpp), empty if the slice cache is disabled.
+    // Only the result of posSlice is cached, the later steps are always calculated.
+    const std::string&          slice_cache_dir() const { return m_slice_cache_dir; }
+    void                        set_slice_cache_dir(const std::string &dir) { m_slice_cache_dir = dir; }
+
     // Wipe tower support.
     bool                        has_wipe_tower() const;
     const WipeTowerData&        wipe_tower_data(size_t extruders_cnt = 0) const;
@@ -644,6 +661,8 @@ public:
     const ToolOrdering&         get_tool_ordering() const { return m_wipe_tower_data.tool_ordering; }
 
     const Polygons& get_sequential_print_clearance_contours() const { return m_sequential_print_clearance_contours; }
+    // G-code of the layers kept from the last G-code export, nullptr if none. Used by the unit tests.
+    const GCodeLayersCache* gcode_layers_cache() const { return m_gcode_layers_cache.get(); }
     static bool sequential_print_horizontal_clearance_valid(const Print& print, Polygons* polygons = nullptr);
 
 protected:
@@ -657,6 +676,8 @@ private:
     void                _make_wipe_tower();
     void                finalize_first_layer_convex_hull();
     void                alert_when_supports_needed();
+    // Run the PrintObject steps of all objects as a dependency graph, so that steps of different objects overlap.
+    void                process_objects();
 
     // Islands of objects and their supports extruded at the 1st layer.
     Polygons            first_layer_islands() const;
@@ -692,6 +713,9 @@ private:
 
     // Estimated print time, filament consumed.
     PrintStatistics                         m_print_statistics;
+    // G-code of the layers generated by the last G-code export, to be reused if only the start / end G-code
+    // or the G-code filters were reconfigured. Owned by GCode, see GCodeLayersCache.
+    std::shared_ptr<GCodeLayersCache>       m_gcode_layers_cache;
 
     // Cache to store sequential print clearance contours
     Polygons m_sequential_print_clearance_contours;
@@ -705,6 +729,9 @@ private:
 
     ConflictResultOpt m_conflict_result;
     FakeWipeTower     m_fake_wipe_tower;
+
+    bool              m_low_memory_mode { false };
+    std::string       m_slice_cache_dir;
 };
 
 } /* slic3r_Print_hpp_ */
@@ -122,4 +122,9 @@ void PrintObjectBase::status_update_warnings(PrintBase *print, int step, PrintSt
     print->status_update_warnings(step, warning_level, message, this);
 }
 
+void PrintObjectBase::step_update(PrintBase *print, int step, bool done) const
+{
+    print->step_update(step, done, this);
+}
+
 } // namespace Slic3r
@@ -2,6 +2,7 @@
 #define slic3r_PrintBase_hpp_
 
 #include "libslic3r.h"
+#include <algorithm>
 #include <set>
 #include <vector>
 #include <string>
@@ -372,6 +373,8 @@ protected:
 	// The UI will be notified by calling a status callback registered on print.
 	// If no status callback is registered, the message is printed to console.
 	void 				   				status_update_warnings(PrintBase *print, int step, PrintStateBase::WarningLevel warning_level, const std::string &message);
+	// Notify the step callback registered on print, that a step of this PrintObjectBase was started or finished.
+	void 								step_update(PrintBase *print, int step, bool done) const;
 
     ModelObject                  *m_model_object;
 };
@@ -490,10 +493,22 @@ public:
     void                    set_status_callback(status_callback_type cb) { m_status_callback = cb; }
     // Calls a registered callback to update the status, or print out the default message.
     void                    set_status(int percent, const std::string &message, unsigned int flags = SlicingStatus::DEFAULT) {
+        std::unique_lock<std::mutex> lock(m_status_mutex, std::defer_lock);
+        if (m_status_monotonic) {
+            // Steps of multiple objects are reporting concurrently, don't let the progress go backwards.
+            lock.lock();
+            percent = m_status_percent = std::max(m_status_percent, percent);
+        }
 		if (m_status_callback) m_status_callback(SlicingStatus(percent, message, flags));
         else printf("%d => %s\n", percent, message.c_str());
     }
 
+    // Callback evoked whenever a step of the Print or of one of its PrintObjects is started or finished, to be used for profiling.
+    // print_object is null for the Print steps, step is PrintStep / PrintObjectStep of the respective printer technology.
+    // The callback is called by the worker threads, for multiple PrintObjects in parallel.
+    typedef std::function<void(const PrintObjectBase *print_object, int step, bool done)> step_callback_type;
+    void                    set_step_callback(step_callback_type cb) { m_step_callback = cb; }
+
     typedef std::function<void()>  cancel_callback_type;
     // Various methods will call this callback to stop the background processing (the Print::process() call)
     // in case a successive change of the Print / PrintObject / PrintRegion instances changed
@@ -538,6 +553,8 @@ protected:
 	// The UI will be notified by calling a status callback.
 	// If no status callback is registered, the message is printed to console.
     void 				   status_update_warnings(int step, PrintStateBase::WarningLevel warning_level, const std::string &message, const PrintObjectBase* print_object = nullptr);
+    void                   step_update(int step, bool done, const PrintObjectBase *print_object = nullptr) const
+        { if (m_step_callback) m_step_callback(print_object, step, done); }
 
     // If the background processing stop was requested, throw CanceledException.
     // To be called by the worker thread and its sub-threads (mostly launched on the TBB thread pool) regularly.
@@ -556,6 +573,13 @@ protected:
 
     // Callback to be evoked regularly to update state of the UI thread.
     status_callback_type                    m_status_callback;
+    // Callback to be evoked when a step is started or finished.
+    step_callback_type                      m_step_callback;
+    // Set while the steps of multiple PrintObjects run concurrently, see Print::process_objects().
+    // set_status() then reports the maximum of the percentages reported so far.
+    bool                                    m_status_monotonic { false };
+    int                                     m_status_percent { -1 };
+    std::mutex                              m_status_mutex;
 
 private:
     std::atomic<CancelStatus>               m_cancel_status;
@@ -585,9 +609,15 @@ public:
     PrintStateBase::StateWithWarnings  step_state_with_warnings(PrintStepEnum step) const { return m_state.state_with_warnings(step, this->state_mutex()); }
 
 protected:
-    bool            set_started(PrintStepEnum step) { return m_state.set_started(step, this->state_mutex(), [this](){ this->throw_if_canceled(); }); }
+    bool            set_started(PrintStepEnum step) { 
+        bool started = m_state.set_started(step, this->state_mutex(), [this](){ this->throw_if_canceled(); });
+        if (started)
+            this->step_update(static_cast<int>(step), false);
+        return started;
+    }
 	PrintStateBase::TimeStamp set_done(PrintStepEnum step) { 
 		std::pair<PrintStateBase::TimeStamp, bool> status = m_state.set_done(step, this->state_mutex(), [this](){ this->throw_if_canceled(); });
+        this->step_update(static_cast<int>(step), true);
         if (status.second)
             this->status_update_warnings(static_cast<int>(step), PrintStateBase::WarningLevel::NON_CRITICAL, std::string());
         return status.first;
@@ -758,10 +788,15 @@ public:
 protected:
 	PrintObjectBaseWithState(PrintType *print, ModelObject *model_object) : PrintObjectBase(model_object), m_print(print) {}
 
-    bool            set_started(PrintObjectStepEnum step) 
-        { return m_state.set_started(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); }); }
+    bool            set_started(PrintObjectStepEnum step) {
+        bool started = m_state.set_started(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); });
+        if (started)
+            this->step_update(m_print, static_cast<int>(step), false);
+        return started;
+    }
 	PrintStateBase::TimeStamp set_done(PrintObjectStepEnum step) { 
 		std::pair<PrintStateBase::TimeStamp, bool> status = m_state.set_done(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); });
+        this->step_update(m_print, static_cast<int>(step), true);
         if (status.second)
             this->status_update_warnings(m_print, static_cast<int>(step), PrintStateBase::WarningLevel::NON_CRITICAL, std::string());
         return status.first;
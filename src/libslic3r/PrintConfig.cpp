@@ -4900,6 +4900,26 @@ CLIMiscConfigDef::CLIMiscConfigDef()
                      "For example. loglevel=2 logs fatal, error and warning level messages.");
     def->min = 0;
 
+    def = this->add("low_memory", coBool);
+    def->label = L("Low memory mode");
+    def->tooltip = L("Release the slices and extrusions of each layer as soon as its G-code is generated. "
+                     "The memory is then returned as the G-code export progresses. The peak memory consumption is not reduced "
+                     "much, as all layers are still in memory when the G-code export starts. "
+                     "Only applicable to FFF G-code export.");
+
+    def = this->add("slice_cache", coString);
+    def->label = L("Slice cache directory");
+    def->tooltip = L("Directory of a persistent cache of the slices of the objects. Slicing the meshes of an object into layers "
+                     "is skipped if the same object was already sliced with the same slicing parameters and the slices were stored "
+                     "in this directory. Only the slices are cached: The perimeters, infill, supports and the G-code are generated "
+                     "on every run.");
+
+    def = this->add("trace", coString);
+    def->label = L("Trace file");
+    def->tooltip = L("Record the durations of the slicing steps on all threads and write them into the specified file "
+                     "in the Chrome trace format, to be viewed by chrome://tracing or Perfetto. "
+                     "Only available if PrusaSlicer was compiled with SLIC3R_TRACE.");
+
 #if (defined(_MSC_VER) || defined(__MINGW32__)) && defined(SLIC3R_GUI)
     def = this->add("sw_renderer", coBool);
     def->label = L("Render with a software renderer");
@@ -2,6 +2,7 @@
 #include "BridgeDetector.hpp"
 #include "ExPolygon.hpp"
 #include "Exception.hpp"
+#include "ExtrusionEntityArena.hpp"
 #include "Flow.hpp"
 #include "KDTreeIndirect.hpp"
 #include "Point.hpp"
@@ -23,6 +24,7 @@
 #include "Slicing.hpp"
 #include "SurfaceCollection.hpp"
 #include "Tesselate.hpp"
+#include "Trace.hpp"
 #include "TriangleMeshSlicer.hpp"
 #include "Utils.hpp"
 #include "Fill/FillAdaptive.hpp"
@@ -165,6 +167,7 @@ void PrintObject::make_perimeters()
 
     if (! this->set_started(posPerimeters))
         return;
+    SLIC3R_TRACE_SCOPE("PrintObject::make_perimeters");
 
     m_print->set_status(20, _u8L("Generating perimeters"));
     BOOST_LOG_TRIVIAL(info) << "Generating perimeters..." << log_memory_info();
@@ -258,6 +261,8 @@ void PrintObject::make_perimeters()
             PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                 m_print->throw_if_canceled();
+                // The perimeters of a layer are placed next to each other and released together.
+                ExtrusionEntityArena arena;
                 m_layers[layer_idx]->make_perimeters();
             }
         }
@@ -272,6 +277,7 @@ void PrintObject::prepare_infill()
 {
     if (! this->set_started(posPrepareInfill))
         return;
+    SLIC3R_TRACE_SCOPE("PrintObject::prepare_infill");
 
     m_print->set_status(30, _u8L("Preparing infill"));
 
@@ -418,6 +424,7 @@ void PrintObject::infill()
     this->prepare_infill();
 
     if (this->set_started(posInfill)) {
+        SLIC3R_TRACE_SCOPE("PrintObject::infill");
         // TRN Status for the Print calculation 
         m_print->set_status(45, _u8L("Making infill"));
         const auto& adaptive_fill_octree = this->m_adaptive_fill_octrees.first;
@@ -430,6 +437,8 @@ void PrintObject::infill()
                 PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
+                    // The fills of a layer are placed next to each other and released together.
+                    ExtrusionEntityArena arena;
                     m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get(), this->m_lightning_generator.get());
                 }
             }
@@ -439,6 +448,13 @@ void PrintObject::infill()
         /*  we could free memory now, but this would make this step not idempotent
         ### $_->fill_surfaces->clear for map @{$_->regions}, @{$object->layers};
         */
+        if (m_print->low_memory_mode()) {
+            // The infill will not be regenerated, release the acceleration structures.
+            // Fill surfaces are kept, they are used by AvoidCrossingPerimeters during the G-code export.
+            m_adaptive_fill_octrees.first.reset();
+            m_adaptive_fill_octrees.second.reset();
+            m_lightning_generator.reset();
+        }
         this->set_done(posInfill);
     }
 }
@@ -446,6 +462,7 @@ void PrintObject::infill()
 void PrintObject::ironing()
 {
     if (this->set_started(posIroning)) {
+        SLIC3R_TRACE_SCOPE("PrintObject::ironing");
         BOOST_LOG_TRIVIAL(debug) << "Ironing in parallel - start";
         tbb::parallel_for(
             // Ironing starting with layer 0 to support ironing all surfaces.
@@ -467,6 +484,7 @@ void PrintObject::ironing()
 void PrintObject::generate_support_spots()
 {
     if (this->set_started(posSupportSpotsSearch)) {
+        SLIC3R_TRACE_SCOPE("PrintObject::generate_support_spots");
         BOOST_LOG_TRIVIAL(debug) << "Searching support spots - start";
         m_print->set_status(65, _u8L("Searching support spots"));
         if (!this->shared_regions()->generated_support_points.has_value()) {
@@ -491,6 +509,7 @@ void PrintObject::generate_support_spots()
 void PrintObject::generate_support_material()
 {
     if (this->set_started(posSupportMaterial)) {
+        SLIC3R_TRACE_SCOPE("PrintObject::generate_support_material");
         this->clear_support_layers();
         if ((this->has_support() && m_layers.size() > 1) || (this->has_raft() && ! m_layers.empty())) {
             m_print->set_status(70, _u8L("Generating support material"));    
@@ -512,6 +531,7 @@ void PrintObject::generate_support_material()
 void PrintObject::estimate_curled_extrusions()
 {
     if (this->set_started(posEstimateCurledExtrusions)) {
+        SLIC3R_TRACE_SCOPE("PrintObject::estimate_curled_extrusions");
         if (this->print()->config().avoid_crossing_curled_overhangs ||
             std::any_of(this->print()->m_print_regions.begin(), this->print()->m_print_regions.end(),
                         [](const PrintRegion *region) { return region->config().enable_dynamic_overhang_speeds.getBool(); })) {
@@ -902,6 +922,7 @@ void PrintObject::cleanup()
 // If a part of a region is of stBottom and stTop, the stBottom wins.
 void PrintObject::detect_surfaces_type()
 {
+    SLIC3R_TRACE_SCOPE("PrintObject::detect_surfaces_type");
     BOOST_LOG_TRIVIAL(info) << "Detecting solid surfaces..." << log_memory_info();
 
     // Interface shells: the intersecting parts are treated as self standing objects supporting each other.
@@ -1103,6 +1124,7 @@ void PrintObject::detect_surfaces_type()
 
 void PrintObject::process_external_surfaces()
 {
+    SLIC3R_TRACE_SCOPE("PrintObject::process_external_surfaces");
     BOOST_LOG_TRIVIAL(info) << "Processing external surfaces..." << log_memory_info();
 
     // Cached surfaces covered by some extrusion, defining regions, over which the from the surfaces one layer higher are allowed to expand.
@@ -1196,6 +1218,7 @@ void PrintObject::process_external_surfaces()
 
 void PrintObject::discover_vertical_shells()
 {
+    SLIC3R_TRACE_SCOPE("PrintObject::discover_vertical_shells");
     BOOST_LOG_TRIVIAL(info) << "Discovering vertical shells..." << log_memory_info();
 
     struct DiscoverVerticalShellsCacheEntry
@@ -1628,6 +1651,7 @@ template<typename T> void debug_draw(std::string name, const T& a, const T& b, c
 // This method applies bridge flow to the first internal solid layer above sparse infill.
 void PrintObject::bridge_over_infill()
 {
+    SLIC3R_TRACE_SCOPE("PrintObject::bridge_over_infill");
     BOOST_LOG_TRIVIAL(info) << "Bridge over infill - Start" << log_memory_info();
 
     struct CandidateSurface
@@ -2722,6 +2746,7 @@ bool PrintObject::update_layer_height_profile(const ModelObject &model_object, c
 
 void PrintObject::discover_horizontal_shells()
 {
+    SLIC3R_TRACE_SCOPE("PrintObject::discover_horizontal_shells");
     BOOST_LOG_TRIVIAL(trace) << "discover_horizontal_shells()";
 
     for (size_t region_id = 0; region_id < this->num_printing_regions(); ++region_id) {
@@ -2759,6 +2784,7 @@ void PrintObject::discover_horizontal_shells()
 // fill_surfaces but we only turn them into VOID surfaces, thus preserving the boundaries.
 void PrintObject::combine_infill()
 {
+    SLIC3R_TRACE_SCOPE("PrintObject::combine_infill");
     // Work on each region separately.
     for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id) {
         const PrintRegion &region = this->printing_region(region_id);
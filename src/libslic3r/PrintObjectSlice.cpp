@@ -5,6 +5,8 @@
 #include "MultiMaterialSegmentation.hpp"
 #include "Print.hpp"
 #include "ShortestPath.hpp"
+#include "SliceCache.hpp"
+#include "Trace.hpp"
 
 #include <boost/log/trivial.hpp>
 
@@ -497,6 +499,7 @@ void PrintObject::slice()
 {
     if (! this->set_started(posSlice))
         return;
+    SLIC3R_TRACE_SCOPE("PrintObject::slice");
     m_print->set_status(10, _u8L("Processing triangulated mesh"));
     std::vector<coordf_t> layer_height_profile;
     this->update_layer_height_profile(*this->model_object(), m_slicing_params, layer_height_profile);
@@ -683,6 +686,7 @@ void apply_mm_segmentation(PrintObject &print_object, ThrowOnCancel throw_on_can
 // this should be idempotent
 void PrintObject::slice_volumes()
 {
+    SLIC3R_TRACE_SCOPE("PrintObject::slice_volumes");
     BOOST_LOG_TRIVIAL(info) << "Slicing volumes..." << log_memory_info();
     const Print *print                      = this->print();
     const auto   throw_on_cancel_callback   = std::function<void()>([print](){ print->throw_if_canceled(); });
@@ -695,6 +699,46 @@ void PrintObject::slice_volumes()
             layer->m_regions.emplace_back(new LayerRegion(layer, pr.get()));
     }
 
+    // Is any ModelVolume MMU painted?
+    const bool mm_painted = [this]() {
+        const auto &volumes = this->model_object()->volumes;
+        return m_print->config().nozzle_diameter.size() > 1 &&
+            std::find_if(volumes.begin(), volumes.end(), [](const ModelVolume* v) { return !v->mmu_segmentation_facets.empty(); }) != volumes.end();
+    }();
+    // If XY Size compensation is also enabled, notify the user that XY Size compensation
+    // would not be used because the object is multi-material painted.
+    if (mm_painted && m_config.xy_size_compensation.value != 0.f) {
+        this->active_step_add_warning(
+            PrintStateBase::WarningLevel::CRITICAL,
+            _u8L("An object has enabled XY Size compensation which will not be used because it is also multi-material painted.\nXY Size "
+              "compensation cannot be combined with multi-material painting.") +
+                "\n" + (_u8L("Object name")) + ": " + this->model_object()->name);
+    }
+
+    // Reuse the slices from the persistent slice cache if enabled.
+    std::string slice_cache_key;
+    if (const std::string &slice_cache_dir = print->slice_cache_dir(); ! slice_cache_dir.empty()) {
+        slice_cache_key = SliceCache::key(*this);
+        if (std::optional<SliceCache::SlicedLayers> cached = SliceCache::load(slice_cache_dir, slice_cache_key, m_layers.size(), m_shared_regions->all_regions.size());
+            cached) {
+            // Remove the top empty layers, which were not cached.
+            for (size_t i = cached->size(); i < m_layers.size(); ++ i)
+                delete m_layers[i];
+            m_layers.erase(m_layers.begin() + cached->size(), m_layers.end());
+            if (! m_layers.empty())
+                m_layers.back()->upper_layer = nullptr;
+            for (size_t layer_id = 0; layer_id < m_layers.size(); ++ layer_id) {
+                Layer                    &layer  = *m_layers[layer_id];
+                SliceCache::SlicedLayer  &sliced = (*cached)[layer_id];
+                for (size_t region_id = 0; region_id < layer.m_regions.size(); ++ region_id)
+                    layer.m_regions[region_id]->m_slices.set(std::move(sliced.region_slices[region_id]), stInternal);
+                layer.lslices                              = std::move(sliced.lslices);
+                layer.lslice_indices_sorted_by_print_order = std::move(sliced.lslice_indices_sorted_by_print_order);
+            }
+            return;
+        }
+    }
+
     std::vector<float>                   slice_zs      = zs_from_layers(m_layers);
     std::vector<std::vector<ExPolygons>> region_slices = slices_to_regions(this->model_object()->volumes, *m_shared_regions, slice_zs,
         slice_volumes_inner(
@@ -721,21 +765,7 @@ void PrintObject::slice_volumes()
         m_layers.back()->upper_layer = nullptr;
     m_print->throw_if_canceled();
 
-    // Is any ModelVolume MMU painted?
-    if (const auto& volumes = this->model_object()->volumes;
-        m_print->config().nozzle_diameter.size() > 1 &&
-        std::find_if(volumes.begin(), volumes.end(), [](const ModelVolume* v) { return !v->mmu_segmentation_facets.empty(); }) != volumes.end()) {
-
-        // If XY Size compensation is also enabled, notify the user that XY Size compensation
-        // would not be used because the object is multi-material painted.
-        if (m_config.xy_size_compensation.value != 0.f) {
-            this->active_step_add_warning(
-                PrintStateBase::WarningLevel::CRITICAL,
-                _u8L("An object has enabled XY Size compensation which will not be used because it is also multi-material painted.\nXY Size "
-                  "compensation cannot be combined with multi-material painting.") +
-                    "\n" + (_u8L("Object name")) + ": " + this->model_object()->name);
-        }
-
+    if (mm_painted) {
         BOOST_LOG_TRIVIAL(debug) << "Slicing volumes - MMU segmentation";
         apply_mm_segmentation(*this, [print]() { print->throw_if_canceled(); });
     }
@@ -820,6 +850,9 @@ void PrintObject::slice_volumes()
 
     m_print->throw_if_canceled();
     BOOST_LOG_TRIVIAL(debug) << "Slicing volumes - make_slices in parallel - end";
+
+    if (! slice_cache_key.empty())
+        SliceCache::store(print->slice_cache_dir(), slice_cache_key, *this);
 }
 
 std::vector<Polygons> PrintObject::slice_support_volumes(const ModelVolumeType model_volume_type) const
@@ -16,6 +16,8 @@
 #include <agg/agg_rasterizer_scanline_aa.h>
 #include <agg/agg_path_storage.h>
 
+#include <cstring>
+
 namespace Slic3r {
 
 inline const Polygon& contour(const ExPolygon& p) { return p.contour; }
@@ -220,6 +222,107 @@ public:
     {}
 };
 
+// Scanline to be swept by a rasterizer with a thresholding gamma, thus with the pixels
+// either fully covered or not covered at all. Only the spans of the covered pixels are
+// stored, without their coverage. Adjacent cells and spans are merged.
+class ScanlineBin {
+public:
+    struct span {
+        int x;
+        int len;
+    };
+    using const_iterator = const span*;
+
+    void reset(int /* min_x */, int /* max_x */) { m_spans.clear(); }
+    void reset_spans() { m_spans.clear(); }
+    void add_cell(int x, unsigned /* cover */) { this->add_span(x, 1, 0); }
+    void add_cells(int x, unsigned len, const agg::int8u* /* covers */) { this->add_span(x, len, 0); }
+    void add_span(int x, unsigned len, unsigned /* cover */)
+    {
+        if (! m_spans.empty() && m_spans.back().x + m_spans.back().len == x)
+            m_spans.back().len += int(len);
+        else
+            m_spans.push_back({ x, int(len) });
+    }
+    void finalize(int y) { m_y = y; }
+
+    int            y() const { return m_y; }
+    unsigned       num_spans() const { return unsigned(m_spans.size()); }
+    const_iterator begin() const { return m_spans.data(); }
+
+private:
+    std::vector<span> m_spans;
+    int               m_y { 0 };
+};
+
+// Fills the spans of ScanlineBin with a solid color, for one byte per pixel formats.
+template<class BaseRenderer> class RendererScanlineBinSolid {
+public:
+    using base_ren_type = BaseRenderer;
+    using color_type    = typename BaseRenderer::color_type;
+
+    explicit RendererScanlineBinSolid(base_ren_type &ren) : m_ren(&ren) {}
+
+    void              color(const color_type &c) { m_color = c; }
+    const color_type& color() const { return m_color; }
+    void              prepare() {}
+
+    template<class Scanline> void render(const Scanline &sl)
+    {
+        static_assert(base_ren_type::pixfmt_type::pix_width == 1, "One byte per pixel expected");
+        const int y = sl.y();
+        if (y < m_ren->ymin() || y > m_ren->ymax())
+            return;
+        typename Scanline::const_iterator span = sl.begin();
+        for (unsigned i = sl.num_spans(); i > 0; -- i, ++ span) {
+            const int x1 = std::max(span->x, m_ren->xmin());
+            const int x2 = std::min(span->x + span->len - 1, m_ren->xmax());
+            if (x1 <= x2)
+                std::memset(m_ren->ren().pix_ptr(x1, y), m_color.v, size_t(x2 - x1 + 1));
+        }
+    }
+
+private:
+    base_ren_type *m_ren;
+    color_type     m_color;
+};
+
+/*
+ * Monochrome canvas without anti-aliasing. A pixel is white if at least half
+ * of it is covered, exactly as RasterGrayscaleAA with agg::gamma_threshold(.5)
+ * would rasterize it, but the covered spans are filled without blending.
+ */
+using _RasterGrayscaleBinary =
+    AGGRaster<agg::pixfmt_gray8, RendererScanlineBinSolid, agg::rasterizer_scanline_aa<>, ScanlineBin>;
+
+class RasterGrayscaleBinary : public _RasterGrayscaleBinary {
+    using Base = _RasterGrayscaleBinary;
+    using typename Base::TColor;
+    using typename Base::TValue;
+public:
+    RasterGrayscaleBinary(const Resolution        &res,
+                          const PixelDim          &pd,
+                          const RasterBase::Trafo &trafo)
+        : Base(res,
+               pd,
+               trafo,
+               Colors<TColor>::White,
+               Colors<TColor>::Black,
+               agg::gamma_threshold(.5))
+    {}
+
+    uint8_t read_pixel(size_t col, size_t row) const
+    {
+        static_assert(std::is_same<TValue, uint8_t>::value, "Not grayscale pix");
+
+        uint8_t px;
+        Base::m_buf[row * Base::resolution().width_px + col].get(px);
+        return px;
+    }
+
+    void clear() { Base::clear(Colors<TColor>::Black); }
+};
+
 }} // namespace Slic3r::sla
 
 #endif // AGGRASTER_HPP
@@ -17,8 +17,8 @@ EncodedRaster PNGRasterEncoder::operator()(const void *ptr, size_t w, size_t h,
     std::vector<uint8_t> buf;
     size_t s = 0;
     
-    void *rawdata = tdefl_write_image_to_png_file_in_memory(
-        ptr, int(w), int(h), int(num_components), &s);
+    void *rawdata = tdefl_write_image_to_png_file_in_memory_ex(
+        ptr, int(w), int(h), int(num_components), &s, compression_level, MZ_FALSE);
     
     // On error, data() will return an empty vector. No other info can be
     // retrieved from miniz anyway...
@@ -75,7 +75,7 @@ std::unique_ptr<RasterBase> create_raster_grayscale_aa(
     else if (std::abs(gamma - 1.) < 1e-6)
         rst = std::make_unique<RasterGrayscaleAA>(res, pxdim, tr, agg::gamma_none());
     else
-        rst = std::make_unique<RasterGrayscaleAA>(res, pxdim, tr, agg::gamma_threshold(.5));
+        rst = std::make_unique<RasterGrayscaleBinary>(res, pxdim, tr);
     
     return rst;
 }
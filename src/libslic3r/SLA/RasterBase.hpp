@@ -97,6 +97,10 @@ public:
 };
 
 struct PNGRasterEncoder {
+    // Deflate level of the zlib convention, 6 is the default of miniz. The fastest level 1
+    // encodes the layers in about 60% of the time, producing somewhat larger images.
+    int compression_level = 6;
+
     EncodedRaster operator()(const void *ptr, size_t w, size_t h, size_t num_components);
 };
 
@@ -24,6 +24,7 @@
 #include <libslic3r/QuadricEdgeCollapse.hpp>
 
 #include <libslic3r/ClipperUtils.hpp>
+#include <libslic3r/Trace.hpp>
 //#include <libslic3r/ShortEdgeCollapse.hpp>
 
 #include <boost/log/trivial.hpp>
@@ -1201,6 +1202,14 @@ double SLAPrint::Steps::progressrange(SLAPrintStep step) const
 
 void SLAPrint::Steps::execute(SLAPrintObjectStep step, SLAPrintObject &obj)
 {
+    // Untranslated step names for the trace.
+    static constexpr const char *trace_names[] = {
+        "SLAPrint::mesh_assembly", "SLAPrint::hollow_model", "SLAPrint::drill_holes", "SLAPrint::slice_model",
+        "SLAPrint::support_points", "SLAPrint::support_tree", "SLAPrint::generate_pad", "SLAPrint::slice_supports"
+    };
+    static_assert(std::size(trace_names) == slaposCount, "Missing trace name of an SLAPrintObjectStep");
+    SLIC3R_TRACE_SCOPE(step < slaposCount ? trace_names[step] : "SLAPrint::execute");
+
     switch(step) {
     case slaposAssembly: mesh_assembly(obj); break;
     case slaposHollowing: hollow_model(obj); break;
@@ -1216,6 +1225,10 @@ void SLAPrint::Steps::execute(SLAPrintObjectStep step, SLAPrintObject &obj)
 
 void SLAPrint::Steps::execute(SLAPrintStep step)
 {
+    static constexpr const char *trace_names[] = { "SLAPrint::merge_slices_and_eval_stats", "SLAPrint::rasterize" };
+    static_assert(std::size(trace_names) == slapsCount, "Missing trace name of an SLAPrintStep");
+    SLIC3R_TRACE_SCOPE(step < slapsCount ? trace_names[step] : "SLAPrint::execute");
+
     switch (step) {
     case slapsMergeSlicesAndEval: merge_slices_and_eval_stats(); break;
     case slapsRasterize: rasterize(); break;
@@ -0,0 +1,296 @@
+#include "SliceCache.hpp"
+#include "Exception.hpp"
+#include "Layer.hpp"
+#include "Model.hpp"
+#include "Print.hpp"
+#include "Utils.hpp"
+
+#include "libslic3r_version.h"
+
+#include <cstring>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+//FIXME replace the following include with <boost/md5.hpp> after it becomes mainstream, see AppConfig.cpp
+#include <boost/uuid/detail/md5.hpp>
+
+namespace Slic3r {
+namespace SliceCache {
+
+// To be incremented with any change of the file format or of the algorithms of PrintObject::slice_volumes().
+static constexpr const uint32_t cache_version  = 1;
+static constexpr const char     cache_magic[4] = { 'P', 'S', 'L', 'C' };
+
+// Configuration values influencing PrintObject::slice_volumes(), see PrintObject::invalidate_state_by_config_options()
+// for the keys invalidating posSlice. The Z coordinates of the layers are hashed directly, thus the keys
+// influencing just the layer heights (layer_height, first_layer_height, raft_contact_distance...) are not listed here.
+static const t_config_option_keys s_print_keys  { "nozzle_diameter", "resolution", "spiral_vase" };
+static const t_config_option_keys s_object_keys { "elefant_foot_compensation", "extrusion_width", "first_layer_extrusion_width",
+                                                  "mmu_segmented_region_max_width", "raft_layers", "slice_closing_radius", "slicing_mode",
+                                                  "xy_size_compensation" };
+// Region keys used by the spiral vase slicing mode, by Layer::merged(), by the Elephant foot compensation
+// (external perimeter flow) and by the multi-material segmentation.
+static const t_config_option_keys s_region_keys { "bottom_solid_layers", "bottom_solid_min_thickness", "external_perimeter_extrusion_width",
+                                                  "fill_density", "gap_fill_enabled", "gap_fill_speed", "perimeter_extruder",
+                                                  "perimeter_extrusion_width", "perimeters", "top_solid_layers" };
+
+namespace {
+
+class KeyHasher
+{
+public:
+    void bytes(const void *data, size_t size) { m_md5.process_bytes(data, size); }
+    template<typename T> void pod(const T &value) { static_assert(std::is_trivially_copyable_v<T>); this->bytes(&value, sizeof(T)); }
+    template<typename T> void pods(const std::vector<T> &values) { this->pod(uint64_t(values.size())); if (! values.empty()) this->bytes(values.data(), values.size() * sizeof(T)); }
+    void string(const std::string &s) { this->pod(uint64_t(s.size())); this->bytes(s.data(), s.size()); }
+    void transform(const Transform3d &trafo) { this->bytes(trafo.matrix().data(), 16 * sizeof(double)); }
+    void config(const ConfigBase &config, const t_config_option_keys &keys) {
+        for (const t_config_option_key &key : keys) {
+            this->string(key);
+            this->string(config.option(key) != nullptr ? config.opt_serialize(key) : std::string());
+        }
+    }
+
+    std::string digest() {
+        boost::uuids::detail::md5::digest_type digest{};
+        m_md5.get_digest(digest);
+        std::string out;
+        boost::algorithm::hex(digest, digest + std::size(digest), std::back_inserter(out));
+        return out;
+    }
+
+private:
+    boost::uuids::detail::md5 m_md5;
+};
+
+class Writer
+{
+public:
+    template<typename T> void pod(const T &value) { static_assert(std::is_trivially_copyable_v<T>); m_data.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    void points(const Points &pts) { this->pod(uint64_t(pts.size())); m_data.append(reinterpret_cast<const char*>(pts.data()), pts.size() * sizeof(Point)); }
+    template<typename ExPolygonsOrSurfaces, typename GetExPolygon>
+    void expolygons(const ExPolygonsOrSurfaces &expolys, GetExPolygon get_expolygon) {
+        this->pod(uint64_t(expolys.size()));
+        for (const auto &item : expolys) {
+            const ExPolygon &expoly = get_expolygon(item);
+            this->points(expoly.contour.points);
+            this->pod(uint64_t(expoly.holes.size()));
+            for (const Polygon &hole : expoly.holes)
+                this->points(hole.points);
+        }
+    }
+    const std::string& data() const { return m_data; }
+
+private:
+    std::string m_data;
+};
+
+class Reader
+{
+public:
+    Reader(const std::string &data) : m_begin(data.data()), m_end(data.data() + data.size()) {}
+    template<typename T> bool pod(T &value) {
+        if (m_end - m_begin < ptrdiff_t(sizeof(T)))
+            return false;
+        memcpy(&value, m_begin, sizeof(T));
+        m_begin += sizeof(T);
+        return true;
+    }
+    bool points(Points &pts) {
+        uint64_t n;
+        if (! this->pod(n) || uint64_t(m_end - m_begin) / sizeof(Point) < n)
+            return false;
+        pts.resize(n);
+        memcpy(pts.data(), m_begin, n * sizeof(Point));
+        m_begin += n * sizeof(Point);
+        return true;
+    }
+    bool expolygons(ExPolygons &expolys) {
+        uint64_t n;
+        if (! this->pod(n) || uint64_t(m_end - m_begin) < n)
+            return false;
+        expolys.assign(n, ExPolygon());
+        for (ExPolygon &expoly : expolys) {
+            uint64_t num_holes;
+            if (! this->points(expoly.contour.points) || ! this->pod(num_holes) || uint64_t(m_end - m_begin) < num_holes)
+                return false;
+            expoly.holes.assign(num_holes, Polygon());
+            for (Polygon &hole : expoly.holes)
+                if (! this->points(hole.points))
+                    return false;
+        }
+        return true;
+    }
+    bool at_end() const { return m_begin == m_end; }
+
+private:
+    const char *m_begin;
+    const char *m_end;
+};
+
+boost::filesystem::path entry_path(const std::string &cache_dir, const std::string &key)
+{
+    return boost::filesystem::path(cache_dir) / (key + ".slices");
+}
+
+} // anonymous namespace
+
+std::string key(const PrintObject &print_object)
+{
+    KeyHasher hasher;
+    hasher.string(SLIC3R_BUILD_ID);
+    hasher.pod(cache_version);
+
+    hasher.config(print_object.print()->config(), s_print_keys);
+    hasher.config(print_object.config(), s_object_keys);
+    hasher.transform(print_object.trafo_centered());
+
+    // Z coordinates of the layers, they capture the layer height profile, raft, first layer height etc.
+    for (const Layer *layer : print_object.layers()) {
+        hasher.pod(layer->slice_z);
+        hasher.pod(layer->print_z);
+        hasher.pod(layer->height);
+    }
+
+    // Geometry of the model volumes.
+    const ModelObject &model_object = *print_object.model_object();
+    for (const ModelVolume *model_volume : model_object.volumes) {
+        hasher.pod(model_volume->type());
+        hasher.transform(model_volume->get_matrix());
+        const indexed_triangle_set &its = model_volume->mesh().its;
+        hasher.pods(its.vertices);
+        hasher.pods(its.indices);
+        const auto &[mmu_triangles, mmu_bitstream] = model_volume->mmu_segmentation_facets.get_data();
+        hasher.pods(mmu_triangles);
+        hasher.pod(uint64_t(mmu_bitstream.size()));
+        for (bool bit : mmu_bitstream)
+            hasher.pod(bit);
+    }
+
+    // Assignment of the model volumes to the regions in all layer ranges, and the region configs.
+    const PrintObjectRegions &regions = *print_object.shared_regions();
+    for (const std::unique_ptr<PrintRegion> &region : regions.all_regions)
+        hasher.config(region->config(), s_region_keys);
+    auto volume_idx = [&model_object](const ModelVolume *model_volume) {
+        return uint64_t(std::find(model_object.volumes.begin(), model_object.volumes.end(), model_volume) - model_object.volumes.begin());
+    };
+    for (const PrintObjectRegions::LayerRangeRegions &range : regions.layer_ranges) {
+        hasher.pod(range.layer_height_range.first);
+        hasher.pod(range.layer_height_range.second);
+        for (const PrintObjectRegions::VolumeRegion &volume_region : range.volume_regions) {
+            hasher.pod(volume_idx(volume_region.model_volume));
+            hasher.pod(volume_region.parent);
+            hasher.pod(volume_region.region ? volume_region.region->print_object_region_id() : -1);
+        }
+        for (const PrintObjectRegions::PaintedRegion &painted_region : range.painted_regions) {
+            hasher.pod(painted_region.extruder_id);
+            hasher.pod(painted_region.parent);
+            hasher.pod(painted_region.region->print_object_region_id());
+        }
+    }
+
+    return hasher.digest();
+}
+
+std::optional<SlicedLayers> load(const std::string &cache_dir, const std::string &key, size_t max_layers, size_t num_regions)
+{
+    const boost::filesystem::path path = entry_path(cache_dir, key);
+    std::string data;
+    {
+        boost::nowide::ifstream file(path.string(), std::ios::binary);
+        if (! file.good())
+            return {};
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    Reader   reader(data);
+    char     magic[4];
+    uint32_t version;
+    uint64_t num_layers;
+    bool     valid = reader.pod(magic) && memcmp(magic, cache_magic, 4) == 0 && reader.pod(version) && version == cache_version &&
+                     reader.pod(num_layers) && num_layers <= max_layers;
+    SlicedLayers out;
+    if (valid) {
+        out.assign(num_layers, SlicedLayer());
+        for (SlicedLayer &layer : out) {
+            uint64_t num_region_slices;
+            if (! reader.pod(num_region_slices) || num_region_slices != num_regions) {
+                valid = false;
+                break;
+            }
+            layer.region_slices.assign(num_regions, ExPolygons());
+            for (ExPolygons &slices : layer.region_slices)
+                if (! (valid = reader.expolygons(slices)))
+                    break;
+            uint64_t num_indices;
+            if (! valid || ! reader.expolygons(layer.lslices) || ! reader.pod(num_indices) || num_indices != layer.lslices.size()) {
+                valid = false;
+                break;
+            }
+            layer.lslice_indices_sorted_by_print_order.assign(num_indices, 0);
+            for (size_t &idx : layer.lslice_indices_sorted_by_print_order) {
+                uint64_t v;
+                if (! reader.pod(v) || v >= num_indices) {
+                    valid = false;
+                    break;
+                }
+                idx = size_t(v);
+            }
+            if (! valid)
+                break;
+        }
+        valid = valid && reader.at_end();
+    }
+    if (! valid) {
+        BOOST_LOG_TRIVIAL(warning) << "Slice cache: Ignoring invalid cache entry " << path.string();
+        return {};
+    }
+    BOOST_LOG_TRIVIAL(info) << "Slice cache: Loaded " << num_layers << " layers from " << path.string();
+    return std::make_optional(std::move(out));
+}
+
+void store(const std::string &cache_dir, const std::string &key, const PrintObject &print_object)
+{
+    Writer writer;
+    writer.pod(cache_magic);
+    writer.pod(cache_version);
+    writer.pod(uint64_t(print_object.layer_count()));
+    for (const Layer *layer : print_object.layers()) {
+        writer.pod(uint64_t(layer->region_count()));
+        for (const LayerRegion *layerm : layer->regions()) {
+            assert(std::all_of(layerm->slices().surfaces.begin(), layerm->slices().surfaces.end(), [](const Surface &s) { return s.surface_type == stInternal; }));
+            writer.expolygons(layerm->slices().surfaces, [](const Surface &surface) -> const ExPolygon& { return surface.expolygon; });
+        }
+        writer.expolygons(layer->lslices, [](const ExPolygon &expoly) -> const ExPolygon& { return expoly; });
+        writer.pod(uint64_t(layer->lslice_indices_sorted_by_print_order.size()));
+        for (size_t idx : layer->lslice_indices_sorted_by_print_order)
+            writer.pod(uint64_t(idx));
+    }
+
+    // Write into a temporary file first and rename it, so that concurrent slicer instances sharing the same cache directory
+    // never read a partially written cache entry.
+    const boost::filesystem::path path = entry_path(cache_dir, key);
+    const boost::filesystem::path path_tmp = path.parent_path() / boost::filesystem::unique_path(key + ".%%%%-%%%%.tmp");
+    try {
+        boost::filesystem::create_directories(path.parent_path());
+        {
+            boost::nowide::ofstream file(path_tmp.string(), std::ios::binary);
+            file.write(writer.data().data(), writer.data().size());
+            if (! file.good())
+                throw Slic3r::RuntimeError("Write error");
+        }
+        if (std::error_code ec = rename_file(path_tmp.string(), path.string()); ec)
+            throw Slic3r::RuntimeError(ec.message());
+        BOOST_LOG_TRIVIAL(info) << "Slice cache: Stored " << print_object.layer_count() << " layers into " << path.string();
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(warning) << "Slice cache: Failed to store " << path.string() << ": " << ex.what();
+        boost::system::error_code ec;
+        boost::filesystem::remove(path_tmp, ec);
+    }
+}
+
+} // namespace SliceCache
+} // namespace Slic3r
@@ -0,0 +1,50 @@
+#ifndef slic3r_SliceCache_hpp_
+#define slic3r_SliceCache_hpp_
+
+#include "libslic3r.h"
+#include "ExPolygon.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+class PrintObject;
+
+// Persistent on-disk cache of the results of PrintObject::slice_volumes(), to be used by the command line slicer
+// when slicing the same models with the same profiles repeatedly. Only posSlice is cached, the perimeters, infill,
+// supports and G-code are always generated from the cached slices.
+// The cache is content addressed: Each cache entry is a single file named by a MD5 digest of all the inputs
+// of slicing: Meshes, transformations and MMU painting of the model volumes, the assignment of volumes to regions,
+// the Z coordinates of the layers and the configuration values, which invalidate posSlice
+// (see PrintObject::invalidate_state_by_config_options()).
+// The cache is a best effort one: A missing, corrupted or unwritable cache entry is logged and slicing continues as if
+// the cache was disabled.
+namespace SliceCache {
+
+// Sliced layer as produced by PrintObject::slice_volumes().
+struct SlicedLayer
+{
+    // Slices of PrintObject::all_regions(), all of stInternal type.
+    std::vector<ExPolygons> region_slices;
+    ExPolygons              lslices;
+    std::vector<size_t>     lslice_indices_sorted_by_print_order;
+};
+using SlicedLayers = std::vector<SlicedLayer>;
+
+// MD5 digest of the inputs of PrintObject::slice_volumes() as 32 hex digits.
+// To be called after the layers are allocated, as the Z coordinates of the layers are part of the key.
+std::string             key(const PrintObject &print_object);
+
+// Load a cache entry. Returns std::nullopt if the entry does not exist, if it is not valid or if it does not match
+// the number of layers (there may be less cached layers, as the empty top layers are removed) or regions.
+std::optional<SlicedLayers> load(const std::string &cache_dir, const std::string &key, size_t max_layers, size_t num_regions);
+
+// Store the sliced layers of print_object into a cache entry.
+void                    store(const std::string &cache_dir, const std::string &key, const PrintObject &print_object);
+
+} // namespace SliceCache
+} // namespace Slic3r
+
+#endif // slic3r_SliceCache_hpp_
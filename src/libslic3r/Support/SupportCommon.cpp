@@ -319,36 +319,6 @@ SupportGeneratorLayersPtr generate_raft_base(
     const SupportGeneratorLayersPtr   &base_layers,
     SupportGeneratorLayerStorage      &layer_storage)
 {
-    // If there is brim to be generated, calculate the trimming regions.
-    Polygons brim;
-    if (object.has_brim()) {
-        // The object does not have a raft.
-        // Calculate the area covered by the brim.
-        const BrimType brim_type       = object.config().brim_type;
-        const bool     brim_outer      = brim_type == btOuterOnly || brim_type == btOuterAndInner;
-        const bool     brim_inner      = brim_type == btInnerOnly || brim_type == btOuterAndInner;
-        const auto     brim_separation = scaled<float>(object.config().brim_separation.value + object.config().brim_width.value);
-        for (const ExPolygon &ex : object.layers().front()->lslices) {
-            if (brim_outer && brim_inner)
-                polygons_append(brim, offset(ex, brim_separation));
-            else {
-                if (brim_outer)
-                    polygons_append(brim, offset(ex.contour, brim_separation, ClipperLib::jtRound, float(scale_(0.1))));
-                else
-                    brim.emplace_back(ex.contour);
-                if (brim_inner) {
-                    Polygons holes = ex.holes;
-                    polygons_reverse(holes);
-                    holes = shrink(holes, brim_separation, ClipperLib::jtRound, float(scale_(0.1)));
-                    polygons_reverse(holes);
-                    polygons_append(brim, std::move(holes));
-                } else
-                    polygons_append(brim, ex.holes);
-            }
-        }
-        brim = union_(brim);
-    }
-
     // How much to inflate the support columns to be stable. This also applies to the 1st layer, if no raft layers are to be printed.
     const float inflate_factor_fine      = float(scale_((slicing_params.raft_layers() > 1) ? 0.5 : EPSILON));
     const float inflate_factor_1st_layer = std::max(0.f, float(scale_(object.config().raft_first_layer_expansion)) - inflate_factor_fine);
@@ -369,13 +339,51 @@ SupportGeneratorLayersPtr generate_raft_base(
         // This is not the raft interface layer.
         columns_base = nullptr;
 
+    // The brim trimming regions and the inflated interfaces are independent operations over the whole first layer,
+    // executed as a batch. This function runs once per object, not inside a parallel loop over layers.
+    ClipperUtils::Batch batch;
+    // If there is brim to be generated, calculate the trimming regions.
+    auto brim_result = batch.queue([&object]() {
+        Polygons brim;
+        if (object.has_brim()) {
+            // The object does not have a raft.
+            // Calculate the area covered by the brim.
+            const BrimType brim_type       = object.config().brim_type;
+            const bool     brim_outer      = brim_type == btOuterOnly || brim_type == btOuterAndInner;
+            const bool     brim_inner      = brim_type == btInnerOnly || brim_type == btOuterAndInner;
+            const auto     brim_separation = scaled<float>(object.config().brim_separation.value + object.config().brim_width.value);
+            for (const ExPolygon &ex : object.layers().front()->lslices) {
+                if (brim_outer && brim_inner)
+                    polygons_append(brim, offset(ex, brim_separation));
+                else {
+                    if (brim_outer)
+                        polygons_append(brim, offset(ex.contour, brim_separation, ClipperLib::jtRound, float(scale_(0.1))));
+                    else
+                        brim.emplace_back(ex.contour);
+                    if (brim_inner) {
+                        Polygons holes = ex.holes;
+                        polygons_reverse(holes);
+                        holes = shrink(holes, brim_separation, ClipperLib::jtRound, float(scale_(0.1)));
+                        polygons_reverse(holes);
+                        polygons_append(brim, std::move(holes));
+                    } else
+                        polygons_append(brim, ex.holes);
+                }
+            }
+            brim = union_(brim);
+        }
+        return brim;
+    });
+    std::vector<ClipperUtils::Batch::Result<Polygons>> interface_results;
+    for (const SupportGeneratorLayer *layer : { contacts, interfaces, base_interfaces })
+        if (layer != nullptr && ! layer->polygons.empty())
+            interface_results.emplace_back(batch.queue([layer, inflate_factor_fine]() { return expand(layer->polygons, inflate_factor_fine, SUPPORT_SURFACES_OFFSET_PARAMETERS); }));
+    batch.execute();
+
+    Polygons brim = batch.take(brim_result);
     Polygons interface_polygons;
-    if (contacts != nullptr && ! contacts->polygons.empty())
-        polygons_append(interface_polygons, expand(contacts->polygons, inflate_factor_fine, SUPPORT_SURFACES_OFFSET_PARAMETERS));
-    if (interfaces != nullptr && ! interfaces->polygons.empty())
-        polygons_append(interface_polygons, expand(interfaces->polygons, inflate_factor_fine, SUPPORT_SURFACES_OFFSET_PARAMETERS));
-    if (base_interfaces != nullptr && ! base_interfaces->polygons.empty())
-        polygons_append(interface_polygons, expand(base_interfaces->polygons, inflate_factor_fine, SUPPORT_SURFACES_OFFSET_PARAMETERS));
+    for (const ClipperUtils::Batch::Result<Polygons> &result : interface_results)
+        polygons_append(interface_polygons, batch.take(result));
  
     // Output vector.
     SupportGeneratorLayersPtr raft_layers;
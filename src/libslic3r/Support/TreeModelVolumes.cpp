@@ -10,6 +10,7 @@
 #include "TreeSupportCommon.hpp"
 
 #include "../BuildVolume.hpp"
+#include "../Exception.hpp"
 #include "../ClipperUtils.hpp"
 #include "../Flow.hpp"
 #include "../Layer.hpp"
@@ -339,7 +340,7 @@ const Polygons& TreeModelVolumes::getAvoidance(const coord_t orig_radius, LayerI
         result)
         return (*result).get();
 
-    if (m_precalculated) {
+    if (m_precalculated && layer_idx <= m_released_above) {
         if (to_model) {
             BOOST_LOG_TRIVIAL(error_level_not_in_cache) << "Had to calculate Avoidance to model at radius " << radius << " and layer " << layer_idx << ", but precalculate was called. Performance may suffer!";
             tree_supports_show_error("Not precalculated Avoidance(to model) requested."sv, false);
@@ -385,7 +386,7 @@ const Polygons& TreeModelVolumes::getWallRestriction(const coord_t orig_radius,
         (min_xy_dist ? m_wall_restrictions_cache_min : m_wall_restrictions_cache).getArea({ radius, layer_idx });
         result)
         return (*result).get();
-    if (m_precalculated) {
+    if (m_precalculated && layer_idx <= m_released_above) {
         BOOST_LOG_TRIVIAL(error_level_not_in_cache) << "Had to calculate Wall restricions at radius " << radius << " and layer " << layer_idx << ", but precalculate was called. Performance may suffer!";
         tree_supports_show_error(
             min_xy_dist ? 
@@ -397,6 +398,28 @@ const Polygons& TreeModelVolumes::getWallRestriction(const coord_t orig_radius,
     return getWallRestriction(orig_radius, layer_idx, min_xy_dist); // Retrieve failed and correct result was calculated. Now it has to be retrieved.
 }
 
+size_t TreeModelVolumes::releasable_memory() const
+{
+    size_t out = m_wall_restrictions_cache.memory_used() + m_wall_restrictions_cache_min.memory_used();
+    for (bool to_model : { false, true })
+        for (AvoidanceType type : { AvoidanceType::Slow, AvoidanceType::FastSafe, AvoidanceType::Fast })
+            out += this->avoidance_cache(type, to_model).memory_used();
+    return out;
+}
+
+size_t TreeModelVolumes::release_above(LayerIndex layer_idx)
+{
+    if (this->releasable_memory() <= m_cache_memory_limit)
+        return 0;
+    size_t released = m_wall_restrictions_cache.release_above(layer_idx) + m_wall_restrictions_cache_min.release_above(layer_idx);
+    for (bool to_model : { false, true })
+        for (AvoidanceType type : { AvoidanceType::Slow, AvoidanceType::FastSafe, AvoidanceType::Fast })
+            released += this->avoidance_cache(type, to_model).release_above(layer_idx);
+    m_released_above = std::min(m_released_above, layer_idx);
+    BOOST_LOG_TRIVIAL(debug) << "Tree support: released " << released << " bytes of avoidances and wall restrictions above layer " << layer_idx;
+    return released;
+}
+
 void TreeModelVolumes::calculateCollision(const std::vector<RadiusLayerPair> &keys, std::function<void()> throw_on_cancel)
 {
     tbb::parallel_for(tbb::blocked_range<size_t>(0, keys.size()),
@@ -849,24 +872,102 @@ coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
     return out;
 }
 
-void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layers)
+TreeModelVolumes::RadiusLayerPolygonCache& TreeModelVolumes::RadiusLayerPolygonCache::operator=(RadiusLayerPolygonCache &&rhs)
 {
-    if (num_layers > m_data.size()) {
-        if (num_layers > m_data.capacity())
-            reserve_power_of_2(m_data, num_layers);
-        m_data.resize(num_layers, {});
+    if (this != &rhs) {
+        this->clear();
+        m_directories = std::move(rhs.m_directories);
+        rhs.m_directories.clear();
+        m_directory.store(rhs.m_directory.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+        m_num_layers.store(rhs.m_num_layers.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        m_memory_used.store(rhs.m_memory_used.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
     }
+    return *this;
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear()
+{
+    if (Directory *directory = m_directory.exchange(nullptr, std::memory_order_relaxed); directory != nullptr)
+        for (size_t i = 0; i < directory->size; ++ i)
+            delete directory->blocks[i].load(std::memory_order_relaxed);
+    m_directories.clear();
+    m_num_layers.store(0, std::memory_order_relaxed);
+    m_memory_used.store(0, std::memory_order_relaxed);
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear_all_but_radius0()
+{
+    if (Directory *directory = m_directory.load(std::memory_order_relaxed); directory != nullptr)
+        for (size_t i = 0; i < directory->size; ++ i)
+            if (Block *b = directory->blocks[i].load(std::memory_order_relaxed); b != nullptr)
+                for (LayerData &l : *b) {
+                    auto begin = l.polygons.begin();
+                    auto end   = l.polygons.end();
+                    if (begin != end && ++ begin != end) {
+                        for (auto it = begin; it != end; ++ it)
+                            m_memory_used.fetch_sub(polygons_memory_used(it->second), std::memory_order_relaxed);
+                        l.polygons.erase(begin, end);
+                    }
+                }
+}
+
+size_t TreeModelVolumes::RadiusLayerPolygonCache::release_above(LayerIndex layer_idx)
+{
+    // The layers are only emptied, the blocks are kept, thus layer_data() keeps returning the same LayerData.
+    size_t released = 0;
+    for (LayerIndex i = std::max(0, layer_idx + 1); i < LayerIndex(m_num_layers.load(std::memory_order_relaxed)); ++ i)
+        if (LayerData *layer = const_cast<LayerData*>(this->layer_data(i)); layer != nullptr) {
+            for (const auto &radius_polygons : layer->polygons)
+                released += polygons_memory_used(radius_polygons.second);
+            layer->polygons.clear();
+        }
+    m_memory_used.fetch_sub(released, std::memory_order_relaxed);
+    return released;
+}
+
+TreeModelVolumes::RadiusLayerPolygonCache::LayerData& TreeModelVolumes::RadiusLayerPolygonCache::get_allocate_layer_data(LayerIndex layer_idx)
+{
+    assert(layer_idx >= 0);
+    LayerData *layer = const_cast<LayerData*>(this->layer_data(layer_idx));
+    if (layer == nullptr) {
+        // Allocate the block, unless another thread was faster.
+        std::scoped_lock<std::mutex> lock(m_allocation_mutex);
+        const size_t block_idx = size_t(layer_idx) >> BlockSizeLog2;
+        Directory   *directory = m_directory.load(std::memory_order_relaxed);
+        if (directory == nullptr || block_idx >= directory->size) {
+            // Grow the directory. The old directory may still be read by other threads, thus it is kept.
+            size_t new_size = directory == nullptr ? 16 : directory->size;
+            while (new_size <= block_idx)
+                new_size *= 2;
+            auto new_directory = std::make_unique<Directory>(new_size);
+            if (directory != nullptr)
+                for (size_t i = 0; i < directory->size; ++ i)
+                    new_directory->blocks[i].store(directory->blocks[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            directory = new_directory.get();
+            m_directories.emplace_back(std::move(new_directory));
+            m_directory.store(directory, std::memory_order_release);
+        }
+        Block *block = directory->blocks[block_idx].load(std::memory_order_relaxed);
+        if (block == nullptr) {
+            block = new Block();
+            directory->blocks[block_idx].store(block, std::memory_order_release);
+        }
+        layer = &(*block)[size_t(layer_idx) & (BlockSize - 1)];
+    }
+    // Update the number of layers to be at least layer_idx + 1.
+    for (size_t num_layers = m_num_layers.load(std::memory_order_relaxed); 
+         num_layers <= size_t(layer_idx) && ! m_num_layers.compare_exchange_weak(num_layers, size_t(layer_idx) + 1, std::memory_order_release, std::memory_order_relaxed);) ;
+    return *layer;
 }
 
 // For debugging purposes, sorted by layer index, then by radius.
 std::vector<std::pair<TreeModelVolumes::RadiusLayerPair, std::reference_wrapper<const Polygons>>> TreeModelVolumes::RadiusLayerPolygonCache::sorted() const
 {
     std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> out;
-    for (auto &layer : m_data) {
-        auto layer_idx = LayerIndex(&layer - m_data.data());
-        for (auto &radius_polygons : layer)
-            out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
-    }
+    for (LayerIndex layer_idx = 0; layer_idx < LayerIndex(m_num_layers.load(std::memory_order_acquire)); ++ layer_idx)
+        if (const LayerData *layer = this->layer_data(layer_idx); layer != nullptr)
+            for (auto &radius_polygons : layer->polygons)
+                out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
     assert(std::is_sorted(out.begin(), out.end(), [](auto &l, auto &r){ return l.first.second < r.first.second || (l.first.second == r.first.second) && l.first.first < r.first.first; }));
     return out;
 }
@@ -9,11 +9,19 @@
 #ifndef slic3r_TreeModelVolumes_hpp
 #define slic3r_TreeModelVolumes_hpp
 
+#include <array>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/functional/hash.hpp>
 
+#include <tbb/spin_rw_mutex.h>
+
 #include "TreeSupportCommon.hpp"
 
 #include "../Point.hpp"
@@ -137,6 +145,20 @@ public:
      * \return Polygons object
      */
     const Polygons& getWallRestriction(coord_t radius, LayerIndex layer_idx, bool min_xy_dist) const;
+    /*!
+     * \brief Releases the avoidances and wall restrictions above \p layer_idx if the caches hold more than m_cache_memory_limit bytes.
+     *
+     * The branches are propagated top down, thus once a layer was processed, the areas above it are not requested anymore.
+     * Avoidances are propagated bottom up, therefore only the layers above a given layer are released, so that
+     * an avoidance requested again is recalculated starting from the highest layer kept.
+     * Not thread safe, to be called when no other thread accesses the caches and no reference to the released areas is held.
+     *
+     * \param layer_idx The highest layer to keep.
+     * \return Number of bytes released.
+     */
+    size_t release_above(LayerIndex layer_idx);
+    // Estimate of the memory held by the avoidance and wall restriction caches, which are released by release_above().
+    size_t releasable_memory() const;
     /*!
      * \brief Round \p radius upwards to either a multiple of m_radius_sample_resolution or a exponentially increasing value
      *
@@ -197,67 +219,82 @@ private:
     using RadiusLayerPair             = std::pair<coord_t, LayerIndex>;
     class RadiusLayerPolygonCache {
         // Map from radius to Polygons. Cache of one layer collision regions.
-        using LayerData = std::map<coord_t, Polygons>;
-        // Vector of layers, at each layer map of radius to Polygons.
         // Reference to Polygons returned shall be stable to insertion.
-        using Layers = std::vector<LayerData>;
+        struct LayerData {
+            // Only guards the polygons of this layer, thus threads working on different layers do not contend.
+            // Lookups take a shared (reader) lock, insertions an exclusive one.
+            mutable tbb::spin_rw_mutex  mutex;
+            std::map<coord_t, Polygons> polygons;
+        };
+        // Layers are allocated in blocks, which are not moved nor released until clear(), thus a layer is looked up
+        // without locking the whole cache. The blocks are referenced by a directory, which grows by doubling.
+        // Blocks and directories are only allocated under m_allocation_mutex, which is taken once per block.
+        // A directory replaced by a larger one is kept until clear(), as it may still be read by other threads.
+        static constexpr const size_t BlockSizeLog2 = 8;
+        static constexpr const size_t BlockSize     = size_t(1) << BlockSizeLog2;
+        using Block = std::array<LayerData, BlockSize>;
+        struct Directory {
+            explicit Directory(size_t size) : size(size), blocks(new std::atomic<Block*>[size]) {
+                for (size_t i = 0; i < size; ++ i)
+                    blocks[i].store(nullptr, std::memory_order_relaxed);
+            }
+            const size_t                              size;
+            std::unique_ptr<std::atomic<Block*>[]>    blocks;
+        };
     public:
         RadiusLayerPolygonCache() = default;
-        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) : m_data(std::move(rhs.m_data)) {}
-        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) { m_data = std::move(rhs.m_data); return *this; }
+        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) { *this = std::move(rhs); }
+        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs);
+        ~RadiusLayerPolygonCache() { this->clear(); }
 
         RadiusLayerPolygonCache(const RadiusLayerPolygonCache&) = delete;
         RadiusLayerPolygonCache& operator=(const RadiusLayerPolygonCache&) = delete;
 
         void insert(std::vector<std::pair<RadiusLayerPair, Polygons>> &&in) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first.second).emplace(d.first.first, std::move(d.second));
+                this->emplace(d.first.second, d.first.first, std::move(d.second));
         }
         // by layer
         void insert(std::vector<std::pair<coord_t, Polygons>> &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first).emplace(radius, std::move(d.second));
+                this->emplace(d.first, radius, std::move(d.second));
         }
         void insert(std::vector<Polygons> &&in, coord_t first_layer_idx, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            allocate_layers(first_layer_idx + in.size());
             for (auto &d : in)
-                m_data[first_layer_idx ++].emplace(radius, std::move(d));
+                this->emplace(first_layer_idx ++, radius, std::move(d));
         }
         void insert(LayerPolygonCache &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             LayerIndex i = in.begin();
-            allocate_layers(i + LayerIndex(in.size()));
             for (auto &d : in.polygons_mutable())
-                m_data[i ++].emplace(radius, std::move(d));
+                this->emplace(i ++, radius, std::move(d));
         }
+        // Estimate of the memory held by the cached polygons.
+        size_t memory_used() const { return m_memory_used.load(std::memory_order_relaxed); }
         /*!
          * \brief Checks a cache for a given RadiusLayerPair and returns it if it is found
          * \param key RadiusLayerPair of the requested areas. The radius will be calculated up to the provided layer.
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         std::optional<std::reference_wrapper<const Polygons>> getArea(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
+            const LayerData *layer = this->layer_data(key.second);
+            if (layer == nullptr)
                 return std::optional<std::reference_wrapper<const Polygons>>{};
-            const auto &layer = m_data[key.second];
-            auto it = layer.find(key.first);
-            return it == layer.end() ? 
+            tbb::spin_rw_mutex::scoped_lock lock(layer->mutex, false /* reader */);
+            auto it = layer->polygons.find(key.first);
+            return it == layer->polygons.end() ? 
                 std::optional<std::reference_wrapper<const Polygons>>{} : std::optional<std::reference_wrapper<const Polygons>>{ it->second };
         }
         // Get a collision area at a given layer for a radius that is a lower or equial to the key radius.
         std::optional<std::pair<coord_t, std::reference_wrapper<const Polygons>>> get_lower_bound_area(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
+            const LayerData *layer = this->layer_data(key.second);
+            if (layer == nullptr)
                 return {};
-            const auto &layer = m_data[key.second];
-            if (layer.empty())
+            tbb::spin_rw_mutex::scoped_lock lock(layer->mutex, false /* reader */);
+            if (layer->polygons.empty())
                 return {};
-            auto it = layer.lower_bound(key.first);
-            if (it == layer.end() || it->first != key.first) {
-                if (it == layer.begin())
+            auto it = layer->polygons.lower_bound(key.first);
+            if (it == layer->polygons.end() || it->first != key.first) {
+                if (it == layer->polygons.begin())
                     return {};
                 -- it;
             }
@@ -271,11 +308,13 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         LayerIndex getMaxCalculatedLayer(coord_t radius) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            auto layer_idx = LayerIndex(m_data.size()) - 1;
+            auto layer_idx = LayerIndex(m_num_layers.load(std::memory_order_acquire)) - 1;
             for (; layer_idx > 0; -- layer_idx)
-                if (const auto &layer = m_data[layer_idx]; layer.find(radius) != layer.end())
-                    break;
+                if (const LayerData *layer = this->layer_data(layer_idx); layer != nullptr) {
+                    tbb::spin_rw_mutex::scoped_lock lock(layer->mutex, false /* reader */);
+                    if (layer->polygons.find(radius) != layer->polygons.end())
+                        break;
+                }
             // The placeable on model areas do not exist on layer 0, as there can not be model below it. As such it may be possible that layer 1 is available, but layer 0 does not exist.
             return layer_idx == 0 ? -1 : layer_idx;
         }
@@ -283,25 +322,48 @@ private:
         // For debugging purposes, sorted by layer index, then by radius.
         [[nodiscard]] std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> sorted() const;
 
-        void clear() { m_data.clear(); }
-        void clear_all_but_radius0() { 
-            for (LayerData &l : m_data) {
-                auto begin = l.begin();
-                auto end = l.end();
-                if (begin != end && ++ begin != end)
-                    l.erase(begin, end);
-            }
-        }
+        // Not thread safe, to be called when no other thread accesses the cache.
+        void clear();
+        void clear_all_but_radius0();
+        // Release all layers above layer_idx, returns number of bytes released.
+        size_t release_above(LayerIndex layer_idx);
 
     private:
-        LayerData&          get_allocate_layer_data(LayerIndex layer_idx) {
-            allocate_layers(layer_idx + 1);
-            return m_data[layer_idx];
+        // Returns nullptr if the layer was not allocated yet.
+        const LayerData*    layer_data(LayerIndex layer_idx) const {
+            if (layer_idx < 0)
+                return nullptr;
+            const Directory *directory = m_directory.load(std::memory_order_acquire);
+            const size_t     block_idx = size_t(layer_idx) >> BlockSizeLog2;
+            if (directory == nullptr || block_idx >= directory->size)
+                return nullptr;
+            const Block *block = directory->blocks[block_idx].load(std::memory_order_acquire);
+            return block == nullptr ? nullptr : &(*block)[size_t(layer_idx) & (BlockSize - 1)];
+        }
+        LayerData&          get_allocate_layer_data(LayerIndex layer_idx);
+        void                emplace(LayerIndex layer_idx, coord_t radius, Polygons &&polygons) {
+            LayerData &layer = this->get_allocate_layer_data(layer_idx);
+            const size_t bytes = polygons_memory_used(polygons);
+            tbb::spin_rw_mutex::scoped_lock lock(layer.mutex, true /* writer */);
+            if (layer.polygons.emplace(radius, std::move(polygons)).second)
+                m_memory_used.fetch_add(bytes, std::memory_order_relaxed);
+        }
+        static size_t       polygons_memory_used(const Polygons &polygons) {
+            size_t out = polygons.capacity() * sizeof(Polygon);
+            for (const Polygon &polygon : polygons)
+                out += polygon.points.capacity() * sizeof(Point);
+            return out;
         }
-        void                allocate_layers(size_t num_layers);
 
-        Layers              m_data;
-        mutable std::mutex  m_mutex;
+        // Current directory, the last one of m_directories.
+        std::atomic<Directory*>                    m_directory { nullptr };
+        // All directories allocated since clear(), the blocks are owned by the last one.
+        std::vector<std::unique_ptr<Directory>>    m_directories;
+        std::mutex                                 m_allocation_mutex;
+        // One past the highest layer allocated.
+        std::atomic<size_t>                        m_num_layers { 0 };
+        // Sum of polygons_memory_used() of all the cached polygons.
+        std::atomic<size_t>                        m_memory_used { 0 };
     };
 
 
@@ -428,6 +490,14 @@ private:
     coord_t m_min_resolution;
 
     bool m_precalculated = false;
+    /*!
+     * \brief Avoidances and wall restrictions are released by release_above() once they hold more memory than this limit.
+     */
+    size_t m_cache_memory_limit = size_t(2) << 30;
+    /*!
+     * \brief Highest layer kept by release_above(), a layer above it being recalculated is not an error of precalculate().
+     */
+    LayerIndex m_released_above = std::numeric_limits<LayerIndex>::max();
     /*!
      * \brief The index to access the outline corresponding with the currently processing mesh
      */
@@ -2402,7 +2402,7 @@ static void merge_influence_areas(
  *
  * \param move_bounds[in,out] All currently existing influence areas
  */
-static void create_layer_pathing(const TreeModelVolumes &volumes, const TreeSupportSettings &config, std::vector<SupportElements> &move_bounds, std::function<void()> throw_on_cancel)
+static void create_layer_pathing(TreeModelVolumes &volumes, const TreeSupportSettings &config, std::vector<SupportElements> &move_bounds, std::function<void()> throw_on_cancel)
 {
 #ifdef SLIC3R_TREESUPPORTS_PROGRESS
     const double data_size_inverse = 1 / double(move_bounds.size());
@@ -2489,6 +2489,9 @@ static void create_layer_pathing(const TreeModelVolumes &volumes, const TreeSupp
                     this_layer.emplace_back(elem.state, std::move(elem.parents), std::move(new_area));
                 }
 
+            // Avoidances and wall restrictions above the next layer will not be requested anymore, release them if they grew too large.
+            volumes.release_above(layer_idx - 1);
+
     #ifdef SLIC3R_TREESUPPORTS_PROGRESS
             progress_total += data_size_inverse * TREE_PROGRESS_AREA_CALC;
             Progress::messageProgress(Progress::Stage::SUPPORT, progress_total * m_progress_multiplier + m_progress_offset, TREE_PROGRESS_TOTAL);
@@ -0,0 +1,176 @@
+#include "Trace.hpp"
+#include "Thread.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+
+namespace Slic3r {
+namespace Trace {
+
+namespace {
+
+struct Event
+{
+    const char *name;
+    int64_t     start_ns;
+    int64_t     end_ns;
+    int64_t     arg;
+};
+
+// Ring buffer of a single thread. Only written by its owner thread, read by write_chrome_json()
+// after the traced code finished. The events vector grows on demand up to capacity, then it wraps around.
+struct ThreadBuffer
+{
+    std::vector<Event>  events;
+    size_t              capacity     { 0 };
+    // Total number of events recorded since the last start(), the ring buffer keeps the last events.size() of them.
+    std::atomic<size_t> num_recorded { 0 };
+    // Incremented by start() to reset the buffers lazily from their owner threads.
+    size_t              generation   { 0 };
+    size_t              thread_idx;
+    std::string         thread_name;
+};
+
+std::mutex                                 g_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> g_buffers;
+std::atomic<size_t>                        g_generation        { 0 };
+size_t                                     g_events_per_thread { 1 << 16 };
+const auto                                 g_epoch             = std::chrono::steady_clock::now();
+
+ThreadBuffer& this_thread_buffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    size_t generation = g_generation.load(std::memory_order_acquire);
+    if (! buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        std::optional<std::string> name = get_current_thread_name();
+        std::scoped_lock<std::mutex> lock(g_mutex);
+        buffer->thread_idx  = g_buffers.size();
+        buffer->thread_name = name && ! name->empty() ? *name : "thread " + std::to_string(buffer->thread_idx);
+        buffer->capacity    = g_events_per_thread;
+        buffer->generation  = generation;
+        g_buffers.emplace_back(buffer);
+    } else if (buffer->generation != generation) {
+        std::scoped_lock<std::mutex> lock(g_mutex);
+        buffer->events.clear();
+        buffer->capacity   = g_events_per_thread;
+        buffer->generation = generation;
+        buffer->num_recorded.store(0, std::memory_order_relaxed);
+    }
+    return *buffer;
+}
+
+void write_escaped(std::ostream &os, const std::string &s)
+{
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (static_cast<unsigned char>(c) >= 0x20)
+            os << c;
+    }
+}
+
+} // namespace
+
+namespace detail {
+
+std::atomic<bool> enabled { false };
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void record(const char *name, int64_t start_ns, int64_t end_ns, int64_t arg)
+{
+    ThreadBuffer &buffer = this_thread_buffer();
+    if (buffer.capacity == 0)
+        return;
+    size_t idx = buffer.num_recorded.load(std::memory_order_relaxed);
+    if (buffer.events.size() < buffer.capacity)
+        buffer.events.push_back({ name, start_ns, end_ns, arg });
+    else
+        buffer.events[idx % buffer.capacity] = { name, start_ns, end_ns, arg };
+    buffer.num_recorded.store(idx + 1, std::memory_order_release);
+}
+
+} // namespace detail
+
+void start(size_t events_per_thread)
+{
+    {
+        std::scoped_lock<std::mutex> lock(g_mutex);
+        g_events_per_thread = events_per_thread;
+        // The buffers of the threads are reset by their owners when they record the next event,
+        // the buffers of the idle threads are reset here.
+        for (std::shared_ptr<ThreadBuffer> &buffer : g_buffers)
+            buffer->num_recorded.store(0, std::memory_order_relaxed);
+    }
+    g_generation.fetch_add(1, std::memory_order_release);
+    detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop()
+{
+    detail::enabled.store(false, std::memory_order_relaxed);
+}
+
+bool write_chrome_json(const std::string &path)
+{
+    boost::nowide::ofstream os(path);
+    if (! os.good()) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to open trace file " << path;
+        return false;
+    }
+
+    size_t num_events  = 0;
+    size_t num_dropped = 0;
+    char   buf[64];
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    std::scoped_lock<std::mutex> lock(g_mutex);
+    const size_t generation = g_generation.load(std::memory_order_acquire);
+    for (const std::shared_ptr<ThreadBuffer> &buffer : g_buffers) {
+        os << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_idx << ",\"args\":{\"name\":\"";
+        write_escaped(os, buffer->thread_name);
+        os << "\"}}";
+        first = false;
+        if (buffer->generation != generation || buffer->events.empty())
+            // Did not record anything since the last start().
+            continue;
+        const size_t num_recorded = buffer->num_recorded.load(std::memory_order_acquire);
+        const size_t num_kept     = std::min(num_recorded, buffer->events.size());
+        num_dropped += num_recorded - num_kept;
+        num_events  += num_kept;
+        for (size_t i = num_recorded - num_kept; i < num_recorded; ++ i) {
+            const Event &event = buffer->events[i % buffer->events.size()];
+            // Chrome trace timestamps are in microseconds.
+            snprintf(buf, sizeof(buf), "%.3f,\"dur\":%.3f", double(event.start_ns) * 1e-3, double(event.end_ns - event.start_ns) * 1e-3);
+            os << ",\n{\"name\":\"";
+            write_escaped(os, event.name);
+            os << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_idx << ",\"ts\":" << buf;
+            if (event.arg != Scope::NoArg)
+                os << ",\"args\":{\"value\":" << event.arg << "}";
+            os << "}";
+        }
+    }
+    os << "\n]}\n";
+    os.close();
+    if (os.fail()) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to write trace file " << path;
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(info) << "Written " << num_events << " trace events to " << path << 
+        (num_dropped > 0 ? ", " + std::to_string(num_dropped) + " oldest events were dropped" : std::string());
+    return true;
+}
+
+} // namespace Trace
+} // namespace Slic3r
@@ -0,0 +1,82 @@
+#ifndef slic3r_Trace_hpp_
+#define slic3r_Trace_hpp_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Lightweight scoped tracing of the slicing pipeline, exported into the Chrome / Perfetto trace JSON format
+// (load into chrome://tracing or https://ui.perfetto.dev) to see the utilization of the TBB worker threads
+// and the serial bottlenecks.
+//
+// The instrumentation is compiled in with the SLIC3R_TRACE CMake option. If compiled in, it is enabled at runtime
+// by Trace::start(), otherwise a trace scope costs a single relaxed atomic load.
+// Each thread records into its own ring buffer, thus recording is lock free and the oldest events are overwritten
+// if the buffer overflows. The buffer grows with the events recorded up to its limit, thus a thread which records
+// just a few events costs just a few bytes.
+//
+// Usage: SLIC3R_TRACE_SCOPE("PrintObject::make_perimeters");
+//        SLIC3R_TRACE_SCOPE_ARG("GCode::process_layer", layer_id);
+// The name has to be a string literal or otherwise outlive the trace.
+
+namespace Slic3r {
+namespace Trace {
+
+namespace detail {
+    extern std::atomic<bool> enabled;
+    int64_t now_ns();
+    void    record(const char *name, int64_t start_ns, int64_t end_ns, int64_t arg);
+}
+
+// Is the tracing active?
+inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+// Start tracing, discarding the events recorded so far. Each thread keeps at most events_per_thread last events
+// (32 bytes each, thus 2 MB per thread by default).
+void start(size_t events_per_thread = 1 << 16);
+// Stop tracing. The recorded events are kept until the next start().
+void stop();
+// Write the recorded events in Chrome trace JSON format. Returns false if the file could not be written.
+// To be called when no traced code is running, for example after Print::process() and G-code export finished.
+bool write_chrome_json(const std::string &path);
+
+// Records the lifetime of the scope as a single "complete" event.
+class Scope
+{
+public:
+    static constexpr const int64_t NoArg = INT64_MIN;
+
+    explicit Scope(const char *name, int64_t arg = NoArg) : m_name(enabled() ? name : nullptr), m_arg(arg) {
+        if (m_name)
+            m_start_ns = detail::now_ns();
+    }
+    ~Scope() {
+        if (m_name)
+            detail::record(m_name, m_start_ns, detail::now_ns(), m_arg);
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char *m_name;
+    int64_t     m_arg;
+    int64_t     m_start_ns { 0 };
+};
+
+} // namespace Trace
+} // namespace Slic3r
+
+#define SLIC3R_TRACE_CONCAT_IMPL(a, b) a##b
+#define SLIC3R_TRACE_CONCAT(a, b) SLIC3R_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef SLIC3R_TRACE
+    #define SLIC3R_TRACE_SCOPE(name) ::Slic3r::Trace::Scope SLIC3R_TRACE_CONCAT(slic3r_trace_scope_, __LINE__)(name)
+    #define SLIC3R_TRACE_SCOPE_ARG(name, arg) ::Slic3r::Trace::Scope SLIC3R_TRACE_CONCAT(slic3r_trace_scope_, __LINE__)(name, int64_t(arg))
+#else
+    #define SLIC3R_TRACE_SCOPE(name) do {} while (false)
+    #define SLIC3R_TRACE_SCOPE_ARG(name, arg) do {} while (false)
+#endif
+
+#endif // slic3r_Trace_hpp_
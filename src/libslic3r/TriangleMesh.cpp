@@ -14,7 +14,9 @@
 #include <libqhullcpp/QhullFacetList.h>
 #include <libqhullcpp/QhullVertexSet.h>
 
+#include <atomic>
 #include <cmath>
+#include <limits>
 #include <deque>
 #include <queue>
 #include <vector>
@@ -22,11 +24,15 @@
 #include <algorithm>
 #include <type_traits>
 
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/cstdio.hpp>
 #include <boost/predef/other/endian.h>
 
 #include <tbb/concurrent_vector.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
 
 #include <Eigen/Core>
 #include <Eigen/Dense>
@@ -179,8 +185,86 @@ static void trianglemesh_repair_on_import(stl_file &stl)
     BOOST_LOG_TRIVIAL(debug) << "TriangleMesh::repair() finished";
 }
 
+// Returns true if admesh would not change the mesh during repair on import: There are no degenerate faces,
+// all faces have three neighbors with consistent orientation, the faces around each vertex form a single fan
+// (stl_generate_shared_vertices() would split a vertex shared by multiple fans) and the volume is positive.
+static bool its_is_repaired_on_import(const indexed_triangle_set &its, const std::vector<Vec3i> &face_neighbors)
+{
+    // Number of faces around each vertex and the face with the lowest index around each vertex.
+    std::vector<std::atomic<int>> vertex_num_faces(its.vertices.size());
+    std::vector<std::atomic<int>> vertex_first_face(its.vertices.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, its.vertices.size()), [&vertex_num_faces, &vertex_first_face](const tbb::blocked_range<size_t> &range) {
+        for (size_t vertex_idx = range.begin(); vertex_idx < range.end(); ++ vertex_idx) {
+            vertex_num_faces[vertex_idx].store(0, std::memory_order_relaxed);
+            vertex_first_face[vertex_idx].store(std::numeric_limits<int>::max(), std::memory_order_relaxed);
+        }
+    });
+    tbb::parallel_for(tbb::blocked_range<int>(0, int(its.indices.size())), [&its, &vertex_num_faces, &vertex_first_face](const tbb::blocked_range<int> &range) {
+        for (int face_idx = range.begin(); face_idx < range.end(); ++ face_idx)
+            for (int i = 0; i < 3; ++ i) {
+                const int vertex_idx = its.indices[face_idx](i);
+                vertex_num_faces[vertex_idx].fetch_add(1, std::memory_order_relaxed);
+                for (int first_face = vertex_first_face[vertex_idx].load(std::memory_order_relaxed);
+                     face_idx < first_face && ! vertex_first_face[vertex_idx].compare_exchange_weak(first_face, face_idx, std::memory_order_relaxed););
+            }
+    });
+
+    std::atomic<bool> valid { true };
+    tbb::parallel_for(tbb::blocked_range<int>(0, int(its.indices.size())), 
+        [&its, &face_neighbors, &vertex_num_faces, &vertex_first_face, &valid](const tbb::blocked_range<int> &range) {
+        for (int face_idx = range.begin(); face_idx < range.end() && valid; ++ face_idx) {
+            const stl_triangle_vertex_indices &face = its.indices[face_idx];
+            if (face(0) == face(1) || face(0) == face(2) || face(1) == face(2)) {
+                valid = false;
+                break;
+            }
+            for (int i = 0; i < 3; ++ i) {
+                const int neighbor = face_neighbors[face_idx](i);
+                if (neighbor == -1 || (face_neighbors[neighbor].array() != face_idx).all()) {
+                    valid = false;
+                    break;
+                }
+                // Walk the fan around the vertex starting with its first face.
+                // Crossing the edge starting with the pivot vertex, the next face shares the edge in opposite direction,
+                // thus the edge of the next face starting with the pivot vertex is crossed next.
+                const int vertex_idx = face(i);
+                if (vertex_first_face[vertex_idx] == face_idx) {
+                    int num_faces = 0;
+                    int fan_face  = face_idx;
+                    do {
+                        const int idx = its_triangle_vertex_index(its.indices[fan_face], vertex_idx);
+                        fan_face = idx == -1 ? -1 : face_neighbors[fan_face](idx);
+                    } while (++ num_faces <= vertex_num_faces[vertex_idx] && fan_face != face_idx && fan_face != -1);
+                    if (num_faces != vertex_num_faces[vertex_idx] || fan_face != face_idx) {
+                        valid = false;
+                        break;
+                    }
+                }
+            }
+        }
+    });
+    return valid && its_volume(its) > 0;
+}
+
 bool TriangleMesh::ReadSTLFile(const char* input_file, bool repair)
 { 
+    // Fast path: Memory map a binary STL and weld its vertices in parallel. If the mesh is a closed manifold,
+    // then admesh would not repair anything and the slow path through stl_file is skipped.
+    if (repair && its_read_stl_binary(input_file, this->its)) {
+        std::vector<Vec3i> face_neighbors = its_face_neighbors_par(this->its);
+        if (its_is_repaired_on_import(this->its, face_neighbors)) {
+            m_stats.clear();
+            m_stats.number_of_facets = this->its.indices.size();
+            m_stats.volume           = its_volume(this->its);
+            update_bounding_box(this->its, m_stats);
+            m_stats.number_of_parts  = its_number_of_patches(this->its, face_neighbors);
+            m_stats.open_edges       = 0;
+            return true;
+        }
+        BOOST_LOG_TRIVIAL(debug) << "TriangleMesh::ReadSTLFile: " << input_file << " needs repair";
+        this->its.clear();
+    }
+
     stl_file stl;
     if (! stl_open(&stl, input_file))
         return false;
@@ -734,6 +818,73 @@ int its_merge_vertices(indexed_triangle_set &its, bool shrink_to_fit)
     return num_erased;
 }
 
+int its_merge_vertices_par(indexed_triangle_set &its, bool shrink_to_fit)
+{
+    // 1) Sort indices to vertices lexicographically by coordinates AND vertex index.
+    std::vector<int> sorted(its.vertices.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, sorted.size()), [&sorted](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++ i)
+            sorted[i] = int(i);
+    });
+    tbb::parallel_sort(sorted.begin(), sorted.end(), [&its](int il, int ir) {
+        const Vec3f &l = its.vertices[il];
+        const Vec3f &r = its.vertices[ir];
+        // Sort lexicographically by coordinates AND vertex index.
+        return l.x() < r.x() || (l.x() == r.x() && (l.y() < r.y() || (l.y() == r.y() && (l.z() < r.z() || (l.z() == r.z() && il < ir)))));
+    });
+
+    // 2) Map duplicate vertices to the one with the lowest vertex index, which is the first one of a run of the same vertices.
+    // The vertex to stay will have a map_vertices[...] == -1 index assigned, the other vertices will point to it.
+    std::vector<int> map_vertices(its.vertices.size(), -1);
+    tbb::parallel_for(tbb::blocked_range<size_t>(1, sorted.size()), [&its, &sorted, &map_vertices](const tbb::blocked_range<size_t> &range) {
+        // Find the start of the run of the same vertices the range starts with.
+        size_t i = range.begin();
+        while (i > 0 && its.vertices[sorted[i - 1]] == its.vertices[sorted[range.begin()]])
+            -- i;
+        for (size_t j = range.begin(); j < range.end(); ++ j) {
+            if (its.vertices[sorted[j]] != its.vertices[sorted[i]])
+                i = j;
+            else if (i != j) {
+                assert(sorted[j] > sorted[i]);
+                map_vertices[sorted[j]] = sorted[i];
+            }
+        }
+    });
+
+    // 3) Shrink its.vertices, update map_vertices with the new vertex indices.
+    // Vertices are only moved towards the lower indices, thus this step is sequential.
+    int k = 0;
+    for (int i = 0; i < int(its.vertices.size()); ++ i) {
+        if (map_vertices[i] == -1) {
+            map_vertices[i] = k;
+            if (k < i)
+                its.vertices[k] = its.vertices[i];
+            ++ k;
+        } else {
+            assert(map_vertices[i] < i);
+            map_vertices[i] = map_vertices[map_vertices[i]];
+        }
+    }
+
+    int num_erased = int(its.vertices.size()) - k;
+
+    if (num_erased) {
+        // Shrink the vertices.
+        its.vertices.erase(its.vertices.begin() + k, its.vertices.end());
+        // Remap face indices.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, its.indices.size()), [&its, &map_vertices](const tbb::blocked_range<size_t> &range) {
+            for (size_t face_idx = range.begin(); face_idx < range.end(); ++ face_idx)
+                for (int i = 0; i < 3; ++ i)
+                    its.indices[face_idx](i) = map_vertices[its.indices[face_idx](i)];
+        });
+        // Optionally shrink to fit (reallocate) vertices.
+        if (shrink_to_fit)
+            its.vertices.shrink_to_fit();
+    }
+
+    return num_erased;
+}
+
 void its_flip_triangles(indexed_triangle_set &its)
 {
     for (stl_triangle_vertex_indices &face : its.indices)
@@ -1612,4 +1763,44 @@ bool its_write_stl_binary(const char *file, const char *label, const std::vector
 }
 
 
+bool its_read_stl_binary(const char *file, indexed_triangle_set &its)
+{
+    its.clear();
+
+    boost::iostreams::mapped_file_source mapped;
+    try {
+        mapped.open(boost::filesystem::path(file));
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << "its_read_stl_binary: Couldn't map " << file << " for reading: " << ex.what();
+        return false;
+    }
+
+    const size_t file_size = mapped.size();
+    const char  *data      = mapped.data();
+    // Same tests as performed by admesh: The file size has to match a whole number of facets
+    // and the start of the data has to contain a character outside of the 7-bit ASCII range.
+    if (file_size < STL_MIN_FILE_SIZE || (file_size - HEADER_SIZE) % SIZEOF_STL_FACET != 0 ||
+        std::none_of(data + HEADER_SIZE, data + HEADER_SIZE + 128, [](char c) { return (unsigned char)c > 127; }))
+        return false;
+
+    const size_t num_facets = (file_size - HEADER_SIZE) / SIZEOF_STL_FACET;
+    its.vertices.assign(num_facets * 3, stl_vertex());
+    its.indices.assign(num_facets, stl_triangle_vertex_indices());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_facets), [data, &its](const tbb::blocked_range<size_t> &range) {
+        for (size_t facet_idx = range.begin(); facet_idx < range.end(); ++ facet_idx) {
+            // Skip the normal, it is not stored into indexed_triangle_set.
+            const char *src = data + HEADER_SIZE + facet_idx * SIZEOF_STL_FACET + sizeof(stl_normal);
+            // The facets are not aligned, copy the vertices byte by byte.
+            ::memcpy(its.vertices[facet_idx * 3].data(), src, 3 * sizeof(stl_vertex));
+            big_endian_reverse_quads(reinterpret_cast<char*>(its.vertices[facet_idx * 3].data()), 3 * sizeof(stl_vertex));
+            its.indices[facet_idx] = stl_triangle_vertex_indices(int(facet_idx * 3), int(facet_idx * 3 + 1), int(facet_idx * 3 + 2));
+        }
+    });
+    mapped.close();
+
+    its_merge_vertices_par(its);
+    return true;
+}
+
+
 } // namespace Slic3r
@@ -203,6 +203,8 @@ void its_flip_triangles(indexed_triangle_set &its);
 // This function will happily create non-manifolds if more than two faces share the same vertex position
 // or more than two faces share the same edge position!
 int its_merge_vertices(indexed_triangle_set &its, bool shrink_to_fit = true);
+// Parallel version of its_merge_vertices(), producing the same result.
+int its_merge_vertices_par(indexed_triangle_set &its, bool shrink_to_fit = true);
 
 // Calculate number of degenerate faces. There should be no degenerate faces in a nice mesh.
 int its_num_degenerate_faces(const indexed_triangle_set &its);
@@ -336,6 +338,9 @@ bool        its_write_stl_ascii(const char *file, const char *label, const std::
 inline bool its_write_stl_ascii(const char *file, const char *label, const indexed_triangle_set &its) { return its_write_stl_ascii(file, label, its.indices, its.vertices); }
 bool        its_write_stl_binary(const char *file, const char *label, const std::vector<stl_triangle_vertex_indices> &indices, const std::vector<stl_vertex> &vertices);
 inline bool its_write_stl_binary(const char *file, const char *label, const indexed_triangle_set &its) { return its_write_stl_binary(file, label, its.indices, its.vertices); }
+// Load a binary STL by memory mapping it, merging vertices with the same coordinates in parallel.
+// Returns false if the file could not be mapped or if it is not a binary STL. The mesh is not repaired.
+bool        its_read_stl_binary(const char *file, indexed_triangle_set &its);
 
 inline BoundingBoxf3 bounding_box(const TriangleMesh &m) { return m.bounding_box(); }
 inline BoundingBoxf3 bounding_box(const indexed_triangle_set& its)
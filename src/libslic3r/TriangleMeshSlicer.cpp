@@ -6,6 +6,7 @@
 #include "Utils.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <deque>
 #include <queue>
@@ -15,8 +16,13 @@
 
 #include <boost/log/trivial.hpp>
 
+#if (defined(__SSE2__) || defined(_M_X64))
+    #include <emmintrin.h>
+#endif
+
 #include <tbb/parallel_for.h>
 #include <tbb/scalable_allocator.h>
+#include <tbb/task_arena.h>
 
 #include <ankerl/unordered_dense.h>
 
@@ -362,6 +368,140 @@ inline FacetSliceType slice_facet(
     return FacetSliceType::NoSlice;
 }
 
+// Is the vectorized edge / plane intersection kernel compiled in?
+// SSE2 is part of the x86-64 base instruction set. The kernel is disabled if the compiler may contract the scalar
+// intersection formula of slice_facet() into fused multiply-adds, because then the kernel's results would differ
+// from slice_facet() in the last bit and the slices would no longer be identical.
+#if (defined(__SSE2__) || defined(_M_X64)) && ! defined(__FMA__) && ! defined(__AVX2__)
+    #define SLIC3R_SLICE_FACET_SSE2 1
+#else
+    #define SLIC3R_SLICE_FACET_SSE2 0
+#endif
+
+// Intersection point of edge a, b with a plane at slice_z, which the edge crosses, calculated exactly as by slice_facet().
+inline Point slice_edge(const stl_vertex &a, const stl_vertex &b, const float slice_z)
+{
+    double t = (double(slice_z) - double(a.z())) / (double(b.z()) - double(a.z()));
+    return t <= 0. ? v3f_scaled_to_contour_point(a) :
+           t >= 1. ? v3f_scaled_to_contour_point(b) :
+           v3f_scaled_to_contour_point(a.template head<2>().template cast<double>() * (1. - t) + b.template head<2>().template cast<double>() * t + Vec2d(0.5, 0.5));
+}
+
+// Intersection points of edge a, b with planes at zs[0, num_planes), which the edge crosses.
+// Two planes are processed per instruction if SLIC3R_SLICE_FACET_SSE2 is set, producing the same points as slice_edge().
+inline void slice_edge_with_planes(const stl_vertex &a, const stl_vertex &b, const float *zs, const int num_planes, Point *out)
+{
+    int i = 0;
+#if SLIC3R_SLICE_FACET_SSE2
+    const __m128d az        = _mm_set1_pd(double(a.z()));
+    const __m128d dz        = _mm_set1_pd(double(b.z()) - double(a.z()));
+    const __m128d ax        = _mm_set1_pd(double(a.x()));
+    const __m128d ay        = _mm_set1_pd(double(a.y()));
+    const __m128d bx        = _mm_set1_pd(double(b.x()));
+    const __m128d by        = _mm_set1_pd(double(b.y()));
+    const __m128d zero      = _mm_setzero_pd();
+    const __m128d one       = _mm_set1_pd(1.);
+    const __m128d half      = _mm_set1_pd(0.5);
+    // Range of doubles, which _mm_cvttpd_epi32() truncates to int32_t.
+    const __m128d int_min   = _mm_set1_pd(-2147483648.);
+    const __m128d int_max   = _mm_set1_pd(2147483647.);
+    // floor() by truncation, decremented where the truncation rounded up (negative non-integers).
+    auto floor_epi32 = [](const __m128d v) {
+        const __m128i truncated = _mm_cvttpd_epi32(v);
+        const __m128i rounded_up = _mm_castpd_si128(_mm_cmpgt_pd(_mm_cvtepi32_pd(truncated), v));
+        // Move the 64bit masks of the two lanes into the two low 32bit lanes, adding -1 where rounded up.
+        return _mm_add_epi32(truncated, _mm_shuffle_epi32(rounded_up, _MM_SHUFFLE(3, 3, 2, 0)));
+    };
+    for (; i + 2 <= num_planes; i += 2) {
+        const __m128d z   = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(zs + i))));
+        const __m128d t   = _mm_div_pd(_mm_sub_pd(z, az), dz);
+        const __m128d omt = _mm_sub_pd(one, t);
+        const __m128d x   = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(ax, omt), _mm_mul_pd(bx, t)), half), half);
+        const __m128d y   = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(ay, omt), _mm_mul_pd(by, t)), half), half);
+        const __m128d valid = _mm_and_pd(
+            _mm_and_pd(_mm_cmpgt_pd(t, zero), _mm_cmplt_pd(t, one)),
+            _mm_and_pd(
+                _mm_and_pd(_mm_cmpge_pd(x, int_min), _mm_cmplt_pd(x, int_max)),
+                _mm_and_pd(_mm_cmpge_pd(y, int_min), _mm_cmplt_pd(y, int_max))));
+        if (_mm_movemask_pd(valid) != 3) {
+            // Intersection clamped to an edge end point or out of the int32_t range, rare.
+            out[i]     = slice_edge(a, b, zs[i]);
+            out[i + 1] = slice_edge(a, b, zs[i + 1]);
+            continue;
+        }
+        const __m128i xi = floor_epi32(x);
+        const __m128i yi = floor_epi32(y);
+        out[i]     = Point(coord_t(_mm_cvtsi128_si32(xi)), coord_t(_mm_cvtsi128_si32(yi)));
+        out[i + 1] = Point(coord_t(_mm_cvtsi128_si32(_mm_shuffle_epi32(xi, 1))), coord_t(_mm_cvtsi128_si32(_mm_shuffle_epi32(yi, 1))));
+    }
+#endif // SLIC3R_SLICE_FACET_SSE2
+    for (; i < num_planes; ++ i)
+        out[i] = slice_edge(a, b, zs[i]);
+}
+
+// Slice a facet with planes zs[0, num_planes) sorted by Z, producing the same lines as slice_facet() called for each plane.
+// A plane in a general position (not passing through any of the facet vertices) intersects two facet edges, and the planes
+// crossing a facet edge form a continuous range, thus the intersection points are calculated edge by edge over the range
+// of planes by slice_edge_with_planes(). Planes passing through a vertex are sliced by slice_facet().
+// Emit is called as emit(plane index, line) in the order of the planes.
+template<typename Emit>
+inline void slice_facet_with_planes(
+    const stl_vertex                               *vertices,
+    const stl_triangle_vertex_indices              &indices,
+    const Vec3i                                    &edge_ids,
+    const int                                       idx_vertex_lowest,
+    const float                                    *zs,
+    const int                                       num_planes,
+    // Scratch space for the edge intersection points, to be reused between the calls.
+    std::array<std::vector<Point>, 3>              &edge_points,
+    Emit                                          &&emit)
+{
+    // Range of planes [plane_begin[j], plane_end[j]) crossing the j-th edge, edges ordered as in slice_facet().
+    int plane_begin[3];
+    int plane_end[3];
+    for (int j = 0; j < 3; ++ j) {
+        int k = (idx_vertex_lowest + j) % 3;
+        int l = (k + 1) % 3;
+        // Sort the edge to give a consistent answer, as slice_facet() does.
+        const stl_vertex *a = vertices + k;
+        const stl_vertex *b = vertices + l;
+        if (indices[k] > indices[l])
+            std::swap(a, b);
+        const float zmin = std::min(a->z(), b->z());
+        const float zmax = std::max(a->z(), b->z());
+        plane_begin[j] = int(std::upper_bound(zs, zs + num_planes, zmin) - zs);
+        plane_end[j]   = std::max(plane_begin[j], int(std::lower_bound(zs, zs + num_planes, zmax) - zs));
+        std::vector<Point> &points = edge_points[j];
+        if (points.size() < size_t(num_planes))
+            points.resize(num_planes);
+        slice_edge_with_planes(*a, *b, zs + plane_begin[j], plane_end[j] - plane_begin[j], points.data() + plane_begin[j]);
+    }
+
+    for (int i = 0; i < num_planes; ++ i) {
+        const float slice_z = zs[i];
+        IntersectionLine il;
+        if (slice_z == vertices[0].z() || slice_z == vertices[1].z() || slice_z == vertices[2].z()) {
+            if (slice_facet(slice_z, vertices, indices, edge_ids, idx_vertex_lowest, false, il) == FacetSliceType::Slicing)
+                emit(i, il);
+            continue;
+        }
+        // The plane cuts exactly two edges in a general position.
+        int first = -1;
+        int second = -1;
+        for (int j = 0; j < 3; ++ j)
+            if (i >= plane_begin[j] && i < plane_end[j])
+                (first == -1 ? first : second) = j;
+        if (second == -1)
+            continue;
+        il.edge_type = IntersectionLine::FacetEdgeType::General;
+        il.a         = edge_points[second][i];
+        il.b         = edge_points[first][i];
+        il.edge_a_id = edge_ids((idx_vertex_lowest + second) % 3);
+        il.edge_b_id = edge_ids((idx_vertex_lowest + first) % 3);
+        emit(i, il);
+    }
+}
+
 class LinesMutexes {
 public:
     std::mutex& operator()(size_t slice_id) {
@@ -377,41 +517,61 @@ private:
     std::array<CacheLineAlignedMutex, 64> m_mutexes;
 };
 
-template<typename TransformVertex>
-void slice_facet_at_zs(
-    // Scaled or unscaled vertices. transform_vertex_fn may scale zs.
-    const std::vector<Vec3f>                         &mesh_vertices,
-    const TransformVertex                            &transform_vertex_fn,
-    const stl_triangle_vertex_indices                &indices,
-    const Vec3i                                      &edge_ids,
-    // Scaled or unscaled zs. If vertices have their zs scaled or transform_vertex_fn scales them, then zs have to be scaled as well.
-    const std::vector<float>                         &zs,
-    std::vector<IntersectionLines>                   &lines,
-    LinesMutexes                                     &lines_mutex)
+// Z extents of the mesh facets and the range of layers they intersect, stored as a structure of arrays,
+// so that they are calculated by a tight loop, which the compiler is able to vectorize.
+struct FacetsZExtents
 {
-    stl_vertex vertices[3] { transform_vertex_fn(mesh_vertices[indices(0)]), transform_vertex_fn(mesh_vertices[indices(1)]), transform_vertex_fn(mesh_vertices[indices(2)]) };
+    std::vector<float>  min_z;
+    std::vector<float>  max_z;
+    // First layer whose slice_z is >= min_z.
+    std::vector<int>    min_layer;
+    // First layer whose slice_z is > max_z.
+    std::vector<int>    max_layer;
+};
 
-    // find facet extents
-    const float min_z = fminf(vertices[0].z(), fminf(vertices[1].z(), vertices[2].z()));
-    const float max_z = fmaxf(vertices[0].z(), fmaxf(vertices[1].z(), vertices[2].z()));
-    
-    // find layer extents
-    auto min_layer = std::lower_bound(zs.begin(), zs.end(), min_z); // first layer whose slice_z is >= min_z
-    auto max_layer = std::upper_bound(min_layer, zs.end(), max_z); // first layer whose slice_z is > max_z
-    int  idx_vertex_lowest = (vertices[1].z() == min_z) ? 1 : ((vertices[2].z() == min_z) ? 2 : 0);
-    
-    for (auto it = min_layer; it != max_layer; ++ it) {
-        IntersectionLine il;
-        // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
-        if (min_z != max_z && slice_facet(*it, vertices, indices, edge_ids, idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
-            assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
-            size_t slice_id = it - zs.begin();
-            boost::lock_guard<std::mutex> l(lines_mutex(slice_id));
-            lines[slice_id].emplace_back(il);
-        }
-    }
+template<typename TransformVertex>
+static FacetsZExtents facets_z_extents(
+    const std::vector<stl_vertex>                   &vertices,
+    const TransformVertex                           &transform_vertex_fn,
+    const std::vector<stl_triangle_vertex_indices>  &indices,
+    const std::vector<float>                        &zs)
+{
+    FacetsZExtents out;
+    out.min_z.assign(indices.size(), 0.f);
+    out.max_z.assign(indices.size(), 0.f);
+    out.min_layer.assign(indices.size(), 0);
+    out.max_layer.assign(indices.size(), 0);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, indices.size()),
+        [&vertices, &transform_vertex_fn, &indices, &zs, &out](const tbb::blocked_range<size_t> &range) {
+            float *min_z = out.min_z.data();
+            float *max_z = out.max_z.data();
+            for (size_t face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
+                const stl_triangle_vertex_indices &face = indices[face_idx];
+                const float z0 = transform_vertex_fn(vertices[face(0)]).z();
+                const float z1 = transform_vertex_fn(vertices[face(1)]).z();
+                const float z2 = transform_vertex_fn(vertices[face(2)]).z();
+                min_z[face_idx] = fminf(z0, fminf(z1, z2));
+                max_z[face_idx] = fmaxf(z0, fmaxf(z1, z2));
+            }
+            for (size_t face_idx = range.begin(); face_idx < range.end(); ++ face_idx)
+                // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
+                if (min_z[face_idx] != max_z[face_idx]) {
+                    auto min_layer = std::lower_bound(zs.begin(), zs.end(), min_z[face_idx]);
+                    auto max_layer = std::upper_bound(min_layer, zs.end(), max_z[face_idx]);
+                    out.min_layer[face_idx] = int(min_layer - zs.begin());
+                    out.max_layer[face_idx] = int(max_layer - zs.begin());
+                }
+        });
+    return out;
 }
 
+// Slice the mesh at zs by a sweep over the layers sorted by Z:
+// The layers are split into chunks of consecutive layers, and the facets are binned into the chunks they intersect.
+// Each chunk is then sliced by a single thread, which owns the IntersectionLines of the chunk's layers,
+// thus no locking is needed and the order of the IntersectionLines at a layer is deterministic.
+// Because the facets are short in Z compared to a chunk of layers, only a small fraction of the facets is binned into
+// more than a single chunk.
 template<typename TransformVertex, typename ThrowOnCancel>
 static inline std::vector<IntersectionLines> slice_make_lines(
     const std::vector<stl_vertex>                   &vertices,
@@ -422,17 +582,72 @@ static inline std::vector<IntersectionLines> slice_make_lines(
     const ThrowOnCancel                              throw_on_cancel_fn)
 {
     std::vector<IntersectionLines>  lines(zs.size(), IntersectionLines{});
-    LinesMutexes                    lines_mutex;
+    if (zs.empty() || indices.empty())
+        return lines;
+
+    const FacetsZExtents extents = facets_z_extents(vertices, transform_vertex_fn, indices, zs);
+    throw_on_cancel_fn();
+
+    // Several chunks per thread to balance the load, as the number of facets per layer varies wildly.
+    const size_t num_chunks_max = std::max<size_t>(1, 8 * size_t(tbb::this_task_arena::max_concurrency()));
+    const int    chunk_size     = int((zs.size() + num_chunks_max - 1) / num_chunks_max);
+    const size_t num_chunks     = (zs.size() + chunk_size - 1) / chunk_size;
+
+    // Bin facets into chunks, stored in a compressed row format, facets of each chunk sorted by their index.
+    std::vector<size_t> chunk_begin(num_chunks + 1, 0);
+    for (size_t face_idx = 0; face_idx < indices.size(); ++ face_idx)
+        if (extents.min_layer[face_idx] < extents.max_layer[face_idx])
+            for (int ichunk = extents.min_layer[face_idx] / chunk_size; ichunk <= (extents.max_layer[face_idx] - 1) / chunk_size; ++ ichunk)
+                ++ chunk_begin[ichunk + 1];
+    for (size_t ichunk = 0; ichunk < num_chunks; ++ ichunk)
+        chunk_begin[ichunk + 1] += chunk_begin[ichunk];
+    std::vector<int> chunk_facets(chunk_begin.back());
+    {
+        std::vector<size_t> chunk_end(chunk_begin.begin(), chunk_begin.end() - 1);
+        for (size_t face_idx = 0; face_idx < indices.size(); ++ face_idx)
+            if (extents.min_layer[face_idx] < extents.max_layer[face_idx])
+                for (int ichunk = extents.min_layer[face_idx] / chunk_size; ichunk <= (extents.max_layer[face_idx] - 1) / chunk_size; ++ ichunk)
+                    chunk_facets[chunk_end[ichunk] ++] = int(face_idx);
+    }
+    throw_on_cancel_fn();
+
     tbb::parallel_for(
-        tbb::blocked_range<int>(0, int(indices.size())),
-        [&vertices, &transform_vertex_fn, &indices, &face_edge_ids, &zs, &lines, &lines_mutex, throw_on_cancel_fn](const tbb::blocked_range<int> &range) {
-            for (int face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
-                if ((face_idx & 0x0ffff) == 0)
-                    throw_on_cancel_fn();
-                slice_facet_at_zs(vertices, transform_vertex_fn, indices[face_idx], face_edge_ids[face_idx], zs, lines, lines_mutex);
+        tbb::blocked_range<size_t>(0, num_chunks, 1),
+        [&vertices, &transform_vertex_fn, &indices, &face_edge_ids, &zs, &lines, &extents, &chunk_begin, &chunk_facets, chunk_size, throw_on_cancel_fn]
+        (const tbb::blocked_range<size_t> &range) {
+            std::array<std::vector<Point>, 3> edge_points;
+            for (size_t ichunk = range.begin(); ichunk < range.end(); ++ ichunk) {
+                const int layer_begin = int(ichunk) * chunk_size;
+                const int layer_end   = std::min(layer_begin + chunk_size, int(zs.size()));
+                for (size_t i = chunk_begin[ichunk]; i < chunk_begin[ichunk + 1]; ++ i) {
+                    if (((i - chunk_begin[ichunk]) & 0x0ffff) == 0)
+                        throw_on_cancel_fn();
+                    const int                          face_idx = chunk_facets[i];
+                    const stl_triangle_vertex_indices &face     = indices[face_idx];
+                    const stl_vertex facet_vertices[3] { transform_vertex_fn(vertices[face(0)]), transform_vertex_fn(vertices[face(1)]), transform_vertex_fn(vertices[face(2)]) };
+                    const float min_z             = extents.min_z[face_idx];
+                    const int   idx_vertex_lowest = (facet_vertices[1].z() == min_z) ? 1 : ((facet_vertices[2].z() == min_z) ? 2 : 0);
+                    const int   slice_begin       = std::max(layer_begin, extents.min_layer[face_idx]);
+                    const int   slice_end         = std::min(layer_end, extents.max_layer[face_idx]);
+                    if (slice_end - slice_begin >= 4) {
+                        // A facet spanning many layers, slice it edge by edge.
+                        slice_facet_with_planes(facet_vertices, face, face_edge_ids[face_idx], idx_vertex_lowest, zs.data() + slice_begin, slice_end - slice_begin, edge_points,
+                            [&lines, slice_begin](int i, const IntersectionLine &il) {
+                                assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
+                                lines[slice_begin + i].emplace_back(il);
+                            });
+                        continue;
+                    }
+                    for (int slice_id = slice_begin; slice_id < slice_end; ++ slice_id) {
+                        IntersectionLine il;
+                        if (slice_facet(zs[slice_id], facet_vertices, face, face_edge_ids[face_idx], idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
+                            assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
+                            lines[slice_id].emplace_back(il);
+                        }
+                    }
+                }
             }
-        }
-    );
+        });
     return lines;
 }
 
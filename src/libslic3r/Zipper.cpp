@@ -107,6 +107,51 @@ void Zipper::add_entry(const std::string &name, const void *data, size_t l)
     m_data.clear();
 }
 
+Zipper::CompressedEntry Zipper::compress_entry(const void *data, size_t l) const
+{
+    CompressedEntry out;
+    out.uncompressed_size = l;
+    out.crc = mz_uint32(mz_crc32(MZ_CRC32_INIT, static_cast<const mz_uint8*>(data), l));
+
+    int level = MZ_NO_COMPRESSION;
+    switch (m_compression) {
+    case NO_COMPRESSION: level = MZ_NO_COMPRESSION; break;
+    case FAST_COMPRESSION: level = MZ_BEST_SPEED; break;
+    case TIGHT_COMPRESSION: level = MZ_BEST_COMPRESSION; break;
+    }
+
+    // Entries of up to 3 bytes are stored by miniz uncompressed.
+    if (level != MZ_NO_COMPRESSION && l > 3) {
+        // Raw deflate stream without the zlib header, as stored in a ZIP file.
+        size_t deflated_size = 0;
+        void  *deflated = tdefl_compress_mem_to_heap(data, l, &deflated_size,
+            int(tdefl_create_comp_flags_from_zip_params(level, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY)));
+        if (deflated == nullptr)
+            throw Slic3r::ExportError(_u8L("Error with ZIP archive") + " " + m_impl->m_zipname + ": " + "compression failed");
+        out.data.assign(static_cast<const char*>(deflated), deflated_size);
+        out.deflated = true;
+        mz_free(deflated);
+    } else
+        out.data.assign(static_cast<const char*>(data), l);
+
+    return out;
+}
+
+void Zipper::add_entry(const std::string &name, const CompressedEntry &entry)
+{
+    if(!m_impl->is_alive()) return;
+
+    finish_entry();
+    if(!(entry.deflated ?
+            mz_zip_writer_add_mem_ex(&m_impl->arch, name.c_str(), entry.data.data(), entry.data.size(), nullptr, 0,
+                                     MZ_BEST_SPEED | MZ_ZIP_FLAG_COMPRESSED_DATA, entry.uncompressed_size, entry.crc) :
+            mz_zip_writer_add_mem(&m_impl->arch, name.c_str(), entry.data.data(), entry.data.size(), MZ_NO_COMPRESSION)))
+        m_impl->blow_up();
+
+    m_entry.clear();
+    m_data.clear();
+}
+
 void Zipper::finish_entry()
 {
     if(!m_impl->is_alive()) return;
@@ -51,6 +51,24 @@ public:
     /// This method throws exactly like finish_entry() does.
     void add_entry(const std::string& name, const void* data, size_t bytes);
 
+    /// Data of an entry compressed in advance by compress_entry().
+    struct CompressedEntry {
+        std::string   data;
+        size_t        uncompressed_size { 0 };
+        std::uint32_t crc { 0 };
+        // False if the data are stored uncompressed.
+        bool          deflated { false };
+    };
+
+    /// Compress data for add_entry(name, CompressedEntry) with the compression
+    /// level of the archive. Does not access the archive, thus multiple entries
+    /// may be compressed in parallel while the archive is being written.
+    CompressedEntry compress_entry(const void* data, size_t bytes) const;
+
+    /// Add a new binary file entry compressed by compress_entry().
+    /// This method throws exactly like finish_entry() does.
+    void add_entry(const std::string& name, const CompressedEntry& entry);
+
     // Writing data to the archive works like with standard streams. The target
     // within the zip file is the entry created with the add_entry method.
 
@@ -417,6 +417,9 @@ bool BackgroundSlicingProcess::start()
 		throw Slic3r::RuntimeError("Cannot start a background task, the worker thread is not idle.");
 	m_state = STATE_STARTED;
 	m_print->set_cancel_callback([this](){ this->stop_internal(); });
+	if (m_print == m_fff_print)
+		// Set from the UI thread, as the preview checks it before reading the layers, see Preview::load_print_as_fff().
+		m_fff_print->set_low_memory_mode(GUI::wxGetApp().app_config->get_bool("low_memory"));
 	lck.unlock();
 	m_condition.notify_one();
 	return true;
@@ -8,6 +8,7 @@
 #include "libslic3r/Utils.hpp"
 #include "libslic3r/LocalesUtils.hpp"
 #include "libslic3r/PresetBundle.hpp"
+#include "libslic3r/GCode/ToolpathLayers.hpp"
 
 #include "slic3r/GUI/format.hpp"
 
@@ -836,7 +837,7 @@ void GCodeViewer::refresh(const GCodeProcessorResult& gcode_result, const std::v
         if (i == 0)
             continue;
 
-        const GCodeProcessorResult::MoveVertex& curr = gcode_result.moves[i];
+        const GCodeProcessorResult::MoveVertex curr = gcode_result.moves[i];
 
         switch (curr.type)
         {
@@ -1539,7 +1540,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
     auto start_time = std::chrono::high_resolution_clock::now();
-    m_statistics.results_size = SLIC3R_STDVEC_MEMSIZE(gcode_result.moves, GCodeProcessorResult::MoveVertex);
+    m_statistics.results_size = gcode_result.moves.memory_size();
     m_statistics.results_time = gcode_result.time;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
@@ -1558,13 +1559,14 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
     wxBusyCursor busy;
 
     // extract approximate paths bounding box from result
-    for (const GCodeProcessorResult::MoveVertex& move : gcode_result.moves) {
+    const GCodeProcessorResult::Moves& moves = gcode_result.moves;
+    for (size_t i = 0; i < m_moves_count; ++i) {
         if (wxGetApp().is_gcode_viewer())
             // for the gcode viewer we need to take in account all moves to correctly size the printbed
-            m_paths_bounding_box.merge(move.position.cast<double>());
+            m_paths_bounding_box.merge(moves.position(i).cast<double>());
         else {
-            if (move.type == EMoveType::Extrude && move.extrusion_role != GCodeExtrusionRole::Custom && move.width != 0.0f && move.height != 0.0f)
-                m_paths_bounding_box.merge(move.position.cast<double>());
+            if (moves.type(i) == EMoveType::Extrude && moves.extrusion_role(i) != GCodeExtrusionRole::Custom && moves.width(i) != 0.0f && moves.height(i) != 0.0f)
+                m_paths_bounding_box.merge(moves.position(i).cast<double>());
         }
     }
 
@@ -1578,10 +1580,9 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
     m_cog.reset();
 
     m_sequential_view.gcode_ids.clear();
-    for (size_t i = 0; i < gcode_result.moves.size(); ++i) {
-        const GCodeProcessorResult::MoveVertex& move = gcode_result.moves[i];
-        if (move.type != EMoveType::Seam)
-            m_sequential_view.gcode_ids.push_back(move.gcode_id);
+    for (size_t i = 0; i < m_moves_count; ++i) {
+        if (moves.type(i) != EMoveType::Seam)
+            m_sequential_view.gcode_ids.push_back(moves.gcode_id(i));
     }
 
     bool account_for_volumetric_rate = m_view_type == EViewType::VolumetricRate;
@@ -1597,7 +1598,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
 
     // toolpaths data -> extract vertices from result
     for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessorResult::MoveVertex& curr = gcode_result.moves[i];
+        const GCodeProcessorResult::MoveVertex curr = gcode_result.moves[i];
         if (curr.type == EMoveType::Seam)
             biased_seams_ids.push_back(i - biased_seams_ids.size() - 1);
 
@@ -1607,7 +1608,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         if (i == 0)
             continue;
 
-        const GCodeProcessorResult::MoveVertex& prev = gcode_result.moves[i - 1];
+        const GCodeProcessorResult::MoveVertex prev = gcode_result.moves[i - 1];
 
         if (curr.type == EMoveType::Extrude &&
             curr.extrusion_role != GCodeExtrusionRole::Skirt &&
@@ -1786,9 +1787,9 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
             for (size_t j = 1; j < path_vertices_count - 1; ++j) {
                 const size_t curr_s_id = path.sub_paths.front().first.s_id + j;
                 const size_t move_id = extract_move_id(curr_s_id);
-                const Vec3f& prev = gcode_result.moves[move_id - 1].position;
-                const Vec3f& curr = gcode_result.moves[move_id].position;
-                const Vec3f& next = gcode_result.moves[move_id + 1].position;
+                const Vec3f& prev = gcode_result.moves.position(move_id - 1);
+                const Vec3f& curr = gcode_result.moves.position(move_id);
+                const Vec3f& next = gcode_result.moves.position(move_id + 1);
 
                 // select the subpaths which contains the previous/next segments
                 if (!path.sub_paths[prev_sub_path_id].contains(curr_s_id))
@@ -1966,7 +1967,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
     size_t seams_count = 0;
 
     for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessorResult::MoveVertex& curr = gcode_result.moves[i];
+        const GCodeProcessorResult::MoveVertex curr = gcode_result.moves[i];
         if (curr.type == EMoveType::Seam)
             ++seams_count;
 
@@ -1976,10 +1977,13 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
         if (i == 0)
             continue;
 
-        const GCodeProcessorResult::MoveVertex& prev = gcode_result.moves[i - 1];
+        const GCodeProcessorResult::MoveVertex prev = gcode_result.moves[i - 1];
+        GCodeProcessorResult::MoveVertex next_move;
         const GCodeProcessorResult::MoveVertex* next = nullptr;
-        if (i < m_moves_count - 1)
-            next = &gcode_result.moves[i + 1];
+        if (i < m_moves_count - 1) {
+            next_move = gcode_result.moves[i + 1];
+            next = &next_move;
+        }
 
         ++progress_count;
         if (progress_dialog != nullptr && progress_count % progress_threshold == 0) {
@@ -2148,41 +2152,20 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
     // dismiss indices data, no more needed
     std::vector<MultiIndexBuffer>().swap(indices);
 
-    // layers zs / roles / extruder ids -> extract from result
-    size_t last_travel_s_id = 0;
-    size_t first_travel_s_id = 0;
-    seams_count = 0;
-    for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessorResult::MoveVertex& move = gcode_result.moves[i];
-        if (move.type == EMoveType::Seam)
-            ++seams_count;
-
-        size_t move_id = i - seams_count;
+    // layers zs
+    const ToolpathLayers layers = toolpath_layers(gcode_result);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        m_layers.append(layers.zs[i], { layers.ranges[i].first, layers.ranges[i].last });
+    }
 
-        if (move.type == EMoveType::Extrude) {
-            if (!move.internal_only) {
-                // layers zs
-                const double* const last_z = m_layers.empty() ? nullptr : &m_layers.get_zs().back();
-                const double z = static_cast<double>(move.position.z());
-                if (last_z == nullptr || z < *last_z - EPSILON || *last_z + EPSILON < z) {
-                    const size_t start_it = (m_layers.empty() && first_travel_s_id != 0) ? first_travel_s_id : last_travel_s_id;
-                    m_layers.append(z, { start_it, move_id });
-                }
-                else
-                    m_layers.get_ranges().back().last = move_id;
-            }
+    // roles / extruder ids -> extract from result
+    for (size_t i = 0; i < m_moves_count; ++i) {
+        if (moves.type(i) == EMoveType::Extrude) {
             // extruder ids
-            m_extruder_ids.emplace_back(move.extruder_id);
+            m_extruder_ids.emplace_back(moves.extruder_id(i));
             // roles
             if (i > 0)
-                m_roles.emplace_back(move.extrusion_role);
-        }
-        else if (move.type == EMoveType::Travel) {
-            if (move_id - last_travel_s_id > 1 && !m_layers.empty())
-                m_layers.get_ranges().back().last = move_id;
-            else if (m_layers.empty() && first_travel_s_id == 0)
-                first_travel_s_id = move_id;
-            last_travel_s_id = move_id;
+                m_roles.emplace_back(moves.extrusion_role(i));
         }
     }
 
@@ -2194,14 +2177,6 @@ void GCodeViewer::load_toolpaths(const GCodeProcessorResult& gcode_result)
     sort_remove_duplicates(m_extruder_ids);
     m_extruder_ids.shrink_to_fit();
 
-    // replace layers for spiral vase mode
-    if (!gcode_result.spiral_vase_layers.empty()) {
-        m_layers.reset();
-        for (const auto& layer : gcode_result.spiral_vase_layers) {
-            m_layers.append(layer.first, { layer.second.first, layer.second.second });
-        }
-    }
-
     // set layers z range
     if (!m_layers.empty())
         m_layers_z_range = { 0, static_cast<unsigned int>(m_layers.size() - 1) };
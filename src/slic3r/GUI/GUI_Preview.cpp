@@ -813,8 +813,9 @@ void Preview::load_print_as_fff(bool keep_z_range)
                 m_left_sizer->Show(m_bottom_toolbar_panel);
             m_loaded = true;
         }
-        else if (wxGetApp().is_editor()) {
+        else if (wxGetApp().is_editor() && ! print->low_memory_mode()) {
             // Load the initial preview based on slices, not the final G-code.
+            // In low memory mode the layers are being released by the G-code export running in the background.
             m_canvas->load_preview(colors, color_print_values);
             m_left_sizer->Hide(m_bottom_toolbar_panel);
             m_left_sizer->Layout();
@@ -259,6 +259,13 @@ void PreferencesDialog::build()
 				"Examples of such issues are floating object parts, unsupported extrusions and low bed adhesion."),
 			app_config->get_bool("alert_when_supports_needed"));
 
+		append_bool_option(m_optgroup_general, "low_memory", 
+			L("Low memory mode"),
+			L("If this is enabled, the slices and extrusions of each layer are released as soon as its G-code is generated. "
+				"The preview of the sliced layers is not shown before the G-code is generated, and the objects "
+				"have to be sliced again after any change or when the G-code is exported again."),
+			app_config->get_bool("low_memory"));
+
 
 		m_optgroup_general->append_separator();
 
@@ -1,9 +1,45 @@
 #include <catch2/catch.hpp>
 
+#include "libslic3r/GCodeReader.hpp"
+
 #include "test_data.hpp"
 
 using namespace Slic3r;
 
+// Print two copies of a mesh either as two instances of a single object or as two objects.
+static std::string slice_two_copies(Test::TestMesh test_mesh, bool separate_objects, const DynamicPrintConfig &config)
+{
+    Model model;
+    ModelObject *object = nullptr;
+    for (const Vec3d &offset : { Vec3d(75., 100., 0.), Vec3d(125., 100., 0.) }) {
+        if (object == nullptr || separate_objects) {
+            object = model.add_object();
+            object->name = "object.stl";
+            object->add_volume(Test::mesh(test_mesh));
+        }
+        object->add_instance()->set_offset(offset);
+    }
+    Print print;
+    for (ModelObject *mo : model.objects) {
+        mo->ensure_on_bed();
+        print.auto_assign_extruders(mo);
+    }
+    print.apply(model, config);
+    print.validate();
+    return Test::gcode(print);
+}
+
+static std::vector<std::string> travel_moves(const std::string &gcode)
+{
+    std::vector<std::string> out;
+    GCodeReader parser;
+    parser.parse_buffer(gcode, [&out](GCodeReader &, const GCodeReader::GCodeLine &line) {
+        if (line.travel() && (line.has_x() || line.has_y()))
+            out.emplace_back(line.raw());
+    });
+    return out;
+}
+
 SCENARIO("Avoid crossing perimeters", "[AvoidCrossingPerimeters]") {
 	WHEN("Two 20mm cubes sliced") {
         std::string gcode = Slic3r::Test::slice(
@@ -13,4 +49,26 @@ SCENARIO("Avoid crossing perimeters", "[AvoidCrossingPerimeters]") {
             REQUIRE(! gcode.empty());
         }
     }
+    WHEN("Two 20mm cubes with a skirt sliced in sequential mode") {
+        std::string gcode = Slic3r::Test::slice(
+    	    { Slic3r::Test::TestMesh::cube_20x20x20, Slic3r::Test::TestMesh::cube_20x20x20 },
+            { { "avoid_crossing_perimeters", true }, { "complete_objects", true }, { "skirts", 1 } });
+        THEN("gcode not empty") {
+            REQUIRE(! gcode.empty());
+        }
+    }
+    WHEN("Two instances of an object with a hole are sliced") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config_with({ { "avoid_crossing_perimeters", true } });
+        std::vector<std::string> travels_instances = travel_moves(slice_two_copies(Test::TestMesh::cube_with_hole, false, config));
+        THEN("the travels are the same as if the copies were separate objects") {
+            // The boundaries of a layer are reused for the second instance, while they are built again for the second object.
+            std::vector<std::string> travels_objects = travel_moves(slice_two_copies(Test::TestMesh::cube_with_hole, true, config));
+            REQUIRE(! travels_instances.empty());
+            REQUIRE(travels_instances == travels_objects);
+        }
+        THEN("the travels differ from the travels without avoid crossing perimeters") {
+            config.set_deserialize_strict("avoid_crossing_perimeters", "0");
+            REQUIRE(travels_instances != travel_moves(slice_two_copies(Test::TestMesh::cube_with_hole, false, config)));
+        }
+    }
 }
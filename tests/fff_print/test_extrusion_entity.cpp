@@ -407,3 +407,41 @@ TEST_CASE("ExtrusionEntityCollection: Chained path with no explicit starting poi
     auto chained   = chain_polylines(polylines);
     REQUIRE(chained == target);
 }
+
+TEST_CASE("ExtrusionEntityArena: Entities of a layer share blocks", "[ExtrusionEntity]") {
+    const size_t num_blocks_alive     = ExtrusionEntityArena::num_blocks_alive();
+    const size_t num_blocks_allocated = ExtrusionEntityArena::num_blocks_allocated();
+    ExtrusionEntityCollection layer;
+    ExtrusionEntity *outliving = nullptr;
+    {
+        ExtrusionEntityArena arena;
+        for (size_t i = 0; i < 1000; ++ i)
+            layer.entities.emplace_back(new ExtrusionPath(random_path()));
+        outliving = layer.entities.back()->clone();
+        // Nested arena, e.g. a worker thread picking up another layer while waiting for a nested parallel loop.
+        {
+            ExtrusionEntityArena nested;
+            delete new ExtrusionPath(ExtrusionRole::Perimeter);
+        }
+        layer.append(ExtrusionPath(ExtrusionRole::Perimeter));
+    }
+    // Hundreds of paths per block.
+    const size_t num_blocks = ExtrusionEntityArena::num_blocks_allocated() - num_blocks_allocated;
+    REQUIRE(num_blocks > 1);
+    REQUIRE(num_blocks < 1000 / 100);
+    // The nested arena returned its block once its only entity was deleted.
+    REQUIRE(ExtrusionEntityArena::num_blocks_alive() == num_blocks_alive + num_blocks - 1);
+    THEN("Entities outside of an arena come from the heap") {
+        ExtrusionPath *path = new ExtrusionPath(ExtrusionRole::Perimeter);
+        REQUIRE(ExtrusionEntityArena::num_blocks_allocated() == num_blocks_allocated + num_blocks);
+        delete path;
+    }
+    THEN("The blocks are released with the last entity placed into them") {
+        ExtrusionEntityCollection copy = layer;
+        layer.clear();
+        REQUIRE(ExtrusionEntityArena::num_blocks_alive() == num_blocks_alive + 1);
+        delete outliving;
+        REQUIRE(ExtrusionEntityArena::num_blocks_alive() == num_blocks_alive);
+        REQUIRE(copy.entities.size() == 1001);
+    }
+}
@@ -3,6 +3,10 @@
 #include <memory>
 
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCodeReader.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/nowide/cstdio.hpp>
 
 using namespace Slic3r;
 
@@ -20,3 +24,53 @@ SCENARIO("Origin manipulation", "[GCode]") {
     	}
     }
 }
+
+SCENARIO("GCodeReader parses a file the same way as a buffer", "[GCode]") {
+    GIVEN("A G-code spanning multiple blocks read from the file, with mixed line ends") {
+        std::string gcode;
+        for (int i = 0; i < 200000; ++ i) {
+            gcode += "G1 X" + std::to_string(i % 200) + ".123 Y" + std::to_string(i % 170) + " E0.0" + std::to_string(i % 7);
+            gcode += (i % 3 == 0) ? " ; comment\n" : (i % 3 == 1) ? "\r\n" : "\n";
+            if (i % 1000 == 0)
+                gcode += "\nG92 E0\n";
+        }
+        // Last line without a line end.
+        gcode += "G1 Z5";
+        boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.gcode");
+        {
+            FILE *f = boost::nowide::fopen(path.string().c_str(), "wb");
+            REQUIRE(f != nullptr);
+            ::fwrite(gcode.data(), 1, gcode.size(), f);
+            ::fclose(f);
+        }
+        WHEN("The file is parsed") {
+            struct ParsedLine {
+                std::string raw;
+                float       x, y, e;
+                bool operator==(const ParsedLine &rhs) const { return raw == rhs.raw && x == rhs.x && y == rhs.y && e == rhs.e; }
+            };
+            auto collect = [](std::vector<ParsedLine> &out) {
+                return [&out](GCodeReader &reader, const GCodeReader::GCodeLine &line) { out.push_back({ line.raw(), reader.x(), reader.y(), reader.e() }); };
+            };
+            std::vector<ParsedLine> from_buffer;
+            GCodeReader().parse_buffer(gcode, collect(from_buffer));
+            std::vector<ParsedLine> from_file;
+            std::vector<size_t>     lines_ends;
+            bool                    result = GCodeReader().parse_file(path.string(), collect(from_file), lines_ends);
+            boost::nowide::remove(path.string().c_str());
+            THEN("The lines and the positions are the same") {
+                REQUIRE(result);
+                REQUIRE(from_file.size() == from_buffer.size());
+                REQUIRE(from_file == from_buffer);
+                REQUIRE(from_file.back().raw == "G1 Z5");
+            }
+            THEN("Line ends point past all the newlines") {
+                std::vector<size_t> expected;
+                for (size_t i = 0; i < gcode.size(); ++ i)
+                    if (gcode[i] == '\n')
+                        expected.emplace_back(i + 1);
+                REQUIRE(lines_ends == expected);
+            }
+        }
+    }
+}
@@ -94,3 +94,30 @@ SCENARIO("set_speed emits values with fixed-point output.", "[GCodeWriter]") {
         }
     }
 }
+
+SCENARIO("GCodeWriter appends the same G-code as it returns.", "[GCodeWriter]") {
+
+    GIVEN("Two GCodeWriter instances with a single extruder") {
+        GCodeWriter writer_returning;
+        GCodeWriter writer_appending;
+        for (GCodeWriter *writer : { &writer_returning, &writer_appending }) {
+            writer->set_extruders({ 0 });
+            writer->set_extruder(0);
+        }
+        WHEN("a speed, a travel and extrusions are emitted into a non-empty buffer") {
+            std::string returned = ";start\n";
+            returned += writer_returning.set_speed(1200., "", ";_EXTRUDE_SET_SPEED");
+            returned += writer_returning.travel_to_xy({ 10., 20. }, "travel");
+            returned += writer_returning.extrude_to_xy({ 15., 20. }, 0.25);
+            returned += writer_returning.extrude_to_xy({ 15., 25.5 }, 0.125, "perimeter");
+            std::string appended = ";start\n";
+            writer_appending.set_speed(appended, 1200., "", ";_EXTRUDE_SET_SPEED");
+            writer_appending.travel_to_xy(appended, { 10., 20. }, "travel");
+            writer_appending.extrude_to_xy(appended, { 15., 20. }, 0.25);
+            writer_appending.extrude_to_xy(appended, { 15., 25.5 }, 0.125, "perimeter");
+            THEN("the G-code is equal") {
+                REQUIRE_THAT(appended, Catch::Equals(returned));
+            }
+        }
+    }
+}
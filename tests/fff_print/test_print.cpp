@@ -6,6 +6,8 @@
 
 #include "test_data.hpp"
 
+#include <boost/filesystem/operations.hpp>
+
 using namespace Slic3r;
 using namespace Slic3r::Test;
 
@@ -185,3 +187,84 @@ SCENARIO("Ported from Perl", "[Print]") {
         }
     }
 }
+
+SCENARIO("Print: Low memory mode produces the same G-code", "[Print]") {
+    // Drop the first line, which contains the time stamp.
+    auto strip_header = [](const std::string &gcode) { return gcode.substr(gcode.find('\n') + 1); };
+    for (bool complete_objects : { false, true }) {
+        const std::string description = complete_objects ? "Three objects printed sequentially" : "Three objects printed layer by layer";
+        GIVEN(description) {
+            Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+            // AvoidCrossingPerimeters reads the layers of the other objects and the layers below the support layers.
+            config.set_deserialize_strict({
+                { "support_material",          true },
+                { "avoid_crossing_perimeters", true },
+                { "complete_objects",          complete_objects },
+                { "duplicate_distance",        30 }
+            });
+            const std::initializer_list<TestMesh> meshes { TestMesh::cube_20x20x20, TestMesh::overhang, TestMesh::cube_with_hole };
+            Slic3r::Print print, print_low_memory;
+            Slic3r::Model model, model_low_memory;
+            Slic3r::Test::init_print(meshes, print, model, config);
+            Slic3r::Test::init_print(meshes, print_low_memory, model_low_memory, config);
+            print_low_memory.set_low_memory_mode(true);
+            WHEN("G-code is exported") {
+                std::string gcode            = Slic3r::Test::gcode(print);
+                std::string gcode_low_memory = Slic3r::Test::gcode(print_low_memory);
+                THEN("G-code is the same") {
+                    REQUIRE(strip_header(gcode) == strip_header(gcode_low_memory));
+                }
+                THEN("Layers are released and the slicing result is invalidated") {
+                    for (const PrintObject *object : print_low_memory.objects()) {
+                        REQUIRE(! object->is_step_done(posSlice));
+                        for (const Layer *layer : object->layers()) {
+                            REQUIRE(! layer->has_extrusions());
+                            // Sequential print keeps lslices for AvoidCrossingPerimeters of the objects printed later.
+                            if (! complete_objects)
+                                REQUIRE(layer->lslices.empty());
+                        }
+                        for (const SupportLayer *layer : object->support_layers())
+                            REQUIRE(! layer->has_extrusions());
+                    }
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Slice cache", "[Print]") {
+    GIVEN("20mm cube and an empty slice cache directory") {
+        const boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        auto strip_header = [](const std::string &gcode) { return gcode.substr(gcode.find('\n') + 1); };
+        auto slice = [&cache_dir](double xy_size_compensation) {
+            Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+            config.set_deserialize_strict({ { "xy_size_compensation", xy_size_compensation } });
+            Slic3r::Print print;
+            Slic3r::Model model;
+            print.set_slice_cache_dir(cache_dir.string());
+            Slic3r::Test::init_print({ TestMesh::cube_20x20x20 }, print, model, config);
+            return Slic3r::Test::gcode(print);
+        };
+        auto num_cache_entries = [&cache_dir]() {
+            return std::distance(boost::filesystem::directory_iterator(cache_dir), boost::filesystem::directory_iterator());
+        };
+        WHEN("The cube is sliced twice with the same config") {
+            std::string gcode1 = slice(0.);
+            std::string gcode2 = slice(0.);
+            THEN("A single cache entry is created") {
+                REQUIRE(num_cache_entries() == 1);
+            }
+            THEN("G-code generated from the cached slices is the same") {
+                REQUIRE(strip_header(gcode1) == strip_header(gcode2));
+            }
+        }
+        WHEN("The cube is sliced with a different XY size compensation") {
+            slice(0.);
+            slice(-0.1);
+            THEN("Another cache entry is created") {
+                REQUIRE(num_cache_entries() == 2);
+            }
+        }
+        boost::filesystem::remove_all(cache_dir);
+    }
+}
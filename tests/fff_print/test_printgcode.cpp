@@ -1,6 +1,7 @@
 #include <catch2/catch.hpp>
 
 #include "libslic3r/libslic3r.h"
+#include "libslic3r/GCode.hpp"
 #include "libslic3r/GCodeReader.hpp"
 
 #include "test_data.hpp"
@@ -269,3 +270,102 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
         }
     }
 }
+
+// Strip the time stamp of the G-code export.
+static std::string strip_generated_by(const std::string &gcode)
+{
+    return boost::regex_replace(gcode, boost::regex("; generated by [^\n]*\n"), "");
+}
+
+SCENARIO("PrintGCode reuses the layers of the last export", "[PrintGCode]") {
+    GIVEN("A print exported once") {
+        auto config = Slic3r::DynamicPrintConfig::full_print_config_with({
+            { "gcode_comments",  true },
+            { "layer_gcode",     ";LAYER [layer_num]" },
+            { "end_gcode",       ";END 1 [layer_num] {max_fan_speed[0]}" },
+            { "max_fan_speed",   100 }
+        });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ TestMesh::cube_20x20x20 }, print, model, config);
+        std::string gcode_first = Slic3r::Test::gcode(print);
+        auto num_reused = [&print]() { return print.gcode_layers_cache() ? print.gcode_layers_cache()->num_reused : 0; };
+        REQUIRE(print.gcode_layers_cache() != nullptr);
+        REQUIRE(num_reused() == 0);
+        auto export_again = [&print, &model](const DynamicPrintConfig &config) {
+            print.apply(model, config);
+            return Slic3r::Test::gcode(print);
+        };
+        auto export_from_scratch = [](const DynamicPrintConfig &config) {
+            Slic3r::Print print;
+            Slic3r::Model model;
+            Slic3r::Test::init_print({ TestMesh::cube_20x20x20 }, print, model, config);
+            return Slic3r::Test::gcode(print);
+        };
+        WHEN("the end G-code is changed") {
+            config.set_deserialize_strict("end_gcode", ";END 2 [layer_num]");
+            std::string gcode = export_again(config);
+            THEN("the layers of the last export are reused") {
+                REQUIRE(num_reused() == 1);
+            }
+            THEN("the new end G-code is emitted") {
+                REQUIRE(gcode.find(";END 1 ") == std::string::npos);
+                REQUIRE(gcode.find(";END 2 ") != std::string::npos);
+            }
+            THEN("the G-code matches the G-code generated from scratch") {
+                REQUIRE(strip_generated_by(gcode) == strip_generated_by(export_from_scratch(config)));
+            }
+        }
+        WHEN("the fan settings are changed") {
+            config.set_deserialize_strict("max_fan_speed", "50");
+            std::string gcode = export_again(config);
+            THEN("the layers of the last export are reused") {
+                REQUIRE(num_reused() == 1);
+            }
+            THEN("the end G-code is expanded with the current configuration") {
+                REQUIRE(boost::regex_search(gcode, boost::regex(";END 1 [0-9]+ 50\n")));
+            }
+            THEN("the G-code matches the G-code generated from scratch") {
+                REQUIRE(strip_generated_by(gcode) != strip_generated_by(gcode_first));
+                REQUIRE(strip_generated_by(gcode) == strip_generated_by(export_from_scratch(config)));
+            }
+        }
+        WHEN("the layer G-code is changed") {
+            config.set_deserialize_strict("layer_gcode", ";NEW LAYER [layer_num]");
+            std::string gcode = export_again(config);
+            THEN("the layers are generated again") {
+                REQUIRE(num_reused() == 0);
+                REQUIRE(gcode.find(";LAYER ") == std::string::npos);
+                REQUIRE(gcode.find(";NEW LAYER ") != std::string::npos);
+            }
+        }
+    }
+}
+
+SCENARIO("PrintGCode does not reuse the layers if the end filament G-code changes", "[PrintGCode]") {
+    GIVEN("A print with a tool change at each layer exported once") {
+        auto config = Slic3r::DynamicPrintConfig::full_print_config_with({
+            { "nozzle_diameter",    { 0.4, 0.4 } },
+            { "infill_extruder",    2 },
+            { "end_filament_gcode", "M117 END FILAMENT 1" }
+        });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ TestMesh::cube_20x20x20 }, print, model, config);
+        std::string gcode_first = Slic3r::Test::gcode(print);
+        REQUIRE(gcode_first.find("M117 END FILAMENT 1") != std::string::npos);
+        WHEN("the end filament G-code is changed") {
+            config.set_deserialize_strict("end_filament_gcode", "M117 END FILAMENT 2");
+            print.apply(model, config);
+            std::string gcode = Slic3r::Test::gcode(print);
+            THEN("the layers are generated again") {
+                REQUIRE(print.gcode_layers_cache() != nullptr);
+                REQUIRE(print.gcode_layers_cache()->num_reused == 0);
+            }
+            THEN("only the new end filament G-code is emitted") {
+                REQUIRE(gcode.find("M117 END FILAMENT 1") == std::string::npos);
+                REQUIRE(gcode.find("M117 END FILAMENT 2") != std::string::npos);
+            }
+        }
+    }
+}
@@ -11,6 +11,9 @@
 #include <future>
 #include <chrono>
 
+#include <boost/filesystem/operations.hpp>
+#include <boost/nowide/cstdio.hpp>
+
 //#include "test_options.hpp"
 #include "test_data.hpp"
 
@@ -175,6 +178,49 @@ SCENARIO( "TriangleMesh: slice behavior.") {
             }
         }
     }
+    GIVEN( "A sphere of 20mm radius") {
+        indexed_triangle_set sphere = its_make_sphere(20., PI / 90.);
+        WHEN("It is sliced at 1000 layers at once and at each layer separately") {
+            std::vector<float> zs;
+            for (int i = 0; i < 1000; ++ i)
+                zs.emplace_back(-20.f + 0.04f * (float(i) + 0.5f));
+            std::vector<Polygons> layers = slice_mesh(sphere, zs, MeshSlicingParams{});
+            THEN("The slices are the same") {
+                REQUIRE(layers.size() == zs.size());
+                for (size_t i = 0; i < zs.size(); ++ i) {
+                    Polygons layer = slice_mesh(sphere, zs[i], MeshSlicingParams{});
+                    REQUIRE(layers[i].size() == 1);
+                    REQUIRE(layer.size() == 1);
+                    REQUIRE(layers[i].front().points.size() == layer.front().points.size());
+                    REQUIRE(layers[i].front().area() == Approx(layer.front().area()));
+                }
+            }
+        }
+    }
+    GIVEN( "A coarse sphere of 20mm radius") {
+        // The facets span many layers, thus they are sliced edge by edge over ranges of layers (vectorized if available),
+        // while slicing a single layer at a time goes through slice_facet().
+        indexed_triangle_set sphere = its_make_sphere(20., PI / 30.);
+        MeshSlicingParams    params;
+        std::vector<float>   zs;
+        for (int i = 0; i < 400; ++ i)
+            zs.emplace_back(-20.f + 0.1f * (float(i) + 0.5f));
+        WHEN("It is sliced at 400 layers and at planes passing through its vertices") {
+            // Add planes passing exactly through the vertices of some of the sphere rings.
+            for (size_t i = 0; i < sphere.vertices.size(); i += 97)
+                zs.emplace_back(sphere.vertices[i].z());
+            sort_remove_duplicates(zs);
+            std::vector<Polygons> layers = slice_mesh(sphere, zs, params);
+            THEN("The slices are identical to the slices made one layer at a time") {
+                REQUIRE(layers.size() == zs.size());
+                for (size_t i = 0; i < zs.size(); ++ i) {
+                    // Slice a single layer with the same vertex transformation, adding a plane above the mesh.
+                    std::vector<Polygons> layer = slice_mesh(sphere, { zs[i], 1000.f }, params);
+                    REQUIRE(layer.front() == layers[i]);
+                }
+            }
+        }
+    }
 }
 
 SCENARIO( "make_xxx functions produce meshes.") {
@@ -307,6 +353,78 @@ SCENARIO( "TriangleMeshSlicer: Cut behavior.") {
         }
     }
 }
+SCENARIO( "TriangleMesh: Loading of binary STL files.") {
+    GIVEN( "A sphere and a cube with a missing face, both stored into binary STL files") {
+        indexed_triangle_set sphere = its_make_sphere(10., PI / 60.);
+        indexed_triangle_set open_cube = make_cube().its;
+        open_cube.indices.pop_back();
+        boost::filesystem::path sphere_path    = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.stl");
+        boost::filesystem::path open_cube_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.stl");
+        REQUIRE(its_write_stl_binary(sphere_path.string().c_str(), "sphere", sphere));
+        REQUIRE(its_write_stl_binary(open_cube_path.string().c_str(), "open cube", open_cube));
+        WHEN( "The STL files are loaded by the memory mapped loader") {
+            indexed_triangle_set sphere_loaded;
+            REQUIRE(its_read_stl_binary(sphere_path.string().c_str(), sphere_loaded));
+            THEN( "The vertices are merged to the same mesh as stored") {
+                REQUIRE(sphere_loaded.indices.size() == sphere.indices.size());
+                REQUIRE(sphere_loaded.vertices.size() == sphere.vertices.size());
+                REQUIRE(its_num_open_edges(sphere_loaded) == 0);
+                REQUIRE(its_volume(sphere_loaded) == Approx(its_volume(sphere)));
+            }
+        }
+        WHEN( "The STL files are loaded into TriangleMesh") {
+            TriangleMesh sphere_mesh, open_cube_mesh;
+            REQUIRE(sphere_mesh.ReadSTLFile(sphere_path.string().c_str()));
+            REQUIRE(open_cube_mesh.ReadSTLFile(open_cube_path.string().c_str()));
+            THEN( "The closed sphere is loaded without repairs") {
+                REQUIRE(sphere_mesh.facets_count() == sphere.indices.size());
+                REQUIRE(sphere_mesh.stats().number_of_parts == 1);
+                REQUIRE(sphere_mesh.stats().open_edges == 0);
+                REQUIRE(sphere_mesh.stats().repaired_errors.edges_fixed == 0);
+                REQUIRE(sphere_mesh.stats().volume == Approx(its_volume(sphere)));
+            }
+            THEN( "The open cube is repaired") {
+                REQUIRE(open_cube_mesh.stats().repaired_errors.facets_removed + open_cube_mesh.stats().open_edges > 0);
+            }
+        }
+        WHEN( "The closed sphere is loaded into TriangleMesh and indexed by admesh") {
+            TriangleMesh sphere_mesh;
+            REQUIRE(sphere_mesh.ReadSTLFile(sphere_path.string().c_str()));
+            stl_file stl;
+            REQUIRE(stl_open(&stl, sphere_path.string().c_str()));
+            stl_check_facets_exact(&stl);
+            indexed_triangle_set sphere_admesh;
+            stl_generate_shared_vertices(&stl, sphere_admesh);
+            THEN( "The vertices and faces are indexed in the same order") {
+                REQUIRE(sphere_mesh.its.vertices == sphere_admesh.vertices);
+                REQUIRE(sphere_mesh.its.indices == sphere_admesh.indices);
+            }
+        }
+        boost::nowide::remove(sphere_path.string().c_str());
+        boost::nowide::remove(open_cube_path.string().c_str());
+    }
+    GIVEN( "A triangle soup of a sphere") {
+        indexed_triangle_set sphere = its_make_sphere(10., PI / 60.);
+        indexed_triangle_set soup;
+        for (const stl_triangle_vertex_indices &face : sphere.indices) {
+            soup.indices.emplace_back(int(soup.vertices.size()), int(soup.vertices.size()) + 1, int(soup.vertices.size()) + 2);
+            for (int i = 0; i < 3; ++ i)
+                soup.vertices.emplace_back(sphere.vertices[face(i)]);
+        }
+        WHEN( "Vertices are merged sequentially and in parallel") {
+            indexed_triangle_set merged_seq = soup;
+            indexed_triangle_set merged_par = soup;
+            int num_merged_seq = its_merge_vertices(merged_seq);
+            int num_merged_par = its_merge_vertices_par(merged_par);
+            THEN( "The results are the same") {
+                REQUIRE(num_merged_seq == num_merged_par);
+                REQUIRE(merged_seq.vertices == merged_par.vertices);
+                REQUIRE(merged_seq.indices == merged_par.indices);
+            }
+        }
+    }
+}
+
 #ifdef TEST_PERFORMANCE
 TEST_CASE("Regression test for issue #4486 - files take forever to slice") {
     TriangleMesh mesh;
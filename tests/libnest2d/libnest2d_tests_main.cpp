@@ -645,6 +645,66 @@ TEST_CASE("PrusaPartsShouldFitIntoTwoBins", "[Nesting]") {
     }
 }
 
+TEST_CASE("RotatedCopiesOfPartsShouldNotOverlap", "[Nesting]") {
+
+    // Copies of the parts share the cached no-fit polygons, the rotations
+    // are evaluated in parallel.
+    std::vector<Item> input = prusaParts();
+    std::vector<Item> copies = prusaParts();
+    input.insert(input.end(), copies.begin(), copies.end());
+    auto bin = Box(250000000, 210000000);
+
+    NfpPlacer::Config pcfg;
+    pcfg.rotations = {0., Pi / 2., Pi, 3. * Pi / 2.};
+    pcfg.parallel = true;
+
+    size_t bins = libnest2d::nest(input, bin, 0, NestConfig<NfpPlacer, FirstFitSelection>(pcfg));
+
+    REQUIRE(bins > 0u);
+    REQUIRE(
+        std::all_of(input.begin(), input.end(), [](const Item &itm) {
+            return itm.binId() != BIN_ID_UNSET;
+        }));
+
+    using Pile = TMultiShape<PolygonImpl>;
+    std::vector<Pile> piles(bins);
+
+    for (auto &itm : input)
+        piles[size_t(itm.binId())].emplace_back(itm.transformedShape());
+
+    for (auto &pile : piles) {
+        REQUIRE(sl::isInside(sl::boundingBox(pile), bin));
+
+        double area_sum = 0.;
+        for (auto &obj : pile)
+            area_sum += sl::area(obj);
+
+        REQUIRE(area_sum == Approx(sl::area(nfp::merge(pile))));
+    }
+}
+
+TEST_CASE("ItemShapeEqualityIgnoresTranslationOnly", "[Nesting]") {
+
+    // The cached no-fit polygons are only reused for items, whose shapes
+    // compare equal, matching shape hashes are not enough.
+    Item item = {{0, 0}, {0, 10}, {10, 10}, {10, 0}, {0, 0}};
+    Item other = item;
+    other.translate({100, 50});
+    REQUIRE(item.isShapeEqual(other));
+    REQUIRE(item.shapeHash() == other.shapeHash());
+    REQUIRE(item.shapeKey().isShapeEqual(other));
+
+    other.rotation(Pi / 2.);
+    REQUIRE(! item.isShapeEqual(other));
+
+    other = item;
+    other.inflation(1);
+    REQUIRE(! item.isShapeEqual(other));
+
+    Item bigger = {{0, 0}, {0, 11}, {10, 11}, {10, 0}, {0, 0}};
+    REQUIRE(! item.isShapeEqual(bigger));
+}
+
 TEST_CASE("EmptyItemShouldBeUntouched", "[Nesting]") {
     auto bin = Box(250000000, 210000000); // dummy bin
 
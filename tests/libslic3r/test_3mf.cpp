@@ -80,6 +80,85 @@ SCENARIO("Export+Import geometry to/from 3mf file cycle", "[3mf]") {
     }
 }
 
+SCENARIO("Export+Import of large meshes to/from 3mf file cycle", "[3mf]") {
+    GIVEN("an object with two volumes, the first one large enough to be formatted in several batches of blocks") {
+        Model src_model;
+        ModelObject *src_object = src_model.add_object();
+        // About 260k vertices and 520k triangles, thus more than 32 blocks of 16k vertices or triangles.
+        src_object->add_volume(make_sphere(10., PI / 360.));
+        src_object->add_volume(make_sphere(5.))->set_offset({ 20., 0., 0. });
+        src_object->add_instance();
+
+        WHEN("model is saved+loaded to/from 3mf file") {
+            std::string test_file = std::string(TEST_DATA_DIR) + "/test_3mf/spheres.3mf";
+            store_3mf(test_file.c_str(), &src_model, nullptr, false);
+
+            Model dst_model;
+            DynamicPrintConfig dst_config;
+            {
+                ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+                load_3mf(test_file.c_str(), dst_config, ctxt, &dst_model, false);
+            }
+            boost::filesystem::remove(test_file);
+
+            THEN("the volumes are split back with their triangles") {
+                REQUIRE(dst_model.objects.size() == 1);
+                REQUIRE(dst_model.objects.front()->volumes.size() == 2);
+                for (size_t i = 0; i < 2; ++ i)
+                    REQUIRE(dst_model.objects.front()->volumes[i]->mesh().its.indices == src_object->volumes[i]->mesh().its.indices);
+            }
+            THEN("world vertices coordinates after load match") {
+                TriangleMesh src_mesh = src_model.mesh();
+                TriangleMesh dst_mesh = dst_model.mesh();
+                bool res = src_mesh.its.vertices.size() == dst_mesh.its.vertices.size();
+                for (size_t i = 0; res && i < dst_mesh.its.vertices.size(); ++ i)
+                    res = dst_mesh.its.vertices[i].isApprox(src_mesh.its.vertices[i]);
+                REQUIRE(res);
+            }
+        }
+    }
+}
+
+SCENARIO("Export+Import of meshes with long painting data to/from 3mf file cycle", "[3mf]") {
+    GIVEN("a volume with sparse triangles carrying long custom supports and seam strings") {
+        Model src_model;
+        ModelObject *src_object = src_model.add_object();
+        ModelVolume *src_volume = src_object->add_volume(make_sphere(5.));
+        src_object->add_instance();
+        // The painting strings make the formatted triangles far longer than the plain ones,
+        // thus the blocks and batches are split by their size, not by the number of triangles.
+        const std::string supports_string(8192, '9');
+        const std::string seam_string(4096, 'A');
+        for (int i = 0; i < int(src_volume->mesh().its.indices.size()); i += 64)
+            src_volume->supported_facets.set_triangle_from_string(i, supports_string);
+        for (int i = 32; i < int(src_volume->mesh().its.indices.size()); i += 128)
+            src_volume->seam_facets.set_triangle_from_string(i, seam_string);
+
+        WHEN("model is saved+loaded to/from 3mf file") {
+            std::string test_file = std::string(TEST_DATA_DIR) + "/test_3mf/painted.3mf";
+            store_3mf(test_file.c_str(), &src_model, nullptr, false);
+
+            Model dst_model;
+            DynamicPrintConfig dst_config;
+            {
+                ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+                load_3mf(test_file.c_str(), dst_config, ctxt, &dst_model, false);
+            }
+            boost::filesystem::remove(test_file);
+
+            THEN("the triangles and their painting data match") {
+                REQUIRE(dst_model.objects.size() == 1);
+                REQUIRE(dst_model.objects.front()->volumes.size() == 1);
+                const ModelVolume &dst_volume = *dst_model.objects.front()->volumes.front();
+                REQUIRE(dst_volume.mesh().its.indices == src_volume->mesh().its.indices);
+                REQUIRE(dst_volume.supported_facets.get_data() == src_volume->supported_facets.get_data());
+                REQUIRE(dst_volume.seam_facets.get_data() == src_volume->seam_facets.get_data());
+                REQUIRE(dst_volume.mmu_segmentation_facets.empty());
+            }
+        }
+    }
+}
+
 SCENARIO("2D convex hull of sinking object", "[3mf]") {
     GIVEN("model") {
         // load a model
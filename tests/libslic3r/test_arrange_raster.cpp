@@ -0,0 +1,107 @@
+#include <catch2/catch.hpp>
+#include "libslic3r/libslic3r.h"
+
+#include "libslic3r/Arrange.hpp"
+#include "libslic3r/ClipperUtils.hpp"
+
+using namespace Slic3r;
+
+static arrangement::ArrangeParams raster_params(double min_obj_distance)
+{
+    arrangement::ArrangeParams params(scaled(min_obj_distance));
+    params.engine = arrangement::ArrangeEngine::Raster;
+    return params;
+}
+
+static arrangement::ArrangePolygons arrange_polygons(const ExPolygon &poly, size_t count)
+{
+    arrangement::ArrangePolygon ap;
+    ap.poly = poly;
+    return arrangement::ArrangePolygons(count, ap);
+}
+
+// Sum of the areas of the arranged items on a bed equals the area of their union if they do not overlap.
+static void check_no_overlaps(const arrangement::ArrangePolygons &items, int bed_idx, double min_obj_distance)
+{
+    Polygons polys;
+    double   sum_area = 0.;
+    for (const arrangement::ArrangePolygon &item : items)
+        if (item.bed_idx == bed_idx) {
+            // Inflated by less than a half of the minimum distance, thus not touching.
+            ExPolygons inflated = offset_ex(item.transformed_poly(), float(scaled(0.45 * min_obj_distance)));
+            REQUIRE(inflated.size() == 1);
+            sum_area += inflated.front().area();
+            polys.emplace_back(inflated.front().contour);
+        }
+    double union_area = 0.;
+    for (const ExPolygon &expoly : union_ex(polys))
+        union_area += expoly.area();
+    REQUIRE(union_area == Approx(sum_area).epsilon(1e-6));
+}
+
+static void check_inside(const arrangement::ArrangePolygons &items, const BoundingBox &bed)
+{
+    for (const arrangement::ArrangePolygon &item : items)
+        if (item.bed_idx != arrangement::UNARRANGED)
+            REQUIRE(bed.contains(get_extents(item.transformed_poly())));
+}
+
+SCENARIO("Raster arrange of identical parts", "[Arrange]") {
+    const BoundingBox bed(Point::new_scale(0., 0.), Point::new_scale(250., 210.));
+    const ExPolygon   square(Polygon::new_scale({ { 0., 0. }, { 10., 0. }, { 10., 10. }, { 0., 10. } }));
+
+    GIVEN("Parts filling less than a bed") {
+        arrangement::ArrangePolygons items = arrange_polygons(square, 100);
+        arrangement::arrange(items, bed, raster_params(2.));
+        THEN("All parts are placed onto the physical bed without overlaps") {
+            for (const arrangement::ArrangePolygon &item : items)
+                REQUIRE(item.bed_idx == 0);
+            check_inside(items, bed);
+            check_no_overlaps(items, 0, 2.);
+        }
+    }
+
+    GIVEN("Parts filling more than a bed") {
+        arrangement::ArrangePolygons items = arrange_polygons(square, 1000);
+        arrangement::arrange(items, bed, raster_params(2.));
+        THEN("The physical bed is full and the rest goes to the next logical beds") {
+            // 20 x 17 squares of 12mm with the spacing fit the bed, some cells are lost to the rounding.
+            size_t on_first_bed = std::count_if(items.begin(), items.end(), [](const auto &item) { return item.bed_idx == 0; });
+            REQUIRE(on_first_bed >= 18 * 16);
+            for (const arrangement::ArrangePolygon &item : items)
+                REQUIRE(item.bed_idx >= 0);
+            check_inside(items, bed);
+            check_no_overlaps(items, 0, 2.);
+            check_no_overlaps(items, 1, 2.);
+        }
+    }
+
+    GIVEN("A part larger than the bed") {
+        arrangement::ArrangePolygons items = arrange_polygons(square, 1);
+        items.front().poly.scale(30.);
+        arrangement::arrange(items, bed, raster_params(2.));
+        THEN("The part is not arranged") {
+            REQUIRE(items.front().bed_idx == arrangement::UNARRANGED);
+        }
+    }
+}
+
+SCENARIO("Raster arrange around fixed parts", "[Arrange]") {
+    const BoundingBox bed(Point::new_scale(0., 0.), Point::new_scale(100., 100.));
+    const ExPolygon   triangle(Polygon::new_scale({ { 0., 0. }, { 15., 0. }, { 0., 12. } }));
+
+    GIVEN("A fixed part in the middle of the bed") {
+        arrangement::ArrangePolygons excludes = arrange_polygons(ExPolygon(Polygon::new_scale({ { 30., 30. }, { 70., 30. }, { 70., 70. }, { 30., 70. } })), 1);
+        excludes.front().bed_idx = 0;
+        arrangement::ArrangePolygons items = arrange_polygons(triangle, 40);
+        arrangement::ArrangeParams   params = raster_params(1.);
+        params.allow_rotations = true;
+        arrangement::arrange(items, excludes, bed, params);
+        THEN("The parts do not overlap the fixed part nor each other") {
+            arrangement::ArrangePolygons all = items;
+            all.insert(all.end(), excludes.begin(), excludes.end());
+            check_inside(items, bed);
+            check_no_overlaps(all, 0, 1.);
+        }
+    }
+}
@@ -382,3 +382,37 @@ TEST_CASE("Traversing Clipper PolyTree", "[ClipperUtils]") {
         REQUIRE(count_polys(output) == reference.size());
     }
 }
+
+TEST_CASE("ClipperUtils::Batch produces the same results as the sequential calls", "[ClipperUtils]") {
+    ExPolygon square_with_hole;
+    square_with_hole.contour = Polygon::new_scale({ { 0., 0. }, { 20., 0. }, { 20., 20. }, { 0., 20. } });
+    square_with_hole.holes.emplace_back(Polygon::new_scale({ { 5., 5. }, { 5., 15. }, { 15., 15. }, { 15., 5. } }));
+    const Polygons triangles { Polygon::new_scale({ { 10., -5. }, { 30., 10. }, { 10., 25. } }), Polygon::new_scale({ { -5., 8. }, { 12., 10. }, { -5., 12. } }) };
+    const Polygons squares = to_polygons(square_with_hole);
+    const float    delta   = scaled<float>(0.7);
+
+    const Polygons   expanded  = offset(squares, delta);
+    const Polygons   shrunk    = offset(squares, - delta);
+    const Polygons   overhangs = diff(triangles, squares);
+    const ExPolygons anchors   = intersection_ex(triangles, squares);
+    const ExPolygons opened    = opening_ex(ExPolygons{ square_with_hole }, delta);
+
+    ClipperUtils::Batch batch;
+    auto expanded_result  = batch.queue([&]() { return offset(squares, delta); });
+    auto shrunk_result    = batch.queue([&]() { return offset(squares, - delta); });
+    auto overhangs_result = batch.queue([&]() { return diff(triangles, squares); });
+    auto anchors_result   = batch.queue([&]() { return intersection_ex(triangles, squares); });
+    batch.execute();
+    // A single operation is executed on the calling thread, the results of the previous execute() are kept.
+    auto opened_result    = batch.queue([&]() { return opening_ex(ExPolygons{ square_with_hole }, delta); });
+    batch.execute();
+
+    REQUIRE(! expanded.empty());
+    REQUIRE(! overhangs.empty());
+    REQUIRE(! anchors.empty());
+    REQUIRE(batch.take(expanded_result) == expanded);
+    REQUIRE(batch.take(shrunk_result) == shrunk);
+    REQUIRE(batch.take(overhangs_result) == overhangs);
+    REQUIRE(batch.take(anchors_result) == anchors);
+    REQUIRE(batch.take(opened_result) == opened);
+}
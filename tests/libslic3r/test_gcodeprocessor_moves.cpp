@@ -0,0 +1,68 @@
+#include <catch2/catch.hpp>
+#include "libslic3r/libslic3r.h"
+
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+
+using namespace Slic3r;
+
+static GCodeProcessorResult::MoveVertex test_move(size_t i, size_t distinct_widths)
+{
+    GCodeProcessorResult::MoveVertex move;
+    move.gcode_id       = (unsigned int)(2 * i);
+    move.type           = (i % 3 == 0) ? EMoveType::Travel : EMoveType::Extrude;
+    move.extrusion_role = (i % 3 == 0) ? GCodeExtrusionRole::None : GCodeExtrusionRole::Perimeter;
+    move.extruder_id    = (unsigned char)(i % 2);
+    move.position       = Vec3f(float(i), 0.5f * float(i), 0.2f);
+    move.delta_extruder = 0.01f * float(i);
+    move.feedrate       = (i % 3 == 0) ? 150.f : 45.f;
+    move.width          = 0.45f + 0.0001f * float(i % distinct_widths);
+    move.height         = 0.2f;
+    move.mm3_per_mm     = 0.05f;
+    move.fan_speed      = 100.f;
+    move.temperature    = 215.f;
+    move.time           = float(i);
+    return move;
+}
+
+static bool moves_equal(const GCodeProcessorResult::MoveVertex &lhs, const GCodeProcessorResult::MoveVertex &rhs)
+{
+    return lhs.gcode_id == rhs.gcode_id && lhs.type == rhs.type && lhs.extrusion_role == rhs.extrusion_role && lhs.extruder_id == rhs.extruder_id &&
+           lhs.cp_color_id == rhs.cp_color_id && lhs.position == rhs.position && lhs.delta_extruder == rhs.delta_extruder && lhs.feedrate == rhs.feedrate &&
+           lhs.width == rhs.width && lhs.height == rhs.height && lhs.mm3_per_mm == rhs.mm3_per_mm && lhs.fan_speed == rhs.fan_speed &&
+           lhs.temperature == rhs.temperature && lhs.time == rhs.time && lhs.internal_only == rhs.internal_only;
+}
+
+SCENARIO("GCodeProcessorResult::Moves stores the moves exactly", "[GCodeProcessor]") {
+    for (size_t distinct_widths : { size_t(10), size_t(100000) }) {
+        GIVEN(std::to_string(distinct_widths) + " distinct widths") {
+            const size_t num_moves = 150000;
+            GCodeProcessorResult::Moves moves;
+            for (size_t i = 0; i < num_moves; ++ i)
+                moves.push_back(test_move(i, distinct_widths));
+            WHEN("the moves are read back") {
+                bool all_equal = moves.size() == num_moves;
+                for (size_t i = 0; all_equal && i < num_moves; ++ i)
+                    all_equal = moves_equal(moves[i], test_move(i, distinct_widths)) && moves.width(i) == test_move(i, distinct_widths).width;
+                THEN("they match the stored moves") {
+                    REQUIRE(all_equal);
+                }
+            }
+            WHEN("a move is erased and a width is changed") {
+                moves.erase(1);
+                moves.set_width(2, 0.123f);
+                THEN("the following moves are shifted") {
+                    REQUIRE(moves.size() == num_moves - 1);
+                    REQUIRE(moves_equal(moves[1], test_move(2, distinct_widths)));
+                    REQUIRE(moves.width(2) == 0.123f);
+                    REQUIRE(moves.position(2) == test_move(3, distinct_widths).position);
+                }
+            }
+            WHEN("the moves are compacted") {
+                moves.shrink_to_fit();
+                THEN("the columns take less memory than an array of MoveVertex") {
+                    REQUIRE(moves.memory_size() < num_moves * sizeof(GCodeProcessorResult::MoveVertex));
+                }
+            }
+        }
+    }
+}
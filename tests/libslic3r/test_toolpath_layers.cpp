@@ -0,0 +1,199 @@
+#include <catch2/catch.hpp>
+#include "libslic3r/libslic3r.h"
+
+#include "libslic3r/GCode/ToolpathLayers.hpp"
+
+using namespace Slic3r;
+
+static GCodeProcessorResult::MoveVertex test_move(EMoveType type, const Vec3f &position)
+{
+    GCodeProcessorResult::MoveVertex move;
+    move.type           = type;
+    move.extrusion_role = type == EMoveType::Extrude ? GCodeExtrusionRole::Perimeter : GCodeExtrusionRole::None;
+    move.position       = position;
+    move.feedrate       = type == EMoveType::Extrude ? 45.f : 150.f;
+    move.width          = 0.45f;
+    move.height         = 0.2f;
+    move.mm3_per_mm     = 0.05f;
+    return move;
+}
+
+SCENARIO("Toolpath layers", "[GCodeProcessor]") {
+    GIVEN("Two layers of extrusions separated by a seam and travels") {
+        GCodeProcessorResult result;
+        GCodeProcessorResult::Moves &moves = result.moves;
+        moves.push_back(test_move(EMoveType::Noop,    Vec3f(0.f, 0.f, 0.f)));   // 0
+        moves.push_back(test_move(EMoveType::Travel,  Vec3f(0.f, 0.f, 0.2f)));  // 1
+        moves.push_back(test_move(EMoveType::Extrude, Vec3f(10.f, 0.f, 0.2f))); // 2
+        moves.push_back(test_move(EMoveType::Extrude, Vec3f(10.f, 10.f, 0.2f)));// 3
+        moves.push_back(test_move(EMoveType::Seam,    Vec3f(10.f, 10.f, 0.2f)));// 4
+        moves.push_back(test_move(EMoveType::Travel,  Vec3f(0.f, 0.f, 0.4f)));  // 5
+        moves.push_back(test_move(EMoveType::Extrude, Vec3f(10.f, 0.f, 0.4f))); // 6
+        moves.push_back(test_move(EMoveType::Extrude, Vec3f(10.f, 10.f, 0.4f)));// 7
+        WHEN("the layers are extracted") {
+            ToolpathLayers layers = toolpath_layers(result);
+            THEN("there are two layers with their zs") {
+                REQUIRE(layers.size() == 2);
+                REQUIRE(layers.zs[0] == Approx(0.2));
+                REQUIRE(layers.zs[1] == Approx(0.4));
+            }
+            THEN("the layers share the travel moves between them, the seam is not counted by the viewer ranges") {
+                REQUIRE(layers.moves_ranges[0] == ToolpathLayers::Range{ 1, 5 });
+                REQUIRE(layers.moves_ranges[1] == ToolpathLayers::Range{ 5, 7 });
+                REQUIRE(layers.ranges[0] == ToolpathLayers::Range{ 1, 4 });
+                REQUIRE(layers.ranges[1] == ToolpathLayers::Range{ 4, 6 });
+            }
+        }
+        WHEN("spiral vase layers are set") {
+            result.spiral_vase_layers = { { 0.2f, { 1, 7 } } };
+            ToolpathLayers layers = toolpath_layers(result);
+            THEN("they replace the layers") {
+                REQUIRE(layers.size() == 1);
+                REQUIRE(layers.ranges[0] == ToolpathLayers::Range{ 1, 7 });
+            }
+        }
+    }
+}
+
+SCENARIO("Toolpath decimation", "[GCodeProcessor]") {
+    GIVEN("A nearly straight extrusion split into 100 moves followed by a corner") {
+        GCodeProcessorResult::Moves moves;
+        moves.push_back(test_move(EMoveType::Travel, Vec3f(0.f, 0.f, 0.2f)));
+        for (size_t i = 1; i <= 100; ++ i)
+            moves.push_back(test_move(EMoveType::Extrude, Vec3f(float(i), (i % 2) ? 0.001f : 0.f, 0.2f)));
+        moves.push_back(test_move(EMoveType::Extrude, Vec3f(100.f, 50.f, 0.2f)));
+        WHEN("decimated with 0.01mm tolerance") {
+            std::vector<size_t> kept = decimate_toolpaths(moves, 0, moves.size() - 1, 0.01f);
+            THEN("the first move, the corner and the last move are kept") {
+                REQUIRE(kept.front() == 0);
+                REQUIRE(kept.back() == moves.size() - 1);
+                REQUIRE(std::find(kept.begin(), kept.end(), 100) != kept.end());
+            }
+            THEN("most of the straight moves are dropped") {
+                REQUIRE(kept.size() < 10);
+            }
+        }
+        WHEN("decimated with a tolerance below the wiggle") {
+            std::vector<size_t> kept = decimate_toolpaths(moves, 0, moves.size() - 1, 0.0001f);
+            THEN("all the moves are kept") {
+                REQUIRE(kept.size() == moves.size());
+            }
+        }
+        WHEN("the width of a move changes") {
+            moves.set_width(50, 0.5f);
+            std::vector<size_t> kept = decimate_toolpaths(moves, 0, moves.size() - 1, 0.01f);
+            THEN("the moves around the change are kept") {
+                REQUIRE(std::find(kept.begin(), kept.end(), 49) != kept.end());
+                REQUIRE(std::find(kept.begin(), kept.end(), 50) != kept.end());
+            }
+        }
+    }
+}
+
+SCENARIO("Toolpath levels of detail", "[GCodeProcessor]") {
+    THEN("the tolerance grows with the level of detail") {
+        REQUIRE(toolpath_lod_tolerance(0) == 0.f);
+        for (unsigned int lod = 1; lod <= TOOLPATH_LOD_MAX; ++ lod)
+            REQUIRE(toolpath_lod_tolerance(lod) > toolpath_lod_tolerance(lod - 1));
+    }
+    THEN("the level of detail is chosen by the pixel size") {
+        REQUIRE(toolpath_lod(0.001f) == 0);
+        REQUIRE(toolpath_lod(toolpath_lod_tolerance(2)) == 2);
+        REQUIRE(toolpath_lod(100.f) == TOOLPATH_LOD_MAX);
+    }
+}
+
+SCENARIO("Toolpath layer ranges built on demand", "[GCodeProcessor]") {
+    GIVEN("Ten layers of wiggled straight extrusions") {
+        GCodeProcessorResult result;
+        GCodeProcessorResult::Moves &moves = result.moves;
+        moves.push_back(test_move(EMoveType::Noop, Vec3f(0.f, 0.f, 0.f)));
+        for (size_t layer = 0; layer < 10; ++ layer) {
+            const float z = 0.2f * float(layer + 1);
+            moves.push_back(test_move(EMoveType::Travel, Vec3f(0.f, 0.f, z)));
+            for (size_t i = 1; i <= 100; ++ i)
+                moves.push_back(test_move(EMoveType::Extrude, Vec3f(float(i), (i % 2) ? 0.001f : 0.f, z)));
+            moves.push_back(test_move(EMoveType::Retract, Vec3f(100.f, 0.f, z)));
+        }
+        ToolpathRangeBuilder builder(result, 1024 * 1024);
+        REQUIRE(builder.layers().size() == 10);
+        WHEN("a range of layers is built at full detail") {
+            const ToolpathRangeData &data = builder.get(2, 4, 0);
+            THEN("each extrusion and travel of the range is drawn by a segment ending at its position") {
+                const ToolpathLayers::Range &first = builder.layers().moves_ranges[2];
+                const ToolpathLayers::Range &last  = builder.layers().moves_ranges[4];
+                size_t num_segments = 0;
+                for (size_t id = first.first + 1; id <= last.last; ++ id)
+                    if (moves.type(id) == EMoveType::Extrude || moves.type(id) == EMoveType::Travel)
+                        ++ num_segments;
+                REQUIRE(data.num_segments() == num_segments);
+                REQUIRE(data.positions.size() == 2 * num_segments);
+                for (size_t i = 0; i < data.num_segments(); ++ i)
+                    REQUIRE(data.positions[2 * i + 1] == moves.position(data.move_ids[i]));
+            }
+        }
+        WHEN("the same range is requested again") {
+            const ToolpathRangeData *data = &builder.get(2, 4, 0);
+            THEN("it is served from the cache") {
+                REQUIRE(&builder.get(2, 4, 0) == data);
+                REQUIRE(builder.num_built() == 1);
+            }
+        }
+        WHEN("the range is built at a coarse level of detail") {
+            const size_t num_full   = builder.get(0, 9, 0).num_segments();
+            const size_t num_coarse = builder.get(0, 9, 2).num_segments();
+            THEN("the levels are cached separately and the coarse one has much less segments") {
+                REQUIRE(builder.num_built() == 2);
+                REQUIRE(num_coarse * 10 < num_full);
+            }
+        }
+    }
+    GIVEN("A builder with a small memory limit") {
+        GCodeProcessorResult result;
+        result.moves.push_back(test_move(EMoveType::Noop, Vec3f(0.f, 0.f, 0.f)));
+        for (size_t layer = 0; layer < 4; ++ layer) {
+            const float z = 0.2f * float(layer + 1);
+            result.moves.push_back(test_move(EMoveType::Travel, Vec3f(0.f, 0.f, z)));
+            for (size_t i = 1; i <= 100; ++ i)
+                result.moves.push_back(test_move(EMoveType::Extrude, Vec3f(float(i), float(i % 7), z)));
+        }
+        const size_t layer_size = build_toolpath_range(result.moves, toolpath_layers(result), 1, 1, 0).memory_size();
+        ToolpathRangeBuilder builder(result, 2 * layer_size + layer_size / 2);
+        WHEN("more layers are shown than fit into the limit") {
+            builder.get(1, 1, 0);
+            builder.get(2, 2, 0);
+            builder.get(1, 1, 0);
+            builder.get(3, 3, 0);
+            builder.get(1, 1, 0);
+            builder.get(2, 2, 0);
+            THEN("the least recently shown layer was evicted and built again") {
+                REQUIRE(builder.num_built() == 4);
+                REQUIRE(builder.cache_size() <= 2 * layer_size + layer_size / 2);
+            }
+        }
+    }
+}
+
+SCENARIO("LayerRangeCache", "[GCodeProcessor]") {
+    GIVEN("A cache of vectors limited to 10 elements") {
+        LayerRangeCache<ToolpathLayers::Range, std::vector<int>> cache(10, [](const std::vector<int> &data) { return data.size(); });
+        size_t num_built = 0;
+        auto build = [&num_built](const ToolpathLayers::Range &range) { ++ num_built; return std::vector<int>(range.last - range.first + 1, int(range.first)); };
+        WHEN("ranges are requested repeatedly") {
+            cache.get({ 0, 3 }, build);
+            cache.get({ 4, 7 }, build);
+            cache.get({ 0, 3 }, build);
+            THEN("cached data are reused") {
+                REQUIRE(num_built == 2);
+                REQUIRE(cache.data_size() == 8);
+            }
+            cache.get({ 8, 11 }, build);
+            THEN("the least recently used data are evicted") {
+                REQUIRE(num_built == 3);
+                REQUIRE(cache.contains({ 0, 3 }));
+                REQUIRE(! cache.contains({ 4, 7 }));
+                REQUIRE(cache.data_size() == 8);
+            }
+        }
+    }
+}
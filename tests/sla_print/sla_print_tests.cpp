@@ -252,6 +252,52 @@ TEST_CASE("RasterizedPolygonAreaShouldMatch", "[SLARasterOutput]") {
 }
 
 
+TEST_CASE("BinaryRasterShouldMatchThresholdedAA", "[SLARasterOutput]") {
+    double disp_w = 120., disp_h = 68.;
+    sla::Resolution res{2560, 1440};
+    sla::PixelDim pixdim{disp_w / res.width_px, disp_h / res.height_px};
+    auto bb = BoundingBox({0, 0}, {scaled(disp_w), scaled(disp_h)});
+
+    // Polygons with edges at general angles, the circle partially outside of the display.
+    ExPolygons polys;
+    polys.emplace_back(square_with_hole(30.));
+    polys.back().rotate(0.3);
+    Polygon circle;
+    for (double a = 0.; a < 2. * PI; a += 2. * PI / 97.)
+        circle.points.emplace_back(scaled(30. + 20. * std::cos(a)), scaled(-15. + 20. * std::sin(a)));
+    polys.emplace_back(circle);
+
+    sla::RasterBase::Orientation orientations[] =
+        {sla::RasterBase::roLandscape, sla::RasterBase::roPortrait};
+    sla::RasterBase::TMirroring mirrorings[] = {sla::RasterBase::NoMirror,
+                                                sla::RasterBase::MirrorXY};
+
+    for (auto orientation : orientations)
+        for (auto &mirror : mirrorings) {
+            sla::RasterBase::Trafo trafo(orientation, mirror);
+            trafo.center_x = bb.center().x();
+            trafo.center_y = bb.center().y();
+
+            sla::RasterGrayscaleAA     raster_aa(res, pixdim, trafo, agg::gamma_threshold(.5));
+            sla::RasterGrayscaleBinary raster_bin(res, pixdim, trafo);
+            for (const ExPolygon &poly : polys) {
+                raster_aa.draw(poly);
+                raster_bin.draw(poly);
+            }
+
+            size_t differ = 0, white = 0;
+            for (size_t row = 0; row < res.height_px; ++row)
+                for (size_t col = 0; col < res.width_px; ++col) {
+                    uint8_t px = raster_bin.read_pixel(col, row);
+                    differ += px != raster_aa.read_pixel(col, row);
+                    white  += px == 255;
+                }
+
+            REQUIRE(white > 0);
+            REQUIRE(differ == 0);
+        }
+}
+
 TEST_CASE("halfcone test", "[halfcone]") {
     sla::DiffBridge br{Vec3d{1., 1., 1.}, Vec3d{10., 10., 10.}, 0.25, 0.5};
 